@@ -0,0 +1,41 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Stand-in for the InDesign SDK header of the same name.
+#include "VCPlugInHeaders.h"
+#include "textiterator.h"
+
+class IDrawingStyle;
+
+class IComposeScanner : public IPMUnknown
+{
+public:
+	// Returns an iterator at position, the drawing style in effect there and 
+	// the number of characters that style covers from position.
+	virtual TextIterator	QueryDataAt(TextIndex position, IDrawingStyle ** style, int32 * num_chars) = 0;
+	virtual IDrawingStyle *	GetCompleteStyleAt(TextIndex position, int32 * num_chars = nil) = 0;
+	virtual IDrawingStyle *	GetParagraphStyleAt(TextIndex position, int32 * num_chars = nil) = 0;
+};
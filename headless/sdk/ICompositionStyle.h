@@ -0,0 +1,48 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Stand-in for the InDesign SDK header of the same name.
+#include "VCPlugInHeaders.h"
+#include "TabStop.h"
+
+class ICompositionStyle : public IPMUnknown
+{
+public:
+	enum TextAlignment 
+	{
+		kTextAlignLeft, kTextAlignCenter, kTextAlignRight, 
+		kTextAlignJustifyLeft, kTextAlignJustifyCenter, kTextAlignJustifyRight, kTextAlignJustifyFull,
+		kTextAlignToBinding, kTextAlignAwayBinding
+	};
+
+	virtual TextAlignment	GetParagraphAlignment() const = 0;
+	virtual bool16			GetNoBreak() const = 0;
+	virtual TabStop			GetTabStopAfter(const PMReal & position) const = 0;
+	virtual void			GetDropCapInfo(int16 * chars, int16 * lines) const = 0;
+	virtual PMReal			IndentLeftBody() const = 0;
+	virtual PMReal			IndentLeftFirst() const = 0;
+	virtual PMReal			IndentRightBody() const = 0;
+};
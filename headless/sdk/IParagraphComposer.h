@@ -0,0 +1,80 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Stand-in for the InDesign SDK header of the same name.
+#include "VCPlugInHeaders.h"
+#include "ITextParcelList.h"
+#include "K2Vector.h"
+
+class IComposeScanner;
+class IWaxLine;
+
+class IParagraphComposer : public IPMUnknown
+{
+public:
+	// Host services available while composing lines.
+	class RecomposeHelper
+	{
+	public:
+		virtual ~RecomposeHelper() {}
+
+		virtual IComposeScanner	  *	GetComposeScanner() const = 0;
+		virtual ITextParcelList	  *	GetTextParcelList() const = 0;
+		virtual IDataBase		  *	GetDataBase() const = 0;
+		virtual TextIndex			GetParagraphStart() const = 0;
+		virtual TextIndex			GetParagraphEnd() const = 0;
+		virtual TextIndex			GetStartingTextIndex() const = 0;
+		virtual ParcelKey			GetStartingParcelKey() const = 0;
+		virtual PMReal				GetStartingYPosition() const = 0;
+		virtual const IWaxLine	  *	GetPreviousWaxLine() const = 0;
+
+		virtual bool16	GetTiles(const PMReal & min_width, const PMReal & height, const PMReal & TOF_height,
+								 Text::GridAlignmentMetric grid_metric, const PMReal & grid_offset,
+								 Text::LeadingModel leading_model, const PMReal & leading_model_height,
+								 const PMReal & leading_model_offset, const PMReal & descent,
+								 TextIndex position, bool16 affected_by_vertical_justification,
+								 ParcelKey * parcel, PMReal * y_position, Text::FirstLineOffsetMetric * TOF_metric,
+								 PMRectCollection & tiles, bool16 * at_TOF, bool16 * parcel_position_dependent,
+								 PMReal * left_margin, PMReal * right_margin) = 0;
+
+		virtual IWaxLine  *	QueryNewWaxLine() = 0;
+		virtual void		ApplyComposedLine(IWaxLine * line, int32 span) = 0;
+	};
+
+	// Host services available while rebuilding a composed line.
+	class RebuildHelper
+	{
+	public:
+		virtual ~RebuildHelper() {}
+
+		virtual IComposeScanner	  *	GetComposeScanner() const = 0;
+		virtual IDataBase		  *	GetDataBase() const = 0;
+		virtual UID					GetParcelFrameUID() const = 0;
+		virtual TextIndex			GetParagraphStart() const = 0;
+		virtual TextIndex			GetTextIndex() const = 0;
+		virtual const IWaxLine	  *	GetWaxLine() const = 0;
+	};
+};
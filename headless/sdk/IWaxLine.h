@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Stand-in for the InDesign SDK header of the same name.
+#include "VCPlugInHeaders.h"
+#include "ITextParcelList.h"
+
+class IWaxLine : public IPMUnknown
+{
+public:
+	// Tiles
+	virtual int32	GetNumberOfTiles() const = 0;
+	virtual void	SetNumberOfTiles(int32 n) = 0;
+	virtual void	SetNoShuffle(bool16 no_shuffle) = 0;
+	virtual int32	GetTextSpanInTile(int32 tile) const = 0;
+	virtual void	SetTextSpanInTile(int32 span, int32 tile) = 0;
+	virtual PMReal	GetXPosition(int32 tile = 0) const = 0;
+	virtual void	SetXPosition(const PMReal & x, int32 tile) = 0;
+	virtual PMReal	GetTargetWidth(int32 tile) const = 0;
+	virtual void	SetTargetWidth(const PMReal & w, int32 tile) = 0;
+
+	// Drop caps
+	virtual int32	GetDropCapIndents(PMReal * indents = nil, int32 * lines = nil) const = 0;
+	virtual void	SetDropCapIndents(int32 n, const PMReal * indents, const int32 * lines) = 0;
+	virtual bool16	GetNextLineAffectedByDropcap() const = 0;
+
+	// Vertical metrics
+	virtual PMReal	GetYPosition() const = 0;
+	virtual PMReal	GetYAdvance() const = 0;
+	virtual void	SetCompositionYPosition(const PMReal & y) = 0;
+	virtual void	SetLineHeight(const PMReal & h) = 0;
+	virtual void	SetTOFLineHeight(const PMReal & h, Text::FirstLineOffsetMetric metric) = 0;
+	virtual void	SetLeadingModel(Text::LeadingModel model) = 0;
+	virtual void	SetGridAlignment(Text::GridAlignmentMetric metric, const PMReal & offset) = 0;
+
+	// Parcel
+	virtual void	SetParcelKey(const ParcelKey & key) = 0;
+	virtual void	SetAtTOF(bool16 at_top) = 0;
+	virtual void	SetParcelPositionDependent(bool16 dependent) = 0;
+};
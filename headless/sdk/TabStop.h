@@ -0,0 +1,49 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Stand-in for the InDesign SDK header of the same name.
+#include "VCPlugInHeaders.h"
+
+class TabStop
+{
+public:
+	enum TabAlignment	{ kTabAlignLeft, kTabAlignCenter, kTabAlignRight, kTabAlignChar };
+
+private:
+	PMReal			_position;
+	TabAlignment	_alignment;
+	UTF32TextChar	_align_to;
+
+public:
+	TabStop(const PMReal & pos = 0, TabAlignment a = kTabAlignLeft, UTF32TextChar c = UTF32TextChar(kTextChar_Period))
+	: _position(pos), _alignment(a), _align_to(c) {}
+
+	PMReal			GetPosition() const					{ return _position; }
+	void			SetPosition(const PMReal & pos)		{ _position = pos; }
+	TabAlignment	GetAlignment() const				{ return _alignment; }
+	void			SetAlignment(TabAlignment a)		{ _alignment = a; }
+	UTF32TextChar	GetAlignToChar() const				{ return _align_to; }
+};
@@ -0,0 +1,355 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+/* Stand-in for the InDesign SDK precompiled header.
+This and the other headers in this directory declare just the subset of the 
+InDesign SDK the layout engine uses, with the same names and signatures, so 
+the engine can be built outside InDesign. Interfaces are plain abstract 
+classes that a host implements; see the standin namespace for a plain C++ 
+host.
+*/
+
+// Language headers
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <vector>
+// Interface headers
+// Library headers
+// Module header
+
+#ifndef nil
+#define nil	0
+#endif
+
+typedef int				int32;
+typedef short			int16;
+typedef unsigned int	uint32;
+typedef unsigned short	uint16;
+typedef short			bool16;
+typedef unsigned char	uchar;
+
+const bool16	kTrue = 1,
+				kFalse = 0;
+
+typedef int32			TextIndex;
+typedef uint16			textchar;
+typedef uint16			UTF16TextChar;
+typedef int32			ClassID;
+typedef int32			PMIID;
+typedef uint32			UID;
+
+const UID		kInvalidUID = 0;
+const ClassID	kInvalidClass = 0,
+				kWaxTextRunBoss = 1,
+				kOwnedItemStrandBoss = 2,
+				kInlineBoss = 3;
+const PMIID		IID_IWAXRUN = 1,
+				IID_IITEMSTRAND = 2;
+
+
+// Geometry
+class PMReal
+{
+	double	_value;
+
+public:
+	PMReal() : _value(0) {}
+	PMReal(double v) : _value(v) {}
+
+	double	value() const		{ return _value; }
+
+	PMReal & operator += (const PMReal & r)	{ _value += r._value; return *this; }
+	PMReal & operator -= (const PMReal & r)	{ _value -= r._value; return *this; }
+	PMReal & operator *= (const PMReal & r)	{ _value *= r._value; return *this; }
+	PMReal & operator /= (const PMReal & r)	{ _value /= r._value; return *this; }
+	PMReal	 operator - () const			{ return PMReal(-_value); }
+
+	friend PMReal operator + (const PMReal & a, const PMReal & b)	{ return a._value + b._value; }
+	friend PMReal operator - (const PMReal & a, const PMReal & b)	{ return a._value - b._value; }
+	friend PMReal operator * (const PMReal & a, const PMReal & b)	{ return a._value * b._value; }
+	friend PMReal operator / (const PMReal & a, const PMReal & b)	{ return a._value / b._value; }
+	friend bool operator <  (const PMReal & a, const PMReal & b)	{ return a._value <  b._value; }
+	friend bool operator >  (const PMReal & a, const PMReal & b)	{ return a._value >  b._value; }
+	friend bool operator <= (const PMReal & a, const PMReal & b)	{ return a._value <= b._value; }
+	friend bool operator >= (const PMReal & a, const PMReal & b)	{ return a._value >= b._value; }
+	friend bool operator == (const PMReal & a, const PMReal & b)	{ return a._value == b._value; }
+	friend bool operator != (const PMReal & a, const PMReal & b)	{ return a._value != b._value; }
+};
+
+inline float	ToFloat(const PMReal & r)	{ return static_cast<float>(r.value()); }
+inline double	ToDouble(const PMReal & r)	{ return r.value(); }
+inline int32	ToInt32(const PMReal & r)	{ return static_cast<int32>(r.value()); }
+
+
+class PMPoint
+{
+	PMReal	_x, _y;
+
+public:
+	PMPoint(const PMReal & x = 0, const PMReal & y = 0) : _x(x), _y(y) {}
+
+	PMReal &		X()			{ return _x; }
+	PMReal &		Y()			{ return _y; }
+	const PMReal &	X() const	{ return _x; }
+	const PMReal &	Y() const	{ return _y; }
+
+	PMPoint & operator += (const PMPoint & p)	{ _x += p._x; _y += p._y; return *this; }
+};
+
+
+class PMRect
+{
+	PMReal	_left, _top, _right, _bottom;
+
+public:
+	PMRect() {}
+	PMRect(const PMReal & l, const PMReal & t, const PMReal & r, const PMReal & b)
+	: _left(l), _top(t), _right(r), _bottom(b) {}
+
+	PMReal &		Left()			{ return _left; }
+	PMReal &		Top()			{ return _top; }
+	PMReal &		Right()			{ return _right; }
+	PMReal &		Bottom()		{ return _bottom; }
+	const PMReal &	Left() const	{ return _left; }
+	const PMReal &	Top() const		{ return _top; }
+	const PMReal &	Right() const	{ return _right; }
+	const PMReal &	Bottom() const	{ return _bottom; }
+
+	PMReal	Width() const		{ return _right - _left; }
+	PMReal	Height() const		{ return _bottom - _top; }
+	PMPoint	LeftTop() const		{ return PMPoint(_left, _top); }
+	PMPoint	Dimensions() const	{ return PMPoint(Width(), Height()); }
+};
+
+
+class PMMatrix
+{
+	PMReal	_skew, _x_scale, _y_scale;
+
+public:
+	PMMatrix() : _skew(0), _x_scale(1), _y_scale(1) {}
+
+	void	SkewTo(const PMReal & angle)					{ _skew = angle; }
+	void	Scale(const PMReal & sx, const PMReal & sy)	{ _x_scale *= sx; _y_scale *= sy; }
+
+	PMReal	skew() const	{ return _skew; }
+	PMReal	x_scale() const	{ return _x_scale; }
+	PMReal	y_scale() const	{ return _y_scale; }
+};
+
+
+// Text
+namespace Text
+{
+	typedef uint16	GlyphID;
+
+	enum FirstLineOffsetMetric 
+	{
+		kFLOLeading, kFLOAscent, kFLOCapHeight, kFLOEmBoxHeight, kFLOxHeight, 
+		kFLOFixedHeight, kFLOEmBoxDepth, kFLOICFBottomInset, kFLOICFTopInset
+	};
+	enum GridAlignmentMetric	{ kGANone, kGABaseline, kGAEmTop, kGAEmCenter, kGAEmBottom };
+	enum LeadingModel			{ kRomanLeadingModel, kAkiBelowLeadingModel, kAkiAboveLeadingModel };
+}
+
+const Text::GlyphID	kInvalidGlyphID = 0xffff;
+
+enum
+{
+	kTextChar_BreakRunInStyle			= 0x0003,
+	kTextChar_Tab						= 0x0009,
+	kTextChar_SoftCR					= 0x000A,
+	kTextChar_CR						= 0x000D,
+	kTextChar_Table						= 0x0016,
+	kTextChar_TableContinued			= 0x0017,
+	kTextChar_HyphenMinus				= 0x002D,
+	kTextChar_Period					= 0x002E,
+	kTextChar_Zero						= 0x0030,
+	kTextChar_HardSpace					= 0x00A0,
+	kTextChar_FlushSpace				= 0x2001,
+	kTextChar_EnSpace					= 0x2002,
+	kTextChar_EmSpace					= 0x2003,
+	kTextChar_ThirdSpace				= 0x2004,
+	kTextChar_QuarterSpace				= 0x2005,
+	kTextChar_SixthSpace				= 0x2006,
+	kTextChar_FigureSpace				= 0x2007,
+	kTextChar_PunctuationSpace			= 0x2008,
+	kTextChar_ThinSpace					= 0x2009,
+	kTextChar_HairSpace					= 0x200A,
+	kTextChar_ZeroSpaceBreak			= 0x200B,
+	kTextChar_ZeroWidthNonJoiner		= 0x200C,
+	kTextChar_ZeroWidthJoiner			= 0x200D,
+	kTextChar_NarrowNoBreakSpace		= 0x202F,
+	kTextChar_ZeroSpaceNoBreak			= 0xFEFF,
+	kTextChar_ObjectReplacementCharacter= 0xFFFC
+};
+
+
+class UTF32TextChar
+{
+	uint32	_value;
+
+public:
+	UTF32TextChar(uint32 v = 0) : _value(v) {}
+
+	uint32	GetValue() const	{ return _value; }
+};
+
+
+class WideString
+{
+	std::vector<textchar>	_chars;
+
+public:
+	typedef std::vector<textchar>::const_iterator	const_iterator;
+
+	const_iterator	begin() const	{ return _chars.begin(); }
+	const_iterator	end() const		{ return _chars.end(); }
+
+	void	Append(textchar c)		{ _chars.push_back(c); }
+	void	Clear()					{ _chars.clear(); }
+	int32	NumUTF16TextChars() const	{ return int32(_chars.size()); }
+	const UTF16TextChar * GrabUTF16Buffer(int32 * len) const
+	{
+		if (len) *len = NumUTF16TextChars();
+		return _chars.empty() ? nil : &_chars[0];
+	}
+};
+
+
+// Object model
+class IDataBase;
+
+class IPMUnknown
+{
+public:
+	virtual ~IPMUnknown() {}
+
+	virtual void	AddRef() const = 0;
+	virtual void	Release() const = 0;
+};
+
+
+/* The return type of the factory functions. Lets the caller static_cast the
+result to the interface it asked for, as it would an IPMUnknown pointer.
+*/
+class PMUnknownRef
+{
+	IPMUnknown * _p;
+
+public:
+	PMUnknownRef(IPMUnknown * p = nil) : _p(p) {}
+
+	template <class T> 
+	operator T * () const	{ return dynamic_cast<T *>(_p); }
+};
+
+
+struct UseDefaultIID {};
+
+// Interfaces are implemented by multiple inheritance so querying for another
+// interface is a cross cast.
+template <class T, class U>
+T * QueryInterfaceOf(const U * p)
+{
+	if (p == nil)	return nil;
+
+	T * const t = dynamic_cast<T *>(const_cast<U *>(p));
+	if (t)	t->AddRef();
+	return t;
+}
+
+IPMUnknown *	InstantiateByUID(IDataBase * db, UID uid);
+
+
+template <class T>
+class InterfacePtr
+{
+	T * _p;
+
+public:
+	InterfacePtr(T * p = nil) : _p(p) {}
+	InterfacePtr(const InterfacePtr & rhs) : _p(rhs._p)	{ if (_p) _p->AddRef(); }
+	template <class U>
+	InterfacePtr(U * p, const UseDefaultIID &) : _p(QueryInterfaceOf<T>(p)) {}
+	template <class U>
+	InterfacePtr(const InterfacePtr<U> & p, const UseDefaultIID &) : _p(QueryInterfaceOf<T>(p.get())) {}
+	InterfacePtr(IDataBase * db, UID uid, const UseDefaultIID &) : _p(nil)
+	{
+		IPMUnknown * const o = InstantiateByUID(db, uid);
+		_p = QueryInterfaceOf<T>(o);
+		if (o)	o->Release();
+	}
+	~InterfacePtr()	{ if (_p) _p->Release(); }
+
+	InterfacePtr & operator = (const InterfacePtr & rhs)
+	{
+		if (rhs._p)	rhs._p->AddRef();
+		if (_p)		_p->Release();
+		_p = rhs._p;
+		return *this;
+	}
+
+	operator T * () const	{ return _p; }
+	T * operator -> () const	{ return _p; }
+	T * get() const			{ return _p; }
+	T * forget()			{ T * const p = _p; _p = nil; return p; }
+	void reset(T * p = nil)	{ if (_p) _p->Release(); _p = p; }
+};
+
+
+class UIDRef
+{
+	IDataBase * _db;
+	UID			_uid;
+
+public:
+	UIDRef(IDataBase * db = nil, UID uid = kInvalidUID) : _db(db), _uid(uid) {}
+
+	IDataBase * GetDataBase() const	{ return _db; }
+	UID			GetUID() const		{ return _uid; }
+
+	bool operator == (const UIDRef & r) const	{ return _db == r._db && _uid == r._uid; }
+	bool operator != (const UIDRef & r) const	{ return !(*this == r); }
+};
+
+
+// Host supplied object model functions.
+PMUnknownRef	CreateObject(ClassID cls, PMIID iid);
+IDataBase	  *	GetDataBase(const IPMUnknown * o);
+UIDRef			GetUIDRef(const IPMUnknown * o);
+
+template <class T> T * GetUtilsInstance();
+
+template <class T>
+class Utils
+{
+public:
+	T * operator -> () const	{ return GetUtilsInstance<T>(); }
+};
@@ -0,0 +1,73 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Stand-in for the ASL unicode conversion header.
+namespace adobe
+{
+
+// Convert a UTF-16 sequence to UTF-8.
+template <typename I, typename O>
+O to_utf8(I first, I last, O out)
+{
+	while (first != last)
+	{
+		unsigned long c = static_cast<unsigned short>(*first++);
+		if (c >= 0xD800 && c < 0xDC00 && first != last)
+		{
+			const unsigned long lo = static_cast<unsigned short>(*first);
+			if (lo >= 0xDC00 && lo < 0xE000)
+			{
+				c = 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00);
+				++first;
+			}
+		}
+
+		if (c < 0x80)
+			*out++ = char(c);
+		else if (c < 0x800)
+		{
+			*out++ = char(0xC0 | c >> 6);
+			*out++ = char(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			*out++ = char(0xE0 | c >> 12);
+			*out++ = char(0x80 | (c >> 6 & 0x3F));
+			*out++ = char(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			*out++ = char(0xF0 | c >> 18);
+			*out++ = char(0x80 | (c >> 12 & 0x3F));
+			*out++ = char(0x80 | (c >> 6 & 0x3F));
+			*out++ = char(0x80 | (c & 0x3F));
+		}
+	}
+
+	return out;
+}
+
+} // end of namespace adobe
@@ -0,0 +1,75 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Stand-in for the InDesign SDK header of the same name.
+#include "VCPlugInHeaders.h"
+
+class ITextModel;
+class WideString;
+
+/* Walks the UTF-16 text of a story. The stand-in iterator reads from a 
+contiguous buffer owned by the text model it was created from.
+*/
+class TextIterator
+{
+	const ITextModel	  * _model;
+	const UTF16TextChar	  * _text;
+	TextIndex				_length,
+							_pos;
+
+public:
+	TextIterator() : _model(nil), _text(nil), _length(0), _pos(0) {}
+	TextIterator(const ITextModel * m, const UTF16TextChar * text, TextIndex length, TextIndex pos)
+	: _model(m), _text(text), _length(length), _pos(pos) {}
+
+	bool			IsNull() const		{ return _text == nil || _pos < 0 || _pos >= _length; }
+	TextIndex		Position() const	{ return _pos; }
+	UTF32TextChar	operator * () const	{ return IsNull() ? UTF32TextChar(0) : UTF32TextChar(_text[_pos]); }
+
+	TextIterator &	operator ++ ()				{ ++_pos; return *this; }
+	TextIterator	operator ++ (int)			{ TextIterator t = *this; ++_pos; return t; }
+	TextIterator &	operator += (int32 n)		{ _pos += n; return *this; }
+	int32			operator - (const TextIterator & rhs) const	{ return _pos - rhs._pos; }
+	bool			operator == (const TextIterator & rhs) const	{ return _text == rhs._text && _pos == rhs._pos; }
+	bool			operator != (const TextIterator & rhs) const	{ return !(*this == rhs); }
+
+	void			AppendToStringAndIncrement(WideString * s, int32 n)
+	{
+		for (; n > 0 && !IsNull(); --n, ++_pos)
+			s->Append(_text[_pos]);
+	}
+
+	ITextModel *	QueryTextModel() const;
+};
+
+#include "ITextModel.h"
+
+inline
+ITextModel * TextIterator::QueryTextModel() const
+{
+	if (_model)	_model->AddRef();
+	return const_cast<ITextModel *>(_model);
+}
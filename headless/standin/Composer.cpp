@@ -0,0 +1,631 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <algorithm>
+#include <memory>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IComposeScanner.h>
+#include <IWaxLine.h>
+// Library headers
+// Module header
+#include "Composer.h"
+#include "Counters.h"
+#include "GrFaceCache.h"
+#include "Hyphenator.h"
+#include "Line.h"
+#include "Recorder.h"
+#include "ShapingPipeline.h"
+#include "Story.h"
+#include "Style.h"
+#include "Tiler.h"
+#include "Wax.h"
+#include "WorkPool.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+using namespace nrsc::standin;
+
+namespace
+{
+	// Whether ti is inside a word, as a line begun by a hyphen break is.
+	bool continues_word(const story & s, TextIndex ti)
+	{
+		return ti > 0 && ti < s.length() 
+			&& hyphenator::word_char(s.text()[ti - 1]) && hyphenator::word_char(s.text()[ti]);
+	}
+
+
+	// Whether a line composed again came out as the old one, in its place.
+	bool same_line(const wax_line & old, const wax_line & composed)
+	{
+		return old.composed() == composed.composed()
+			&& old.GetYPosition() == composed.GetYPosition()
+			&& old.tile_height() == composed.tile_height()
+			&& old.can_shuffle() == composed.can_shuffle();
+	}
+}
+
+
+
+column::column(const PMReal & width, const PMReal & depth)
+: _bounds(0, 0, width, depth)
+{
+}
+
+
+column::column(const PMRect & bounds)
+: _bounds(bounds)
+{
+}
+
+
+Text::FirstLineOffsetMetric column::GetFirstLineOffsetMetric(const ParcelKey &) const
+{
+	return Text::kFLOAscent;
+}
+
+
+
+composer::composer(story & s, const column & c, gr_face_cache & faces, unsigned int threads, unsigned int look_ahead)
+: _story(s),
+  _column(c),
+  _faces(faces),
+  _threads(threads),
+  _hyphens(nil),
+  _worker_allocations()
+{
+	_balance.max_chars = 0;
+	_balance.max_trials = 0;
+	if (look_ahead > 0)
+		_ahead.reset(new shaping_pipeline(_story, _faces, _column.bounds().Width(), look_ahead));
+}
+
+
+composer::~composer()
+{
+	clear();
+}
+
+
+void composer::clear()
+{
+	for (lines_t::iterator l = _lines.begin(), l_e = _lines.end(); l != l_e; ++l)
+		(*l)->Release();
+	_lines.clear();
+	_checkpoints.clear();
+}
+
+
+TextIndex composer::compose()
+{
+	clear();
+	_story.clear_damage();
+	_worker_allocations = allocations::table();
+
+	// Nothing shaped before still holds, the story may have been edited 
+	// without recomposing.
+	if (_ahead)	_ahead->invalidate(0);
+
+	// Stage every paragraph on the pool, or shape ahead on one thread. 
+	// The recorder wants composition all on this one.
+	std::vector<TextIndex>		starts;
+	std::vector<staged_lines_t>	staged;
+	std::unique_ptr<gr_face_cache::sharing>	sharing;
+	std::unique_ptr<work_pool>	pool;
+	shaped_source			  *	ahead = nil;
+	if (_threads > 1 && !recorder::is_open())
+	{
+		for (TextIndex ti = 0; ti < _story.length(); ti = _story.paragraph_end(ti))
+			starts.push_back(ti);
+		staged.resize(starts.size());
+
+		sharing.reset(new gr_face_cache::sharing(_faces));
+		pool.reset(new work_pool(_threads));
+		pool->start(starts.size(), [&](size_t p)
+		{
+			allocations::table	before, after;
+			allocations::snapshot(before);
+			stage_paragraph(starts[p], staged[p]);
+			allocations::snapshot(after);
+
+			std::lock_guard<std::mutex> lock(_worker_allocations_lock);
+			_worker_allocations += after -= before;
+		});
+	}
+	else
+		ahead = start_ahead(0);
+
+	const TextIndex ti = compose_staged(pool.get(), staged, ahead);
+	stop_ahead();
+	return ti;
+}
+
+
+/* Compose every paragraph from the start of the story, taking the lines 
+staged for each from the pool if there is one.
+*/
+TextIndex composer::compose_staged(work_pool * pool, std::vector<staged_lines_t> & staged, shaped_source * ahead)
+{
+	TextIndex		ti = 0;
+	PMReal			y = _column.bounds().Top();
+	const IWaxLine *	previous = nil;
+	for (size_t para = 0; ti < _story.length(); ++para)
+	{
+		// One tiler per paragraph, as the plug-in gets one recompose call
+		// per paragraph.
+		recompose_helper	helper(_story, _column, ti, y, previous);
+		tiler				tile_manager(helper);
+		const TextIndex		para_end = helper.GetParagraphEnd();
+
+		// Use the staged lines unless this thread gets to the paragraph 
+		// before the pool does.
+		staged_lines_t		no_lines,
+						  & lines = pool && para < staged.size() && !pool->claim(para) ? staged[para] : no_lines;
+		if (&lines != &no_lines)
+			pool->wait(para);
+		staged_lines_t::const_iterator	sl = lines.begin();
+
+		while (ti < para_end)
+		{
+			const tiler::checkpoint	cp = tile_manager.save();
+			while (sl != lines.end() && sl->start < ti)	++sl;
+			IWaxLine * l = sl != lines.end() && sl->start == ti 
+							? apply_staged_line(tile_manager, helper, *sl) 
+							: nil;
+			fingerprint	fp = l ? sl->composed : fingerprint();
+			if (l == nil)
+				l = compose_line(tile_manager, _faces, helper, ti, nil, ahead, balance(), _hyphens, &fp);
+
+			wax_line * const wl = dynamic_cast<wax_line *>(l);
+			if (wl == nil)	return ti;
+			if (wl->span() == 0)
+			{
+				// Overset, the column is full.
+				wl->Release();
+				return ti;
+			}
+
+			wl->set_composed(fp.value());
+			_lines.push_back(wl);
+			_checkpoints.push_back(cp);
+			ti += wl->span();
+			y = wl->GetYPosition();
+			previous = wl;
+		}
+		staged_lines_t().swap(lines);
+	}
+
+	return ti;
+}
+
+
+/* Compose a paragraph on its own and stage its lines. Tiles in a column
+are the same width all the way down, so starting just below the top edge
+stages lines that fit anywhere below the first.
+*/
+void composer::stage_paragraph(TextIndex start, staged_lines_t & lines) const
+{
+	recompose_helper	helper(_story, _column, start, _column.bounds().Top() + 1, nil);
+	tiler				tile_manager(helper);
+	lines_t				composed;
+
+	for (TextIndex ti = start, para_end = helper.GetParagraphEnd(); ti < para_end;)
+	{
+		lines.push_back(staged_line());
+		wax_line * const wl = dynamic_cast<wax_line *>(compose_line(tile_manager, _faces, helper, ti, &lines.back(), nil, balance(), _hyphens));
+		if (wl == nil || wl->span() == 0)
+		{
+			if (wl)	wl->Release();
+			lines.pop_back();
+			break;
+		}
+
+		composed.push_back(wl);
+		ti += wl->span();
+	}
+
+	for (lines_t::iterator l = composed.begin(), l_e = composed.end(); l != l_e; ++l)
+		(*l)->Release();
+}
+
+
+/* Start shaping ahead from position, unless there is no pipeline or the 
+recorder wants composition all on this thread.
+*/
+shaped_source * composer::start_ahead(TextIndex position)
+{
+	if (!_ahead || recorder::is_open())	return nil;
+
+	_ahead->start(position);
+	return _ahead.get();
+}
+
+
+void composer::stop_ahead()
+{
+	if (!_ahead)	return;
+
+	_ahead->stop();
+	_ahead->take_allocations(_worker_allocations);
+}
+
+
+TextIndex composer::composed_length() const
+{
+	return _lines.empty() ? 0 : _lines.back()->start() + _lines.back()->span();
+}
+
+
+TextIndex composer::recompose()
+{
+	const story::damage	d = _story.damaged();
+	if (_lines.empty())
+		return compose();
+	_story.clear_damage();
+	_worker_allocations = allocations::table();
+	if (_ahead && !d.empty())
+		_ahead->invalidate(d.start);
+
+	// Edits in the overset text change nothing that was composed.
+	if (d.empty() || d.start > composed_length())
+		return composed_length();
+
+	// Start from the line before the one holding the damage, as a word 
+	// shortened at the start of a line can pull back onto the one above.
+	// That text is untouched, so its positions still hold.
+	// Balanced lines depend on the text after them, so with balancing on 
+	// start from the first line of the paragraph.
+	size_t first = _lines.size() - 1;
+	while (first > 0 && _lines[first]->start() > d.start)	--first;
+	if (first > 0 && _story.text()[_lines[first]->start() - 1] != kTextChar_CR)
+		--first;
+	// A word's hyphenation depends on all of it, so with hyphenation on 
+	// also start before any line begun inside a word broken above it.
+	while (_hyphens && first > 0 && continues_word(_story, _lines[first]->start()))
+		--first;
+	while (balance() && first > 0 && _story.text()[_lines[first]->start() - 1] != kTextChar_CR)
+		--first;
+
+	// An old line can be picked up again once the new text reaches its 
+	// start, beyond the damage. Lines in an edited paragraph's remainder 
+	// may have a new paragraph style, so those are all recomposed.
+	const TextIndex	delta = d.inserted - d.removed,
+					damage_end = d.start + d.inserted,
+					settle = d.paragraphs 
+							 ? std::max(_story.paragraph_end(damage_end), damage_end + 1) 
+							 : damage_end + 1;
+	// Lines after the last that cannot be shuffled can move up or down.
+	size_t			pinned = first;
+	for (size_t l = first; l != _lines.size(); ++l)
+		if (!_lines[l]->can_shuffle())	pinned = l;
+
+	// Resume mid-paragraph from the tiler's checkpoint at the first line.
+	lines_t			composed;
+	checkpoints_t	checkpoints;
+	size_t			old = first;
+	bool			settled = false;
+	compose_from(_lines[first]->start(), 
+				 first > 0 ? _lines[first - 1]->GetYPosition() : _column.bounds().Top(), 
+				 first > 0 ? _lines[first - 1] : nil, 
+				 &_checkpoints[first], 
+				 start_ahead(_lines[first]->start()), 
+				 composed, checkpoints, 
+				 [&](TextIndex ti, const wax_line & wl)
+	{
+		// The rest are unchanged but for their depth if an old line 
+		// starts here, free of any drop cap above it, and either stays 
+		// put or can be shuffled.
+		if (ti < settle)	return false;
+		while (old < _lines.size() && _lines[old]->start() + delta < ti)	++old;
+		settled = old < _lines.size() 
+				  && _lines[old]->start() + delta == ti 
+				  && !_lines[old - 1]->GetNextLineAffectedByDropcap() 
+				  && !wl.GetNextLineAffectedByDropcap() 
+				  && (old > pinned || wl.GetYPosition() + _lines[old]->tile_height() == _lines[old]->GetYPosition());
+		return settled;
+	});
+	stop_ahead();
+
+	// Keep an old line, wax runs and all, wherever composing it again gave 
+	// the same line in the same place, so only the lines that changed need 
+	// rebuilding. Those holding damaged text cannot match, those after it 
+	// match where the edit moved them to.
+	const size_t last = settled ? old : _lines.size();
+	for (size_t o = first, n = 0; o != last && n != composed.size(); ++o)
+	{
+		wax_line * const	ol = _lines[o];
+		const TextIndex		start = ol->start();
+		if (start + ol->span() > d.start && start < d.start + d.removed)	continue;
+
+		const TextIndex		moved = start < d.start ? start : start + delta;
+		while (n != composed.size() && composed[n]->start() < moved)	++n;
+		if (n == composed.size() || composed[n]->start() != moved || !same_line(*ol, *composed[n]))
+			continue;
+
+		ol->AddRef();
+		ol->set_start(moved);
+		composed[n]->Release();
+		composed[n] = ol;
+		NRSC_COUNT(lines_reused);
+	}
+
+	// Swap the new lines in for the old ones they replace.
+	for (size_t l = first; l != last; ++l)
+		_lines[l]->Release();
+	_lines.erase(_lines.begin() + first, _lines.begin() + last);
+	_lines.insert(_lines.begin() + first, composed.begin(), composed.end());
+	_checkpoints.erase(_checkpoints.begin() + first, _checkpoints.begin() + last);
+	_checkpoints.insert(_checkpoints.begin() + first, checkpoints.begin(), checkpoints.end());
+
+	// Shuffle the rest along the text and up or down the column, each 
+	// line's baseline sitting its tile height below the one before as 
+	// the column would place it. Shuffled down, lines can fall off the 
+	// bottom. Shuffled up, there may be room for overset text.
+	const size_t	kept = first + composed.size();
+	const bool		moved_up = kept < _lines.size() 
+							   && _lines[kept]->GetYPosition() > _lines[kept - 1]->GetYPosition() + _lines[kept]->tile_height();
+	size_t			l = kept;
+	for (; l != _lines.size(); ++l)
+	{
+		const PMReal y = _lines[l - 1]->GetYPosition() + _lines[l]->tile_height();
+		if (y > _column.bounds().Bottom())	break;
+		_lines[l]->set_start(_lines[l]->start() + delta);
+		_lines[l]->SetCompositionYPosition(y);
+		_checkpoints[l].y_offset = _lines[l - 1]->GetYPosition();
+	}
+	for (size_t o = l; o != _lines.size(); ++o)
+		_lines[o]->Release();
+	_lines.erase(_lines.begin() + l, _lines.end());
+	_checkpoints.erase(_checkpoints.begin() + l, _checkpoints.end());
+
+	if (moved_up && composed_length() < _story.length())
+	{
+		compose_from(composed_length(), _lines.back()->GetYPosition(), _lines.back(), nil, 
+					 start_ahead(composed_length()), _lines, _checkpoints, settled_t());
+		stop_ahead();
+	}
+
+	return composed_length();
+}
+
+
+void composer::shape_ahead(TextIndex position)
+{
+	if (start_ahead(position) == nil)	return;
+
+	_ahead->fill();
+	stop_ahead();
+}
+
+
+/* Compose lines from a position until the column is full, the story ends
+or settled says the lines after the last one composed need not be. The 
+position must start a paragraph unless there is a checkpoint to resume 
+from.
+*/
+TextIndex composer::compose_from(TextIndex ti, PMReal y, const IWaxLine * previous, const tiler::checkpoint * resume, 
+								 shaped_source * ahead, lines_t & lines, checkpoints_t & checkpoints, const settled_t & settled)
+{
+	while (ti < _story.length())
+	{
+		recompose_helper	helper(_story, _column, ti, y, previous);
+		tiler				tile_manager(helper);
+		if (resume)
+			tile_manager.restore(*resume);
+		resume = nil;
+
+		for (const TextIndex para_end = helper.GetParagraphEnd(); ti < para_end;)
+		{
+			const tiler::checkpoint	cp = tile_manager.save();
+			fingerprint				fp;
+			wax_line * const wl = dynamic_cast<wax_line *>(compose_line(tile_manager, _faces, helper, ti, nil, ahead, balance(), _hyphens, &fp));
+			if (wl == nil || wl->span() == 0)
+			{
+				// Overset, the column is full.
+				if (wl)	wl->Release();
+				return ti;
+			}
+
+			wl->set_composed(fp.value());
+			lines.push_back(wl);
+			checkpoints.push_back(cp);
+			ti += wl->span();
+			y = wl->GetYPosition();
+			previous = wl;
+			if (settled && settled(ti, *wl))
+				return ti;
+		}
+	}
+
+	return ti;
+}
+
+
+bool composer::rebuild(fingerprints_t * paragraphs)
+{
+	fingerprint	fp;
+	TextIndex	para_end = 0;
+	if (paragraphs)	paragraphs->clear();
+
+	for (lines_t::iterator l = _lines.begin(), l_e = _lines.end(); l != l_e; ++l)
+	{
+		if (paragraphs && (*l)->start() >= para_end)
+		{
+			if (l != _lines.begin())	paragraphs->push_back(fp.value());
+			fp.clear();
+			para_end = _story.paragraph_end((*l)->start());
+		}
+
+		(*l)->clear_runs();
+		if (!rebuild_line(_faces, rebuild_helper(_story, **l), paragraphs ? &fp : nil, _hyphens, &_batch))
+			return false;
+	}
+	if (paragraphs && !_lines.empty())
+		paragraphs->push_back(fp.value());
+
+	return true;
+}
+
+
+bool composer::rebuild_pending()
+{
+	for (lines_t::iterator l = _lines.begin(), l_e = _lines.end(); l != l_e; ++l)
+		if ((*l)->runs().empty() && !rebuild_line(_faces, rebuild_helper(_story, **l), nil, _hyphens, &_batch))
+			return false;
+
+	return true;
+}
+
+
+void composer::fingerprint_wax(fingerprints_t & paragraphs) const
+{
+	fingerprint	fp;
+	TextIndex	para_start = 0,
+				para_end = 0;
+	paragraphs.clear();
+
+	for (lines_t::const_iterator l = _lines.begin(), l_e = _lines.end(); l != l_e; ++l)
+	{
+		if ((*l)->start() >= para_end)
+		{
+			if (l != _lines.begin())	paragraphs.push_back(fp.value());
+			fp.clear();
+			para_start = _story.paragraph_start((*l)->start());
+			para_end = _story.paragraph_end((*l)->start());
+		}
+
+		fp.add_wax_line((*l)->start() - para_start, **l);
+		const wax_line::runs_t & runs = (*l)->runs();
+		for (wax_line::runs_t::const_iterator r = runs.begin(), r_e = runs.end(); r != r_e; ++r)
+		{
+			const wax_run * const wr = dynamic_cast<const wax_run *>(*r);
+			if (wr == nil)	continue;
+
+			fp.add_style(wr->style());
+			fp.add_wax_run(wr->GetXPosition(), wr->GetYPosition());
+			for (wax_run::glyphs_t::const_iterator g = wr->glyphs().begin(), g_e = wr->glyphs().end(); g != g_e; ++g)
+				fp.add_wax_glyph(g->id, g->advance, g->x_offset, g->y_offset);
+			for (wax_run::mappings_t::const_iterator m = wr->mappings().begin(), m_e = wr->mappings().end(); m != m_e; ++m)
+				fp.add_wax_mapping(m->width, m->glyph_index, m->num_glyphs);
+		}
+	}
+	if (!_lines.empty())
+		paragraphs.push_back(fp.value());
+}
+
+
+
+recompose_helper::recompose_helper(story & s, const column & c, TextIndex start, const PMReal & y, const IWaxLine * previous)
+: _story(s),
+  _column(c),
+  _start(start),
+  _next(start),
+  _para_start(s.paragraph_start(start)),
+  _para_end(s.paragraph_end(start)),
+  _y(y),
+  _tile_height(0),
+  _previous(previous)
+{
+}
+
+
+IComposeScanner * recompose_helper::GetComposeScanner() const	{ return &_story; }
+ITextParcelList * recompose_helper::GetTextParcelList() const	{ return const_cast<column *>(&_column); }
+IDataBase * recompose_helper::GetDataBase() const				{ return nil; }
+TextIndex recompose_helper::GetParagraphStart() const			{ return _para_start; }
+TextIndex recompose_helper::GetParagraphEnd() const				{ return _para_end; }
+TextIndex recompose_helper::GetStartingTextIndex() const		{ return _start; }
+ParcelKey recompose_helper::GetStartingParcelKey() const		{ return ParcelKey(0); }
+PMReal recompose_helper::GetStartingYPosition() const			{ return _y; }
+const IWaxLine * recompose_helper::GetPreviousWaxLine() const	{ return _previous; }
+
+
+bool16 recompose_helper::GetTiles(const PMReal & min_width, const PMReal & height, const PMReal & TOF_height,
+								  Text::GridAlignmentMetric, const PMReal &,
+								  Text::LeadingModel, const PMReal &,
+								  const PMReal &, const PMReal &,
+								  TextIndex, bool16,
+								  ParcelKey * parcel, PMReal * y_position, Text::FirstLineOffsetMetric *,
+								  PMRectCollection & tiles, bool16 * at_TOF, bool16 * parcel_position_dependent,
+								  PMReal * left_margin, PMReal * right_margin)
+{
+	const PMRect &	area = _column.bounds();
+	const bool		at_top = *y_position <= area.Top();
+	const PMReal	baseline = at_top ? area.Top() + TOF_height : *y_position + height;
+
+	tiles.clear();
+	*parcel = ParcelKey(0);
+	*at_TOF = at_top;
+	*parcel_position_dependent = kFalse;
+	*left_margin  = area.Left();
+	*right_margin = area.Right();
+
+	// No tiles means there is no room left in the column.
+	if (area.Width() < min_width || baseline > area.Bottom())
+		return kTrue;
+
+	*y_position = baseline;
+	_tile_height = height;
+	tiles.push_back(PMRect(area.Left(), baseline - height, area.Right(), baseline));
+	return kTrue;
+}
+
+
+IWaxLine * recompose_helper::QueryNewWaxLine()
+{
+	return new wax_line();
+}
+
+
+void recompose_helper::ApplyComposedLine(IWaxLine * line, int32 span)
+{
+	wax_line * const wl = dynamic_cast<wax_line *>(line);
+	if (wl == nil)	return;
+
+	wl->set_start(_next);
+	wl->set_tile_height(_tile_height);
+	_next += span;
+	_previous = wl;
+}
+
+
+
+rebuild_helper::rebuild_helper(story & s, const wax_line & line)
+: _story(s),
+  _line(line)
+{
+}
+
+
+IComposeScanner * rebuild_helper::GetComposeScanner() const	{ return &_story; }
+IDataBase * rebuild_helper::GetDataBase() const				{ return nil; }
+UID rebuild_helper::GetParcelFrameUID() const				{ return kInvalidUID; }
+TextIndex rebuild_helper::GetParagraphStart() const			{ return _story.paragraph_start(_line.start()); }
+TextIndex rebuild_helper::GetTextIndex() const				{ return _line.start(); }
+const IWaxLine * rebuild_helper::GetWaxLine() const			{ return &_line; }
@@ -0,0 +1,275 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IParagraphComposer.h>
+#include <ITextParcelList.h>
+// Library headers
+// Module header
+#include "Allocations.h"
+#include "Fingerprint.h"
+#include "GlyphBatch.h"
+#include "Line.h"
+#include "Tiler.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+namespace nrsc
+{
+class gr_face_cache;
+class hyphenator;
+
+namespace standin
+{
+class shaping_pipeline;
+class story;
+class wax_line;
+class work_pool;
+
+/** A single rectangular text frame. Lines are stacked from the top edge 
+	and composition stops when the next line's baseline would fall below 
+	the bottom edge.
+*/
+class column : public ITextParcelList
+{
+public:
+	column(const PMReal & width, const PMReal & depth = 1.0e7);
+	explicit column(const PMRect & bounds);
+
+	const PMRect &	bounds() const	{ return _bounds; }
+
+	// IPMUnknown
+	void	AddRef() const	{}
+	void	Release() const	{}
+
+	// ITextParcelList
+	Text::FirstLineOffsetMetric	GetFirstLineOffsetMetric(const ParcelKey & key) const;
+
+private:
+	PMRect	_bounds;
+};
+
+
+/** Composes a story into a column with the layout engine's compose_line 
+	and rebuild_line, doing the job the InDesign paragraph composer and its 
+	recompose and rebuild helpers do in the plug-in.
+	The tiler's state is checkpointed at every line start, so recompose() 
+	can resume mid-paragraph without walking down from its first line.
+	With more than one thread, paragraphs are composed ahead on a work pool 
+	and their lines staged, then put into the column in order on the 
+	calling thread with apply_staged_line, which falls back to composing a 
+	line again when the column gives it different tiles. Composing 
+	serially, the paragraphs ahead can be shaped on a background thread 
+	instead, by a pipeline kept between compose() and recompose() so the 
+	paragraphs an edit did not touch stay shaped.
+*/
+class composer
+{
+public:
+	typedef std::vector<wax_line *>				lines_t;
+	typedef std::vector<fingerprint::value_t>	fingerprints_t;
+	typedef std::vector<tiler::checkpoint>		checkpoints_t;
+
+	/** @param threads IN Paragraph composing threads besides the calling 
+			one, no more than 1 composes serially. The face cache is shared 
+			between them.
+		@param look_ahead IN When composing serially, the number of 
+			paragraphs to shape ahead of the composer on a background thread.
+	*/
+	composer(story & s, const column & c, gr_face_cache & faces, unsigned int threads = 1, unsigned int look_ahead = 0);
+	~composer();
+
+	/** Break the story into lines, discarding any previous composition.
+		@return The number of characters composed, less than the story 
+			length if the text is overset or composition failed.
+	*/
+	TextIndex	compose();
+
+	/** Recompose after the story was edited, from the line before the 
+		story's damage until a new line ends where an old one starts. The 
+		lines after that are kept, moved along the text and shuffled up or 
+		down the column, composing more at the end if there is now room. 
+		A line composed again that has the fingerprint of the old one in 
+		its place keeps the old wax line, runs and all, so 
+		rebuild_pending() only rebuilds the lines that changed. Always 
+		composes serially, shaping ahead if the composer was given a 
+		look-ahead.
+		@return The number of characters composed, as for compose().
+	*/
+	TextIndex	recompose();
+
+	/** Shape the paragraphs from the one starting at or after position 
+		ahead of the next recompose(), as while waiting on an edit there. 
+		Does nothing without a look-ahead.
+	*/
+	void		shape_ahead(TextIndex position);
+
+	/** Create the wax runs for every composed line.
+		@param paragraphs OUT If not nil, filled with the fingerprint of 
+			each composed paragraph.
+		@return false if any line failed to rebuild.
+	*/
+	bool		rebuild(fingerprints_t * paragraphs = 0);
+
+	/** Create the wax runs for the lines that have none, such as those 
+		recompose() composed.
+		@return false if any line failed to rebuild.
+	*/
+	bool		rebuild_pending();
+
+	/** Fingerprint each paragraph's wax lines and runs as they stand, 
+		without rebuilding any: the lines' tiles and baselines, and each 
+		run's position, style, glyphs and character mappings. Lines kept 
+		by recompose() must give what composing afresh does.
+	*/
+	void		fingerprint_wax(fingerprints_t & paragraphs) const;
+
+	/** Balance the rag of short ragged paragraphs, as compose_line does 
+		given limits. A max_chars of 0 turns balancing off, as it starts.
+	*/
+	void			set_balance(const balance_limits & limits)	{ _balance = limits; }
+	/** Hyphenate with h, nil as it starts for none. The hyphenator must 
+		outlive the composed lines, rebuilding them uses it too.
+	*/
+	void			set_hyphenator(const hyphenator * h)		{ _hyphens = h; }
+
+	/** The allocations the last compose() or recompose() made on the work 
+		pool's threads or shaping ahead, which the calling thread's 
+		allocations::snapshot does not see.
+	*/
+	const allocations::table &	worker_allocations() const	{ return _worker_allocations; }
+
+	const lines_t &	lines() const	{ return _lines; }
+	// The tiler's state at the start of each line.
+	const checkpoints_t &	checkpoints() const	{ return _checkpoints; }
+	void			clear();
+
+private:
+	// Hide copy constructor and assignment operator.
+	composer(const composer &);
+	composer & operator = (const composer &);
+
+	typedef std::vector<staged_line>	staged_lines_t;
+	typedef std::function<bool (TextIndex, const wax_line &)>	settled_t;
+
+	void		stage_paragraph(TextIndex start, staged_lines_t & lines) const;
+	TextIndex	compose_staged(work_pool * pool, std::vector<staged_lines_t> & staged, shaped_source * ahead);
+	TextIndex	compose_from(TextIndex ti, PMReal y, const IWaxLine * previous, const tiler::checkpoint * resume, 
+							 shaped_source * ahead, lines_t & lines, checkpoints_t & checkpoints, const settled_t & settled);
+	shaped_source *	start_ahead(TextIndex position);
+	void		stop_ahead();
+	TextIndex	composed_length() const;
+	const balance_limits *	balance() const	{ return _balance.max_chars ? &_balance : nil; }
+
+	story		  &	_story;
+	const column  &	_column;
+	gr_face_cache &	_faces;
+	unsigned int	_threads;
+	balance_limits	_balance;
+	const hyphenator *	_hyphens;
+	glyph_batch		_batch;
+	lines_t			_lines;
+	checkpoints_t	_checkpoints;
+	std::unique_ptr<shaping_pipeline>	_ahead;
+	allocations::table	_worker_allocations;
+	std::mutex		_worker_allocations_lock;
+};
+
+
+/** The services the layout engine needs while breaking a paragraph into
+	lines.
+*/
+class recompose_helper : public IParagraphComposer::RecomposeHelper
+{
+public:
+	recompose_helper(story & s, const column & c, TextIndex start, const PMReal & y, const IWaxLine * previous);
+
+	IComposeScanner	  *	GetComposeScanner() const;
+	ITextParcelList	  *	GetTextParcelList() const;
+	IDataBase		  *	GetDataBase() const;
+	TextIndex			GetParagraphStart() const;
+	TextIndex			GetParagraphEnd() const;
+	TextIndex			GetStartingTextIndex() const;
+	ParcelKey			GetStartingParcelKey() const;
+	PMReal				GetStartingYPosition() const;
+	const IWaxLine	  *	GetPreviousWaxLine() const;
+
+	bool16	GetTiles(const PMReal & min_width, const PMReal & height, const PMReal & TOF_height,
+					 Text::GridAlignmentMetric grid_metric, const PMReal & grid_offset,
+					 Text::LeadingModel leading_model, const PMReal & leading_model_height,
+					 const PMReal & leading_model_offset, const PMReal & descent,
+					 TextIndex position, bool16 affected_by_vertical_justification,
+					 ParcelKey * parcel, PMReal * y_position, Text::FirstLineOffsetMetric * TOF_metric,
+					 PMRectCollection & tiles, bool16 * at_TOF, bool16 * parcel_position_dependent,
+					 PMReal * left_margin, PMReal * right_margin);
+
+	IWaxLine  *	QueryNewWaxLine();
+	void		ApplyComposedLine(IWaxLine * line, int32 span);
+
+private:
+	story		  &	_story;
+	const column  &	_column;
+	TextIndex		_start,
+					_next,
+					_para_start,
+					_para_end;
+	PMReal			_y,
+					_tile_height;
+	const IWaxLine *	_previous;
+};
+
+
+/** The services the layout engine needs while building the wax runs for 
+	a composed line.
+*/
+class rebuild_helper : public IParagraphComposer::RebuildHelper
+{
+public:
+	rebuild_helper(story & s, const wax_line & line);
+
+	IComposeScanner	  *	GetComposeScanner() const;
+	IDataBase		  *	GetDataBase() const;
+	UID					GetParcelFrameUID() const;
+	TextIndex			GetParagraphStart() const;
+	TextIndex			GetTextIndex() const;
+	const IWaxLine	  *	GetWaxLine() const;
+
+private:
+	story			&	_story;
+	const wax_line	&	_line;
+};
+
+} // end of namespace standin
+} // end of namespace nrsc
\ No newline at end of file
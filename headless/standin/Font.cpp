@@ -0,0 +1,321 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <cstring>
+#include <fstream>
+#include <iterator>
+// Interface headers
+#include "VCPlugInHeaders.h"
+// Library headers
+#include <PMRealGlyphPoint.h>
+// Module header
+#include "Font.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc::standin;
+
+namespace
+{
+	// sfnt data is big endian.
+	inline uint16 be16(const uchar * p)	{ return uint16(p[0] << 8 | p[1]); }
+	inline int16  bes16(const uchar * p)	{ return int16(be16(p)); }
+	inline uint32 be32(const uchar * p)	{ return uint32(p[0]) << 24 | uint32(p[1]) << 16 | uint32(p[2]) << 8 | p[3]; }
+}
+
+
+font * font::load(const std::string & path)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if (!file)	return nil;
+
+	std::vector<uchar> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (data.size() < 12)	return nil;
+
+	const uint32 version = be32(&data[0]);
+	if (version != 0x00010000 && version != 0x4F54544F /*OTTO*/ && version != 0x74727565 /*true*/)
+		return nil;
+
+	font * const f = new font(path, data);
+	if (f->_upem == 0 || f->_advances.empty())
+	{
+		delete f;
+		return nil;
+	}
+
+	return f;
+}
+
+
+font::font(const std::string & path, std::vector<uchar> & data)
+: _path(path),
+  _glyf_outlines(false),
+  _upem(0),
+  _ascender(0),
+  _descender(0),
+  _cap_height(0),
+  _x_height(0)
+{
+	_data.swap(data);
+	_paths.push_back(PMString(path.c_str()));
+	_glyf_outlines = table("glyf") != nil;
+
+	size_t len = 0;
+	const uchar * head = table("head", &len);
+	if (head && len >= 54)
+		_upem = be16(head + 18);
+
+	// Vertical metrics, the OS/2 heights are only present from version 2.
+	const uchar * hhea = table("hhea", &len);
+	unsigned int n_hmetrics = 0;
+	if (hhea && len >= 36)
+	{
+		_ascender   = bes16(hhea + 4);
+		_descender  = bes16(hhea + 6);
+		n_hmetrics	= be16(hhea + 34);
+	}
+	_cap_height = _ascender*7/10;
+	_x_height   = _ascender/2;
+	const uchar * os2 = table("OS/2", &len);
+	if (os2 && len >= 90 && be16(os2) >= 2)
+	{
+		_x_height   = bes16(os2 + 86);
+		_cap_height = bes16(os2 + 88);
+	}
+
+	// Horizontal advances.
+	const uchar * hmtx = table("hmtx", &len);
+	if (hmtx && n_hmetrics && len >= n_hmetrics*4)
+	{
+		_advances.resize(n_hmetrics);
+		for (unsigned int g = 0; g != n_hmetrics; ++g)
+			_advances[g] = be16(hmtx + g*4);
+	}
+
+	read_cmap();
+}
+
+
+const uchar * font::table(const char * tag, size_t * length) const
+{
+	const uint16 n_tables = be16(&_data[4]);
+	if (12 + n_tables*16u > _data.size())	return nil;
+
+	for (const uchar * r = &_data[12], * const r_e = r + n_tables*16; r != r_e; r += 16)
+	{
+		if (std::memcmp(r, tag, 4) != 0)	continue;
+
+		const uint32 offset = be32(r + 8), 
+					 len    = be32(r + 12);
+		if (offset > _data.size() || len > _data.size() - offset)
+			return nil;
+		if (length)	*length = len;
+		return &_data[offset];
+	}
+
+	return nil;
+}
+
+
+void font::read_cmap()
+{
+	size_t len = 0;
+	const uchar * const cmap = table("cmap", &len);
+	_bmp.assign(0x10000, 0);
+	if (cmap == nil || len < 4)	return;
+
+	// Prefer a full repertoire format 12 subtable over a BMP only format 4.
+	const uchar * fmt4 = nil, * fmt12 = nil;
+	const uint16 n_subtables = be16(cmap + 2);
+	for (uint16 i = 0; i != n_subtables && 4 + i*8u + 8 <= len; ++i)
+	{
+		const uchar * const rec = cmap + 4 + i*8;
+		const uint16 platform = be16(rec), encoding = be16(rec + 2);
+		const uint32 offset = be32(rec + 4);
+		if (offset + 4 > len || !(platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10))))
+			continue;
+
+		const uchar * const sub = cmap + offset;
+		switch (be16(sub))
+		{
+		case 4:		if (!fmt4)	fmt4 = sub;		break;
+		case 12:	if (!fmt12)	fmt12 = sub;	break;
+		}
+	}
+
+	if (fmt12)
+	{
+		const uint32 n_groups = be32(fmt12 + 12);
+		for (const uchar * g = fmt12 + 16, * const g_e = g + n_groups*12; g != g_e; g += 12)
+		{
+			const uint32 first = be32(g), last = be32(g + 4);
+			uint32 gid = be32(g + 8);
+			for (uint32 c = first; c <= last && c <= 0x10FFFF; ++c, ++gid)
+			{
+				if (c < 0x10000)	_bmp[c] = Text::GlyphID(gid);
+				else				_supplementary[c] = Text::GlyphID(gid);
+			}
+		}
+	}
+	else if (fmt4)
+	{
+		const uint16 seg_x2 = be16(fmt4 + 6);
+		const uchar * const ends    = fmt4 + 14,
+					* const starts  = ends + seg_x2 + 2,
+					* const deltas  = starts + seg_x2,
+					* const offsets = deltas + seg_x2;
+		for (uint16 s = 0; s != seg_x2; s += 2)
+		{
+			const uint16 first = be16(starts + s), last = be16(ends + s), 
+						 delta = be16(deltas + s), range_offset = be16(offsets + s);
+			for (uint32 c = first; c <= last && c != 0xFFFF; ++c)
+			{
+				uint16 gid = 0;
+				if (range_offset == 0)
+					gid = uint16(c + delta);
+				else
+				{
+					const uchar * const p = offsets + s + range_offset + (c - first)*2;
+					if (p + 2 <= cmap + len && (gid = be16(p)) != 0)
+						gid = uint16(gid + delta);
+				}
+				_bmp[c] = gid;
+			}
+		}
+	}
+}
+
+
+Text::GlyphID font::glyph(uint32 c) const
+{
+	if (c < 0x10000)	return _bmp[c];
+
+	const std::map<uint32, Text::GlyphID>::const_iterator g = _supplementary.find(c);
+	return g == _supplementary.end() ? 0 : g->second;
+}
+
+
+int font::advance(Text::GlyphID g) const
+{
+	if (g == kInvalidGlyphID)	return 0;
+	return g < _advances.size() ? _advances[g] : _advances.back();
+}
+
+
+IPMFont::FontType font::GetFontType() const
+{
+	return _glyf_outlines ? kTrueTypeFontType : kOpenTypeCFFFontType;
+}
+
+
+IPMFont::FontTechnology font::GetFontTechnology() const
+{
+	return _glyf_outlines ? kTrueTypeFont : kType1Font;
+}
+
+
+const K2Vector<PMString> * font::GetFullPath() const
+{
+	return &_paths;
+}
+
+
+PMReal font::GetAscent(const PMReal & point_size) const
+{
+	return point_size*_ascender/_upem;
+}
+
+
+PMReal font::GetCapHeight(const PMReal & point_size) const
+{
+	return point_size*_cap_height/_upem;
+}
+
+
+PMReal font::GetXHeight(const PMReal & point_size) const
+{
+	return point_size*_x_height/_upem;
+}
+
+
+PMReal font::GetEmBoxHeight(const PMReal & point_size, bool) const
+{
+	return point_size;
+}
+
+
+PMReal font::GetHorizEmBoxDepth() const
+{
+	return PMReal(-_descender)/_upem;
+}
+
+
+
+font_instance::font_instance(const font & f, const PMReal & point_size)
+: _font(f),
+  _scale(point_size/f.units_per_em())
+{
+}
+
+
+Text::GlyphID font_instance::GetGlyphID(uint32 c)
+{
+	return _font.glyph(c);
+}
+
+
+PMReal font_instance::GetGlyphWidth(Text::GlyphID g)
+{
+	return _scale*_font.advance(g);
+}
+
+
+void font_instance::FillOutGlyphIDs(PMRealGlyphPoint * gps, int32 n, const UTF16TextChar * text, int32 len)
+{
+	// One glyph per code unit, the trailing half of a surrogate pair gets 
+	// an invalid glyph with no advance.
+	for (int32 i = 0; i != n; ++i)
+	{
+		uint32 c = i < len ? text[i] : 0;
+		if (c >= 0xD800 && c < 0xDC00 && i+1 < n && i+1 < len && text[i+1] >= 0xDC00 && text[i+1] < 0xE000)
+		{
+			c = 0x10000 + ((c - 0xD800) << 10) + (text[i+1] - 0xDC00);
+			gps[i].SetGlyphID(_font.glyph(c));
+			gps[++i].SetGlyphID(kInvalidGlyphID);
+			continue;
+		}
+		gps[i].SetGlyphID(_font.glyph(c));
+	}
+}
+
+
+void font_instance::GetKerns(PMRealGlyphPoint * gps, int32 n)
+{
+	// Pair kerning is left to Graphite, the fallback path sets glyphs solid.
+	for (int32 i = 0; i != n; ++i)
+		gps[i].SetXPosition(0);
+}
@@ -0,0 +1,134 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <map>
+#include <string>
+#include <vector>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IFontInstance.h>
+#include <IPMFont.h>
+// Library headers
+#include <K2Vector.h>
+#include <PMString.h>
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+namespace nrsc
+{
+namespace standin
+{
+
+/** A font file loaded into memory. Reads just enough of the sfnt tables 
+	(head, hhea, OS/2, hmtx and cmap) to provide the metrics and character 
+	mapping the layout engine asks IPMFont and IFontInstance for. 
+	Lifetime is owned by the host, reference counting is a no-op.
+*/
+class font : public IPMFont
+{
+public:
+	/** Load a font file.
+		@param path IN The path to an sfnt (TrueType or OpenType) font file.
+		@return A new font or nil if the file cannot be read or is not an 
+			sfnt font.
+	*/
+	static font * load(const std::string & path);
+
+	// IPMUnknown
+	void	AddRef() const	{}
+	void	Release() const	{}
+
+	// IPMFont
+	FontType					GetFontType() const;
+	FontTechnology				GetFontTechnology() const;
+	const K2Vector<PMString> *	GetFullPath() const;
+
+	PMReal	GetAscent(const PMReal & point_size) const;
+	PMReal	GetCapHeight(const PMReal & point_size) const;
+	PMReal	GetXHeight(const PMReal & point_size) const;
+	PMReal	GetEmBoxHeight(const PMReal & point_size, bool vertical) const;
+	PMReal	GetHorizEmBoxDepth() const;
+
+	// Properties
+	const std::string &	path() const	{ return _path; }
+	unsigned int	units_per_em() const	{ return _upem; }
+	Text::GlyphID	glyph(uint32 c) const;
+	int				advance(Text::GlyphID g) const;
+
+private:
+	font(const std::string & path, std::vector<uchar> & data);
+
+	// Hide copy constructor and assignment operator.
+	font(const font &);
+	font & operator = (const font &);
+
+	const uchar *	table(const char * tag, size_t * length = nil) const;
+	void			read_cmap();
+
+	std::string			_path;
+	K2Vector<PMString>	_paths;
+	std::vector<uchar>	_data;
+	bool				_glyf_outlines;
+	unsigned int		_upem;
+	int					_ascender,
+						_descender,
+						_cap_height,
+						_x_height;
+	std::vector<uint16>	_advances;
+	std::vector<Text::GlyphID>			_bmp;
+	std::map<uint32, Text::GlyphID>		_supplementary;
+};
+
+
+/** A font scaled to a point size.
+*/
+class font_instance : public IFontInstance
+{
+public:
+	font_instance(const font & f, const PMReal & point_size);
+
+	// IPMUnknown
+	void	AddRef() const	{}
+	void	Release() const	{}
+
+	// IFontInstance
+	Text::GlyphID	GetGlyphID(uint32 c);
+	PMReal			GetGlyphWidth(Text::GlyphID g);
+	void			FillOutGlyphIDs(PMRealGlyphPoint * gps, int32 n, const UTF16TextChar * text, int32 len);
+	void			GetKerns(PMRealGlyphPoint * gps, int32 n);
+
+private:
+	const font &	_font;
+	PMReal			_scale;
+};
+
+} // end of namespace standin
+} // end of namespace nrsc
\ No newline at end of file
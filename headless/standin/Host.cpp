@@ -0,0 +1,94 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IHierarchy.h>
+#include <ILayoutUtils.h>
+// Library headers
+// Module header
+#include "Wax.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc::standin;
+
+/* The object model functions the stand-in SDK headers leave to the host.
+There is no document database outside InDesign, so only wax runs can be 
+created and every UID lookup fails, which the layout engine treats as a 
+missing inline graphic or an unknown page.
+*/
+
+namespace
+{
+	class layout_utils : public ILayoutUtils
+	{
+	public:
+		void		AddRef() const	{}
+		void		Release() const	{}
+
+		PageType	GetPageType(const UIDRef &)	{ return kUnisexPage; }
+		UID			GetOwnerPageUID(IHierarchy *)	{ return kInvalidUID; }
+	};
+
+	layout_utils	the_layout_utils;
+}
+
+
+PMUnknownRef CreateObject(ClassID cls, PMIID)
+{
+	switch (cls)
+	{
+	case kWaxTextRunBoss:	return PMUnknownRef(static_cast<IWaxRun *>(new wax_run()));
+	default:				return PMUnknownRef();
+	}
+}
+
+
+IDataBase * GetDataBase(const IPMUnknown *)
+{
+	return nil;
+}
+
+
+UIDRef GetUIDRef(const IPMUnknown *)
+{
+	return UIDRef();
+}
+
+
+IPMUnknown * InstantiateByUID(IDataBase *, UID)
+{
+	return nil;
+}
+
+
+template <> 
+ILayoutUtils * GetUtilsInstance<ILayoutUtils>()
+{
+	return &the_layout_utils;
+}
@@ -0,0 +1,85 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <fstream>
+// Interface headers
+// Library headers
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+// Module header
+#include "MappedFile.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc::standin;
+
+
+mapped_file::mapped_file(const std::string & path)
+: _data(nullptr),
+  _size(0)
+{
+#if !defined(_WIN32)
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)	return;
+
+	struct stat st;
+	if (::fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void * const p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		if (p != MAP_FAILED)
+		{
+			_data = p;
+			_size = size_t(st.st_size);
+		}
+	}
+	::close(fd);
+#else
+	std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+	if (!file)	return;
+
+	const std::streamoff length = file.tellg();
+	if (length <= 0)	return;
+	_copy.resize((size_t(length) + sizeof(unsigned int) - 1)/sizeof(unsigned int));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char *>(&_copy[0]), length))	return;
+	_data = &_copy[0];
+	_size = size_t(length);
+#endif
+}
+
+
+mapped_file::~mapped_file()
+{
+#if !defined(_WIN32)
+	if (_data)
+		::munmap(const_cast<void *>(_data), _size);
+#endif
+}
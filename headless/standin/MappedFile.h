@@ -0,0 +1,69 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <cstddef>
+#include <string>
+#include <vector>
+// Interface headers
+// Library headers
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+namespace nrsc
+{
+namespace standin
+{
+
+/** A whole file mapped read-only into memory, so processes and documents 
+	reading the same file share its pages. Where the platform has no 
+	mapping the file is read into memory instead.
+*/
+class mapped_file
+{
+public:
+	explicit mapped_file(const std::string & path);
+	~mapped_file();
+
+	bool			is_open() const	{ return _data != nullptr; }
+	const void *	data() const	{ return _data; }
+	size_t			size() const	{ return _size; }
+
+private:
+	mapped_file(const mapped_file &) = delete;
+	mapped_file & operator = (const mapped_file &) = delete;
+
+	const void *				_data;
+	size_t						_size;
+	std::vector<unsigned int>	_copy;		// Without mmap, 4 byte aligned.
+};
+
+} // end of namespace standin
+} // end of namespace nrsc
\ No newline at end of file
@@ -0,0 +1,184 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <ICompositionStyle.h>
+#include <IDrawingStyle.h>
+// Library headers
+// Module header
+#include "ShapingPipeline.h"
+#include "Story.h"
+#include "StyleRuns.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+using namespace nrsc::standin;
+
+
+shaping_pipeline::shaping_pipeline(story & s, gr_face_cache & faces, const PMReal & column_width, unsigned int depth)
+: _story(s),
+  _faces(faces),
+  _column_width(column_width),
+  _depth(depth ? depth : 1),
+  _next(0),
+  _shaping(-1),
+  _stopping(false),
+  _allocations()
+{
+}
+
+
+shaping_pipeline::~shaping_pipeline()
+{
+	stop();
+}
+
+
+void shaping_pipeline::start(TextIndex position)
+{
+	stop();
+
+	// Keep what is queued from the first paragraph the composer will want 
+	// on, and shape on from after it.
+	const TextIndex from = position == _story.paragraph_start(position) 
+							? position : _story.paragraph_end(position);
+	while (!_queue.empty() && _queue.front().start < from)
+		_queue.pop_front();
+	_next = _queue.empty() ? from : _queue.back().end;
+	_stopping = false;
+	_sharing.reset(new gr_face_cache::sharing(_faces));
+	_thread = std::thread(&shaping_pipeline::shape, this);
+}
+
+
+void shaping_pipeline::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_stopping = true;
+	}
+	_changed.notify_all();
+	if (_thread.joinable())
+		_thread.join();
+
+	_sharing.reset();
+}
+
+
+void shaping_pipeline::fill()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_changed.wait(lock, [&]() { return _stopping 
+		|| (_shaping == -1 && (_queue.size() >= _depth || _next >= _story.length())); });
+}
+
+
+void shaping_pipeline::invalidate(TextIndex position)
+{
+	// A paragraph ending at position may run on into inserted text if it 
+	// has no paragraph break.
+	while (!_queue.empty() && _queue.back().end >= position)
+		_queue.pop_back();
+}
+
+
+void shaping_pipeline::take_allocations(allocations::table & allocs)
+{
+	allocs += _allocations;
+	_allocations = allocations::table();
+}
+
+
+TextIndex shaping_pipeline::take(TextIndex start, TextIndex end, tile & t)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+
+	// Skip past anything the composer has gone by, wait for the paragraph
+	// if it is being shaped right now.
+	for (;;)
+	{
+		while (!_queue.empty() && _queue.front().start < start)
+			_queue.pop_front();
+		if (_shaping != start || _stopping)	break;
+		_changed.wait(lock);
+	}
+	_changed.notify_all();
+
+	if (_queue.empty() || _queue.front().start != start)
+	{
+		// The composer is shaping this paragraph itself, so go on from the 
+		// one after.
+		if (_next <= start)	_next = end;
+		return start;
+	}
+
+	const TextIndex filled = _queue.front().end == end ? _queue.front().filled : start;
+	if (filled != start)
+		t.take_runs(*_queue.front().runs);
+	_queue.pop_front();
+	return filled;
+}
+
+
+void shaping_pipeline::shape()
+{
+	allocations::table	before, after;
+	allocations::snapshot(before);
+
+	std::unique_lock<std::mutex> lock(_lock);
+	for (;;)
+	{
+		_changed.wait(lock, [&]() { return _stopping || (_queue.size() < _depth && _next < _story.length()); });
+		if (_stopping)	break;
+
+		const TextIndex start = _next,
+						end = _story.paragraph_end(start);
+		_shaping = start;
+		_next = end;
+		lock.unlock();
+
+		// The first line's window, as compose_line would fill it.
+		InterfacePtr<ICompositionStyle>	cs(_story.GetParagraphStyleAt(start), UseDefaultIID());
+		const line_metrics	lm(_story.GetCompleteStyleAt(start));
+		const PMReal		width = _column_width - cs->IndentLeftBody() - cs->IndentLeftFirst() - cs->IndentRightBody();
+		shaped		s = { start, end, start, std::unique_ptr<tile>(new tile()) };
+		style_runs	styles;
+		const bool	ok = styles.build(_story, start, end) 
+						 && fill_window(*s.runs, styles, _faces, start, s.filled, end, width, lm.em_box_height);
+
+		lock.lock();
+		if (ok)
+			_queue.push_back(std::move(s));
+		_shaping = -1;
+		_changed.notify_all();
+	}
+
+	allocations::snapshot(after);
+	_allocations += after -= before;
+}
\ No newline at end of file
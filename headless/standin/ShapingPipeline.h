@@ -0,0 +1,122 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+// Interface headers
+#include "VCPlugInHeaders.h"
+// Library headers
+#include <textiterator.h>
+// Module header
+#include "Allocations.h"
+#include "GrFaceCache.h"
+#include "Line.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+namespace nrsc
+{
+namespace standin
+{
+class story;
+
+/** Shapes paragraphs on a background thread ahead of the composer, which 
+	takes them through the shaped_source interface to fill the first line of
+	each paragraph. Only the window fill_window gives that line is shaped, 
+	for a line as wide as the column less the paragraph's first line 
+	indents. At most depth paragraphs wait in the queue. A paragraph the 
+	composer gets to first is skipped, and one being shaped when the 
+	composer wants it is waited for. The face cache is shared with the 
+	shaping thread while the pipeline runs. The story must not be edited 
+	while it runs; what is queued is kept when it stops, for the next 
+	start, so edits are reported to invalidate() between the two.
+*/
+class shaping_pipeline : public shaped_source
+{
+public:
+	shaping_pipeline(story & s, gr_face_cache & faces, const PMReal & column_width, unsigned int depth);
+	~shaping_pipeline();
+
+	/** Start shaping paragraphs from the first one to begin at or after 
+		position, after any still queued for them.
+	*/
+	void	start(TextIndex position);
+	void	stop();
+	// Wait, while running, until the queue is full or the story shaped.
+	void	fill();
+
+	/** Drop what has been shaped for text from position on, as it has been 
+		edited. Only call it while stopped.
+	*/
+	void	invalidate(TextIndex position);
+
+	/** Add the allocations the shaping thread made since the last call to 
+		allocs. Only call it while stopped.
+	*/
+	void	take_allocations(allocations::table & allocs);
+
+	// shaped_source
+	TextIndex	take(TextIndex start, TextIndex end, tile & t);
+
+private:
+	struct shaped
+	{
+		TextIndex				start,
+								end,
+								filled;		// Where the text in runs ends.
+		std::unique_ptr<tile>	runs;
+	};
+
+	// Hide copy constructor and assignment operator.
+	shaping_pipeline(const shaping_pipeline &);
+	shaping_pipeline & operator = (const shaping_pipeline &);
+
+	void	shape();
+
+	story					  &	_story;
+	gr_face_cache			  &	_faces;
+	const PMReal				_column_width;
+	const size_t				_depth;
+	std::deque<shaped>			_queue;
+	TextIndex					_next,		// The next paragraph to shape.
+								_shaping;	// The one being shaped, or -1.
+	bool						_stopping;
+	std::mutex					_lock;
+	std::condition_variable		_changed;
+	std::thread					_thread;
+	std::unique_ptr<gr_face_cache::sharing>	_sharing;
+	allocations::table			_allocations;
+};
+
+} // end of namespace standin
+} // end of namespace nrsc
\ No newline at end of file
@@ -0,0 +1,257 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <algorithm>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IDrawingStyle.h>
+// Library headers
+// Module header
+#include "Story.h"
+#include "Style.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc::standin;
+
+
+story::story()
+{
+}
+
+
+void story::append(const string_t & text, drawing_style & style)
+{
+	if (!text.empty())
+		append(text.data(), text.size(), style);
+}
+
+
+void story::append(const UTF16TextChar * text, size_t len, drawing_style & style)
+{
+	if (len == 0)	return;
+
+	if (_styles.empty() || _styles.back().style != &style)
+	{
+		style_change sc;
+		sc.start = length();
+		sc.style = &style;
+		_styles.push_back(sc);
+	}
+	_text.append(text, len);
+}
+
+
+void story::append_utf8(const std::string & text, drawing_style & style)
+{
+	append(utf16(text), style);
+}
+
+
+void story::clear()
+{
+	_text.clear();
+	_styles.clear();
+	_damage = damage();
+}
+
+
+void story::insert(TextIndex position, const string_t & text)
+{
+	insert(position, text.data(), text.size());
+}
+
+
+void story::insert(TextIndex position, const UTF16TextChar * text, size_t len)
+{
+	if (len == 0 || _styles.empty() || position < 0 || position > length())	return;
+
+	// A style change at the insertion point moves past the new text unless 
+	// it starts the paragraph, so typing continues the style before it.
+	const bool	para_start = paragraph_start(position) == position;
+	for (changes_t::iterator sc = _styles.begin(), sc_e = _styles.end(); sc != sc_e; ++sc)
+		if (sc->start > position || (sc->start == position && !para_start))
+			sc->start += TextIndex(len);
+
+	_text.insert(position, text, len);
+	add_damage(position, 0, TextIndex(len), 
+			   para_start || std::find(text, text + len, UTF16TextChar(kTextChar_CR)) != text + len);
+}
+
+
+void story::erase(TextIndex position, TextIndex len)
+{
+	if (position < 0 || position >= length())	return;
+	len = std::min(len, length() - position);
+	if (len <= 0)	return;
+
+	const TextIndex	end = position + len;
+	const bool		paragraphs = paragraph_start(position) == position 
+								 || _text.find(UTF16TextChar(kTextChar_CR), position) < string_t::size_type(end);
+	_text.erase(position, len);
+
+	// Style changes inside the erased text collapse onto its start, where 
+	// the last of them wins. Drop those left with nothing to style and 
+	// merge neighbours that end up the same.
+	changes_t	styles;
+	for (changes_t::iterator sc = _styles.begin(), sc_e = _styles.end(); sc != sc_e; ++sc)
+	{
+		if (sc->start >= end)			sc->start -= len;
+		else if (sc->start > position)	sc->start = position;
+		if (sc->start >= length())		break;
+
+		if (!styles.empty() && styles.back().start == sc->start)
+			styles.pop_back();
+		if (styles.empty() || styles.back().style != sc->style)
+			styles.push_back(*sc);
+	}
+	_styles.swap(styles);
+
+	add_damage(position, len, 0, paragraphs);
+}
+
+
+/* Widen the damage to cover an edit of the current text, keeping the 
+damage a single range of the text as last composed.
+*/
+void story::add_damage(TextIndex position, TextIndex removed, TextIndex inserted, bool paragraphs)
+{
+	if (_damage.empty())
+	{
+		_damage.start = position;
+		_damage.removed = removed;
+		_damage.inserted = inserted;
+		_damage.paragraphs = paragraphs;
+		return;
+	}
+
+	const TextIndex	start = std::min(_damage.start, position),
+					end = std::max(_damage.start + _damage.inserted, position + removed),
+					old_end = _damage.start + _damage.removed + end - (_damage.start + _damage.inserted);
+	_damage.start = start;
+	_damage.removed = old_end - start;
+	_damage.inserted = end + inserted - removed - start;
+	_damage.paragraphs = _damage.paragraphs || paragraphs;
+}
+
+
+story::changes_t::const_iterator story::style_at(TextIndex position) const
+{
+	style_change key;
+	key.start = position;
+	changes_t::const_iterator const sc = std::upper_bound(_styles.begin(), _styles.end(), key);
+	return sc == _styles.begin() ? _styles.end() : sc - 1;
+}
+
+
+TextIndex story::paragraph_start(TextIndex position) const
+{
+	if (position <= 0)	return 0;
+	const string_t::size_type cr = _text.rfind(UTF16TextChar(kTextChar_CR), position - 1);
+	return cr == string_t::npos ? 0 : TextIndex(cr + 1);
+}
+
+
+TextIndex story::paragraph_end(TextIndex position) const
+{
+	const string_t::size_type cr = _text.find(UTF16TextChar(kTextChar_CR), position);
+	return cr == string_t::npos ? length() : TextIndex(cr + 1);
+}
+
+
+PMUnknownRef story::QueryStrand(ClassID, PMIID) const
+{
+	// There are no owned items such as inline graphics.
+	return PMUnknownRef();
+}
+
+
+TextIterator story::QueryDataAt(TextIndex position, IDrawingStyle ** style, int32 * num_chars)
+{
+	const changes_t::const_iterator sc = style_at(position);
+	if (position < 0 || position >= length() || sc == _styles.end())
+		return TextIterator();
+
+	const changes_t::const_iterator next = sc + 1;
+	if (style)		*style = sc->style;
+	if (num_chars)	*num_chars = (next == _styles.end() ? length() : next->start) - position;
+
+	return TextIterator(this, _text.data(), length(), position);
+}
+
+
+IDrawingStyle * story::GetCompleteStyleAt(TextIndex position, int32 * num_chars)
+{
+	if (_styles.empty())	return nil;
+
+	// Past the end of the story answer with the last style.
+	const changes_t::const_iterator sc = style_at(std::min(position, length() - 1));
+	if (sc == _styles.end())	return nil;
+
+	const changes_t::const_iterator next = sc + 1;
+	if (num_chars)	*num_chars = std::max((next == _styles.end() ? length() : next->start) - position, 0);
+	return sc->style;
+}
+
+
+IDrawingStyle * story::GetParagraphStyleAt(TextIndex position, int32 * num_chars)
+{
+	if (num_chars)	*num_chars = paragraph_end(position) - position;
+	return GetCompleteStyleAt(paragraph_start(std::min(position, length())), nil);
+}
+
+
+
+story::string_t nrsc::standin::utf16(const std::string & utf8)
+{
+	story::string_t out;
+	out.reserve(utf8.size());
+
+	for (std::string::const_iterator i = utf8.begin(), e = utf8.end(); i != e;)
+	{
+		const unsigned char lead = *i++;
+		int		trail = lead < 0x80 ? 0 : lead < 0xC2 ? -1 : lead < 0xE0 ? 1 : lead < 0xF0 ? 2 : lead < 0xF5 ? 3 : -1;
+		uint32	c = trail == 0 ? lead : trail == 1 ? lead & 0x1F : trail == 2 ? lead & 0x0F : lead & 0x07;
+		const uint32 min = trail == 1 ? 0x80 : trail == 2 ? 0x800 : trail == 3 ? 0x10000 : 0;
+
+		for (; trail > 0 && i != e && (*i & 0xC0) == 0x80; --trail, ++i)
+			c = c << 6 | (*i & 0x3F);
+
+		if (trail != 0 || c < min || c > 0x10FFFF || (c >= 0xD800 && c < 0xE000))
+			c = 0xFFFD;
+
+		if (c < 0x10000)
+			out.push_back(UTF16TextChar(c));
+		else
+		{
+			out.push_back(UTF16TextChar(0xD800 + ((c - 0x10000) >> 10)));
+			out.push_back(UTF16TextChar(0xDC00 + (c & 0x3FF)));
+		}
+	}
+
+	return out;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <string>
+#include <vector>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IComposeScanner.h>
+#include <ITextModel.h>
+// Library headers
+#include <textiterator.h>
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+namespace nrsc
+{
+namespace standin
+{
+class drawing_style;
+
+/** The text of a story and the drawing styles applied to it. Paragraphs end 
+	with a kTextChar_CR, the paragraph attributes come from the style of a 
+	paragraph's first character. Lifetime is owned by the host, reference 
+	counting is a no-op.
+*/
+class story : public ITextModel, public IComposeScanner
+{
+public:
+	typedef std::basic_string<UTF16TextChar>	string_t;
+
+	/** The text changed by edits since the damage was last cleared. The 
+		range [start, start + removed) of the text as it was last composed 
+		now reads [start, start + inserted).
+	*/
+	struct damage
+	{
+		TextIndex	start,
+					removed,
+					inserted;
+		bool		paragraphs;	// A paragraph break or a paragraph's first character was edited
+
+		damage() : start(0), removed(0), inserted(0), paragraphs(false) {}
+		bool	empty() const	{ return removed == 0 && inserted == 0; }
+	};
+
+	story();
+
+	/** Append text in a style. The styles must outlive the story.
+	*/
+	void	append(const string_t & text, drawing_style & style);
+	void	append(const UTF16TextChar * text, size_t len, drawing_style & style);
+	void	append_utf8(const std::string & text, drawing_style & style);
+	void	clear();
+
+	/** Insert text at a position. It takes the style of the character 
+		before it, or at the start of a paragraph that of the one after it.
+	*/
+	void	insert(TextIndex position, const UTF16TextChar * text, size_t len);
+	void	insert(TextIndex position, const string_t & text);
+	void	erase(TextIndex position, TextIndex len);
+
+	const damage &	damaged() const	{ return _damage; }
+	void			clear_damage()	{ _damage = damage(); }
+
+	// Properties
+	TextIndex			length() const	{ return TextIndex(_text.size()); }
+	const string_t &	text() const	{ return _text; }
+	TextIndex			paragraph_start(TextIndex position) const;
+	TextIndex			paragraph_end(TextIndex position) const;
+
+	// IPMUnknown
+	void	AddRef() const	{}
+	void	Release() const	{}
+
+	// ITextModel
+	PMUnknownRef	QueryStrand(ClassID strand, PMIID iid) const;
+
+	// IComposeScanner
+	TextIterator	QueryDataAt(TextIndex position, IDrawingStyle ** style, int32 * num_chars);
+	IDrawingStyle *	GetCompleteStyleAt(TextIndex position, int32 * num_chars = nil);
+	IDrawingStyle *	GetParagraphStyleAt(TextIndex position, int32 * num_chars = nil);
+
+private:
+	struct style_change
+	{
+		TextIndex		start;
+		drawing_style *	style;
+
+		bool operator < (const style_change & rhs) const	{ return start < rhs.start; }
+	};
+	typedef std::vector<style_change>	changes_t;
+
+	// Hide copy constructor and assignment operator.
+	story(const story &);
+	story & operator = (const story &);
+
+	changes_t::const_iterator	style_at(TextIndex position) const;
+	void	add_damage(TextIndex position, TextIndex removed, TextIndex inserted, bool paragraphs);
+
+	string_t	_text;
+	changes_t	_styles;
+	damage		_damage;
+};
+
+/** Convert UTF-8 to UTF-16, replacing malformed sequences with U+FFFD.
+*/
+story::string_t	utf16(const std::string & utf8);
+
+} // end of namespace standin
+} // end of namespace nrsc
\ No newline at end of file
@@ -0,0 +1,178 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <cmath>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IWaxRenderData.h>
+// Library headers
+#include <TabStop.h>
+// Module header
+#include "Style.h"
+#include "Wax.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc::standin;
+
+
+drawing_style::drawing_style(const font & f, const PMReal & point_size)
+: leading(point_size*1.2),
+  alignment(kTextAlignLeft),
+  word_space(0.8, 1.0, 1.33),
+  letter_space(0, 0, 0),
+  glyph_scale(1.0, 1.0, 1.0),
+  indent_left(0),
+  indent_first(0),
+  indent_right(0),
+  tab_interval(36),
+  no_break(kFalse),
+  drop_chars(0),
+  drop_lines(0),
+  _font(f),
+  _point_size(point_size),
+  _instance(f, point_size),
+  _space_glyph(f.glyph(' ')),
+  _space_width(_instance.GetGlyphWidth(_space_glyph))
+{
+}
+
+
+IPMFont * drawing_style::QueryFont() const
+{
+	return const_cast<font *>(&_font);
+}
+
+
+IFontInstance * drawing_style::QueryFontInstance(bool16) const
+{
+	return &_instance;
+}
+
+
+PMReal drawing_style::GetPointSize() const				{ return _point_size; }
+PMReal drawing_style::GetLeading() const				{ return leading; }
+PMReal drawing_style::GetEmSpaceWidth(bool16) const		{ return _point_size; }
+PMReal drawing_style::GetEnSpaceWidth(bool16) const		{ return _point_size/2; }
+PMReal drawing_style::GetSpaceWidth() const				{ return _space_width; }
+Text::GlyphID drawing_style::GetSpaceGlyph() const		{ return _space_glyph; }
+PMReal drawing_style::GetEffectiveBaseline() const		{ return 0; }
+PMReal drawing_style::GetSkewAngle() const				{ return 0; }
+PMReal drawing_style::GetXScale() const					{ return 1.0; }
+PMReal drawing_style::GetYScale() const					{ return 1.0; }
+
+
+bool16 drawing_style::CanShareWaxRunWith(const IDrawingStyle * other) const
+{
+	return other == static_cast<const IDrawingStyle *>(this);
+}
+
+
+void drawing_style::FillOutRenderData(IWaxRenderData * rd, bool16) const
+{
+	wax_run * const wr = dynamic_cast<wax_run *>(rd);
+	if (wr)	wr->set_style(this);
+}
+
+
+void drawing_style::AddAdornments(IWaxRun *) const
+{
+}
+
+
+ICompositionStyle::TextAlignment drawing_style::GetParagraphAlignment() const
+{
+	return alignment;
+}
+
+
+bool16 drawing_style::GetNoBreak() const
+{
+	return no_break;
+}
+
+
+TabStop drawing_style::GetTabStopAfter(const PMReal & position) const
+{
+	// Default tab stops at every multiple of the tab interval.
+	const double n = std::floor(ToDouble(position/tab_interval)) + 1;
+	return TabStop(tab_interval*n);
+}
+
+
+void drawing_style::GetDropCapInfo(int16 * chars, int16 * lines) const
+{
+	if (chars)	*chars = drop_chars;
+	if (lines)	*lines = drop_lines;
+}
+
+
+PMReal drawing_style::IndentLeftBody() const	{ return indent_left; }
+PMReal drawing_style::IndentLeftFirst() const	{ return indent_first; }
+PMReal drawing_style::IndentRightBody() const	{ return indent_right; }
+
+
+void drawing_style::GetWordspace(PMReal * min, PMReal * desired, PMReal * max) const
+{
+	*min = word_space.min; *desired = word_space.desired; *max = word_space.max;
+}
+
+
+void drawing_style::GetLetterspace(PMReal * min, PMReal * desired, PMReal * max) const
+{
+	*min = letter_space.min; *desired = letter_space.desired; *max = letter_space.max;
+}
+
+
+void drawing_style::GetGlyphscale(PMReal * min, PMReal * desired, PMReal * max) const
+{
+	*min = glyph_scale.min; *desired = glyph_scale.desired; *max = glyph_scale.max;
+}
+
+
+PMReal drawing_style::GetAlteredWordspace() const
+{
+	return _space_width*word_space.desired;
+}
+
+
+PMReal drawing_style::GetAlteredLetterspace(bool16) const
+{
+	return _space_width*letter_space.desired;
+}
+
+
+bool16 drawing_style::GetAlignOnlyFirstLine() const
+{
+	return kFalse;
+}
+
+
+Text::GridAlignmentMetric drawing_style::GetGridAlignmentMetric() const
+{
+	return Text::kGANone;
+}
@@ -0,0 +1,136 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <ICompositionStyle.h>
+#include <IDrawingStyle.h>
+#include <IGridRelatedStyle.h>
+#include <IJustificationStyle.h>
+// Library headers
+// Module header
+#include "Font.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+namespace nrsc
+{
+namespace standin
+{
+
+/** The character and paragraph attributes of a span of text. One object 
+	answers for all the style interfaces the layout engine queries a drawing 
+	style for. Lifetime is owned by the host, reference counting is a no-op.
+*/
+class drawing_style : public IDrawingStyle, 
+					  public ICompositionStyle, 
+					  public IJustificationStyle, 
+					  public IGridRelatedStyle
+{
+public:
+	/** Justification limits as fractions of the natural width.
+	*/
+	struct range
+	{
+		PMReal	min, desired, max;
+
+		range(const PMReal & mn, const PMReal & d, const PMReal & mx) : min(mn), desired(d), max(mx) {}
+	};
+
+	drawing_style(const font & f, const PMReal & point_size);
+
+	// Settings
+	PMReal			leading;
+	TextAlignment	alignment;
+	range			word_space,
+					letter_space,
+					glyph_scale;
+	PMReal			indent_left,
+					indent_first,
+					indent_right,
+					tab_interval;
+	bool16			no_break;
+	int16			drop_chars,
+					drop_lines;
+
+	// IPMUnknown
+	void	AddRef() const	{}
+	void	Release() const	{}
+
+	// IDrawingStyle
+	IPMFont		  *	QueryFont() const;
+	IFontInstance *	QueryFontInstance(bool16 vertical) const;
+	PMReal			GetPointSize() const;
+	PMReal			GetLeading() const;
+	PMReal			GetEmSpaceWidth(bool16 vertical) const;
+	PMReal			GetEnSpaceWidth(bool16 vertical) const;
+	PMReal			GetSpaceWidth() const;
+	Text::GlyphID	GetSpaceGlyph() const;
+	PMReal			GetEffectiveBaseline() const;
+	PMReal			GetSkewAngle() const;
+	PMReal			GetXScale() const;
+	PMReal			GetYScale() const;
+	bool16			CanShareWaxRunWith(const IDrawingStyle * other) const;
+	void			FillOutRenderData(IWaxRenderData * rd, bool16 vertical) const;
+	void			AddAdornments(IWaxRun * run) const;
+
+	// ICompositionStyle
+	TextAlignment	GetParagraphAlignment() const;
+	bool16			GetNoBreak() const;
+	TabStop			GetTabStopAfter(const PMReal & position) const;
+	void			GetDropCapInfo(int16 * chars, int16 * lines) const;
+	PMReal			IndentLeftBody() const;
+	PMReal			IndentLeftFirst() const;
+	PMReal			IndentRightBody() const;
+
+	// IJustificationStyle
+	void	GetWordspace(PMReal * min, PMReal * desired, PMReal * max) const;
+	void	GetLetterspace(PMReal * min, PMReal * desired, PMReal * max) const;
+	void	GetGlyphscale(PMReal * min, PMReal * desired, PMReal * max) const;
+	PMReal	GetAlteredWordspace() const;
+	PMReal	GetAlteredLetterspace(bool16 vertical) const;
+
+	// IGridRelatedStyle
+	bool16						GetAlignOnlyFirstLine() const;
+	Text::GridAlignmentMetric	GetGridAlignmentMetric() const;
+
+	// Properties
+	const font &	get_font() const	{ return _font; }
+
+private:
+	const font &			_font;
+	PMReal					_point_size;
+	mutable font_instance	_instance;
+	Text::GlyphID			_space_glyph;
+	PMReal					_space_width;
+};
+
+} // end of namespace standin
+} // end of namespace nrsc
\ No newline at end of file
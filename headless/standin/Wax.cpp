@@ -0,0 +1,307 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+// Interface headers
+#include "VCPlugInHeaders.h"
+// Library headers
+// Module header
+#include "Wax.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc::standin;
+
+
+wax_run::wax_run()
+: _refs(1),
+  _style(nil)
+{
+}
+
+
+wax_run::~wax_run()
+{
+}
+
+
+void wax_run::AddRef() const
+{
+	++_refs;
+}
+
+
+void wax_run::Release() const
+{
+	if (--_refs == 0)
+		delete this;
+}
+
+
+void wax_run::AddGlyph(Text::GlyphID id, float width)
+{
+	const glyph g = {id, width, 0, 0};
+	_glyphs.push_back(g);
+}
+
+
+void wax_run::AddMappingWidth(const PMReal & width)
+{
+	mapping m = {width, 0, 0};
+	_mappings.push_back(m);
+}
+
+
+void wax_run::AddMappingRange(int32 char_index, int32 glyph_index, int32 num_glyphs)
+{
+	if (char_index < 0 || size_t(char_index) >= _mappings.size())
+		return;
+
+	mapping & m = _mappings[char_index];
+	m.glyph_index = glyph_index;
+	m.num_glyphs  = num_glyphs;
+}
+
+
+PMMatrix wax_run::GetAllGlyphsMatrix(PMPoint * origin) const
+{
+	if (origin)	*origin = _origin;
+	return _matrix;
+}
+
+
+void wax_run::SetAllGlyphsMatrix(const PMMatrix & m, const PMPoint & origin)
+{
+	_matrix = m;
+	_origin = origin;
+}
+
+
+void wax_run::AddGlyphMEData(int32 n, const float * x_offsets, const float * y_offsets, const float *)
+{
+	// The offsets apply to the last n glyphs added.
+	if (n < 0 || size_t(n) > _glyphs.size())
+		return;
+
+	glyphs_t::iterator g = _glyphs.end() - n;
+	for (int32 i = 0; i != n; ++i, ++g)
+	{
+		g->x_offset = x_offsets[i];
+		g->y_offset = y_offsets[i];
+	}
+}
+
+
+
+wax_line::wax_line()
+: _refs(1),
+  _start(0),
+  _composed(0),
+  _no_shuffle(kFalse),
+  _drop_cap_count(0),
+  _drop_cap_lines(0),
+  _TOF_metric(Text::kFLOLeading),
+  _leading_model(Text::kRomanLeadingModel),
+  _grid_metric(Text::kGANone),
+  _at_TOF(kFalse),
+  _parcel_position_dependent(kFalse),
+  _line(nil)
+{
+}
+
+
+wax_line::~wax_line()
+{
+	clear_runs();
+}
+
+
+void wax_line::clear_runs()
+{
+	for (runs_t::iterator r = _runs.begin(), r_e = _runs.end(); r != r_e; ++r)
+		(*r)->Release();
+	_runs.clear();
+}
+
+
+int32 wax_line::span() const
+{
+	int32 n = 0;
+	for (tiles_t::const_iterator t = _tiles.begin(), t_e = _tiles.end(); t != t_e; ++t)
+		n += t->span;
+	return n;
+}
+
+
+void wax_line::AddRef() const
+{
+	++_refs;
+}
+
+
+void wax_line::Release() const
+{
+	if (--_refs == 0)
+		delete this;
+}
+
+
+int32 wax_line::GetNumberOfTiles() const
+{
+	return int32(_tiles.size());
+}
+
+
+void wax_line::SetNumberOfTiles(int32 n)
+{
+	const tile t = {0, 0, 0};
+	_tiles.resize(n, t);
+}
+
+
+void wax_line::SetNoShuffle(bool16 no_shuffle)
+{
+	_no_shuffle = no_shuffle;
+}
+
+
+int32 wax_line::GetTextSpanInTile(int32 tile) const
+{
+	return _tiles[tile].span;
+}
+
+
+void wax_line::SetTextSpanInTile(int32 span, int32 tile)
+{
+	_tiles[tile].span = span;
+}
+
+
+PMReal wax_line::GetXPosition(int32 tile) const
+{
+	return size_t(tile) < _tiles.size() ? _tiles[tile].x : PMReal(0);
+}
+
+
+void wax_line::SetXPosition(const PMReal & x, int32 tile)
+{
+	_tiles[tile].x = x;
+}
+
+
+PMReal wax_line::GetTargetWidth(int32 tile) const
+{
+	return _tiles[tile].width;
+}
+
+
+void wax_line::SetTargetWidth(const PMReal & w, int32 tile)
+{
+	_tiles[tile].width = w;
+}
+
+
+int32 wax_line::GetDropCapIndents(PMReal * indents, int32 * lines) const
+{
+	if (_drop_cap_count > 0)
+	{
+		if (indents)	*indents = _drop_cap_indent;
+		if (lines)		*lines   = _drop_cap_lines;
+	}
+	return _drop_cap_count;
+}
+
+
+void wax_line::SetDropCapIndents(int32 n, const PMReal * indents, const int32 * lines)
+{
+	_drop_cap_count = n > 0 ? 1 : 0;
+	if (_drop_cap_count)
+	{
+		_drop_cap_indent = indents[0];
+		_drop_cap_lines  = lines[0];
+	}
+}
+
+
+bool16 wax_line::GetNextLineAffectedByDropcap() const
+{
+	return _drop_cap_count > 0 && _drop_cap_lines > 1;
+}
+
+
+PMReal wax_line::GetYPosition() const				{ return _y; }
+PMReal wax_line::GetYAdvance() const				{ return _line_height; }
+void wax_line::SetCompositionYPosition(const PMReal & y)	{ _y = y; }
+void wax_line::SetLineHeight(const PMReal & h)		{ _line_height = h; }
+
+
+void wax_line::SetTOFLineHeight(const PMReal & h, Text::FirstLineOffsetMetric metric)
+{
+	_TOF_height = h;
+	_TOF_metric = metric;
+}
+
+
+void wax_line::SetLeadingModel(Text::LeadingModel model)
+{
+	_leading_model = model;
+}
+
+
+void wax_line::SetGridAlignment(Text::GridAlignmentMetric metric, const PMReal & offset)
+{
+	_grid_metric = metric;
+	_grid_offset = offset;
+}
+
+
+void wax_line::SetParcelKey(const ParcelKey & key)				{ _parcel = key; }
+void wax_line::SetAtTOF(bool16 at_top)							{ _at_TOF = at_top; }
+void wax_line::SetParcelPositionDependent(bool16 dependent)		{ _parcel_position_dependent = dependent; }
+
+
+IWaxLine * wax_line::GetWaxLine() const
+{
+	return const_cast<IWaxLine *>(_line);
+}
+
+
+void wax_line::SetWaxLine(const IWaxLine * line)
+{
+	_line = line;
+}
+
+
+void wax_line::AddRun(IWaxRun * run)
+{
+	// The collection adopts the reference wax_run() hands back.
+	if (run)	_runs.push_back(run);
+}
+
+
+void wax_line::ConstructionComplete()
+{
+}
@@ -0,0 +1,240 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <vector>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IInlineGraphic.h>
+#include <IWaxCollection.h>
+#include <IWaxGlyphs.h>
+#include <IWaxGlyphsME.h>
+#include <IWaxLine.h>
+#include <IWaxRenderData.h>
+#include <IWaxRun.h>
+// Library headers
+// Module header
+#include "Fingerprint.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+namespace nrsc
+{
+namespace standin
+{
+class drawing_style;
+
+/** A reference counted composed run of glyphs. Positions are relative to 
+	the wax line's origin.
+*/
+class wax_run : public IWaxRun, 
+				public IWaxRenderData, 
+				public IWaxGlyphs, 
+				public IWaxGlyphsME, 
+				public IInlineGraphic
+{
+public:
+	struct glyph
+	{
+		Text::GlyphID	id;
+		float			advance,
+						x_offset,
+						y_offset;
+	};
+
+	struct mapping
+	{
+		PMReal	width;
+		int32	glyph_index,
+				num_glyphs;
+	};
+
+	typedef std::vector<glyph>		glyphs_t;
+	typedef std::vector<mapping>	mappings_t;
+
+	wax_run();
+
+	// IPMUnknown
+	void	AddRef() const;
+	void	Release() const;
+
+	// IWaxRun
+	PMReal	GetXPosition() const				{ return _x; }
+	void	SetXPosition(const PMReal & x)		{ _x = x; }
+	PMReal	GetYPosition() const				{ return _y; }
+	void	SetYPosition(const PMReal & y)		{ _y = y; }
+
+	// IWaxGlyphs
+	void		AddGlyph(Text::GlyphID id, float width);
+	void		AddMappingWidth(const PMReal & width);
+	void		AddMappingRange(int32 char_index, int32 glyph_index, int32 num_glyphs);
+	PMMatrix	GetAllGlyphsMatrix(PMPoint * origin) const;
+	void		SetAllGlyphsMatrix(const PMMatrix & m, const PMPoint & origin);
+
+	// IWaxGlyphsME
+	void	AddGlyphMEData(int32 n, const float * x_offsets, const float * y_offsets, const float * widths);
+
+	// IInlineGraphic
+	void	SetGraphic(const UIDRef & graphic)	{ _graphic = graphic; }
+
+	// Properties
+	void					set_style(const drawing_style * ds)	{ _style = ds; }
+	const drawing_style *	style() const		{ return _style; }
+	const glyphs_t &		glyphs() const		{ return _glyphs; }
+	const mappings_t &		mappings() const	{ return _mappings; }
+	const PMMatrix &		matrix() const		{ return _matrix; }
+	const UIDRef &			graphic() const		{ return _graphic; }
+
+private:
+	~wax_run();
+
+	// Hide copy constructor and assignment operator.
+	wax_run(const wax_run &);
+	wax_run & operator = (const wax_run &);
+
+	mutable int				_refs;
+	PMReal					_x, _y;
+	const drawing_style	  *	_style;
+	glyphs_t				_glyphs;
+	mappings_t				_mappings;
+	PMMatrix				_matrix;
+	PMPoint					_origin;
+	UIDRef					_graphic;
+};
+
+
+/** A reference counted composed line and the collection of wax runs 
+	rebuilt on it.
+*/
+class wax_line : public IWaxLine, public IWaxCollection
+{
+public:
+	struct tile
+	{
+		int32	span;
+		PMReal	x,
+				width;
+	};
+
+	typedef std::vector<tile>		tiles_t;
+	typedef std::vector<IWaxRun *>	runs_t;
+
+	wax_line();
+
+	/** Release the wax runs so the line can be rebuilt.
+	*/
+	void	clear_runs();
+
+	// Properties
+	TextIndex			start() const				{ return _start; }
+	void				set_start(TextIndex ti)		{ _start = ti; }
+	int32				span() const;
+	const tiles_t &		tiles() const				{ return _tiles; }
+	const runs_t &		runs() const				{ return _runs; }
+	PMReal				line_height() const			{ return _line_height; }
+	PMReal				tile_height() const			{ return _tile_height; }
+	void				set_tile_height(const PMReal & h)	{ _tile_height = h; }
+	// The fingerprint of the line as compose_line left it.
+	fingerprint::value_t	composed() const		{ return _composed; }
+	void				set_composed(fingerprint::value_t fp)	{ _composed = fp; }
+
+	/** Whether the host may move the line up or down the parcel without 
+		composing it again.
+	*/
+	bool				can_shuffle() const			{ return !_no_shuffle && !_at_TOF && !_parcel_position_dependent; }
+
+	// IPMUnknown
+	void	AddRef() const;
+	void	Release() const;
+
+	// IWaxLine
+	int32	GetNumberOfTiles() const;
+	void	SetNumberOfTiles(int32 n);
+	void	SetNoShuffle(bool16 no_shuffle);
+	int32	GetTextSpanInTile(int32 tile) const;
+	void	SetTextSpanInTile(int32 span, int32 tile);
+	PMReal	GetXPosition(int32 tile = 0) const;
+	void	SetXPosition(const PMReal & x, int32 tile);
+	PMReal	GetTargetWidth(int32 tile) const;
+	void	SetTargetWidth(const PMReal & w, int32 tile);
+
+	int32	GetDropCapIndents(PMReal * indents = nil, int32 * lines = nil) const;
+	void	SetDropCapIndents(int32 n, const PMReal * indents, const int32 * lines);
+	bool16	GetNextLineAffectedByDropcap() const;
+
+	PMReal	GetYPosition() const;
+	PMReal	GetYAdvance() const;
+	void	SetCompositionYPosition(const PMReal & y);
+	void	SetLineHeight(const PMReal & h);
+	void	SetTOFLineHeight(const PMReal & h, Text::FirstLineOffsetMetric metric);
+	void	SetLeadingModel(Text::LeadingModel model);
+	void	SetGridAlignment(Text::GridAlignmentMetric metric, const PMReal & offset);
+
+	void	SetParcelKey(const ParcelKey & key);
+	void	SetAtTOF(bool16 at_top);
+	void	SetParcelPositionDependent(bool16 dependent);
+
+	// IWaxCollection
+	IWaxLine *	GetWaxLine() const;
+	void		SetWaxLine(const IWaxLine * line);
+	void		AddRun(IWaxRun * run);
+	void		ConstructionComplete();
+
+private:
+	~wax_line();
+
+	// Hide copy constructor and assignment operator.
+	wax_line(const wax_line &);
+	wax_line & operator = (const wax_line &);
+
+	mutable int		_refs;
+	TextIndex		_start;
+	fingerprint::value_t	_composed;
+	tiles_t			_tiles;
+	bool16			_no_shuffle;
+	int32			_drop_cap_count,
+					_drop_cap_lines;
+	PMReal			_drop_cap_indent,
+					_y,
+					_line_height,
+					_tile_height,
+					_TOF_height;
+	Text::FirstLineOffsetMetric	_TOF_metric;
+	Text::LeadingModel			_leading_model;
+	Text::GridAlignmentMetric	_grid_metric;
+	PMReal			_grid_offset;
+	ParcelKey		_parcel;
+	bool16			_at_TOF,
+					_parcel_position_dependent;
+	const IWaxLine *	_line;
+	runs_t			_runs;
+};
+
+} // end of namespace standin
+} // end of namespace nrsc
\ No newline at end of file
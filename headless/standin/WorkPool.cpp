@@ -0,0 +1,126 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+// Interface headers
+// Library headers
+// Module header
+#include "WorkPool.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc::standin;
+
+
+work_pool::work_pool(unsigned int threads)
+: _queues(threads ? threads : 1),
+  _stopping(false)
+{
+}
+
+
+work_pool::~work_pool()
+{
+	stop();
+}
+
+
+void work_pool::start(size_t n, const task_fn & task)
+{
+	stop();
+
+	_task = task;
+	_stopping = false;
+	_states.reset(new std::atomic<int>[n]);
+	for (size_t i = 0; i != n; ++i)
+	{
+		_states[i] = pending;
+		_queues[i % _queues.size()].tasks.push_back(i);
+	}
+
+	for (size_t w = 0; w != _queues.size(); ++w)
+		_threads.push_back(std::thread(&work_pool::work, this, w));
+}
+
+
+bool work_pool::claim(size_t i)
+{
+	int expected = pending;
+	return _states[i].compare_exchange_strong(expected, running);
+}
+
+
+void work_pool::wait(size_t i)
+{
+	std::unique_lock<std::mutex> lock(_done_lock);
+	_done.wait(lock, [&]() { return _states[i] == done; });
+}
+
+
+void work_pool::stop()
+{
+	_stopping = true;
+	for (size_t w = 0; w != _threads.size(); ++w)
+		_threads[w].join();
+	_threads.clear();
+
+	for (size_t w = 0; w != _queues.size(); ++w)
+		_queues[w].tasks.clear();
+}
+
+
+void work_pool::work(size_t w)
+{
+	for (size_t i; !_stopping && take(w, i);)
+	{
+		if (!claim(i))	continue;
+
+		_task(i);
+		{
+			std::lock_guard<std::mutex> lock(_done_lock);
+			_states[i] = done;
+		}
+		_done.notify_all();
+	}
+}
+
+
+// The next task from this thread's own queue, else one stolen from the 
+// back of another's.
+bool work_pool::take(size_t w, size_t & i)
+{
+	for (size_t n = 0; n != _queues.size(); ++n)
+	{
+		queue & q = _queues[(w + n) % _queues.size()];
+		std::lock_guard<std::mutex> lock(q.lock);
+		if (q.tasks.empty())	continue;
+
+		if (n == 0)	{ i = q.tasks.front(); q.tasks.pop_front(); }
+		else		{ i = q.tasks.back();  q.tasks.pop_back(); }
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,107 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+// Interface headers
+// Library headers
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+namespace nrsc
+{
+namespace standin
+{
+
+/** A set of threads working through numbered tasks. Tasks are dealt out 
+	round robin, and each thread runs its own in number order, stealing 
+	from the far end of another's queue when it runs out, so tasks tend to 
+	finish in about the order they are wanted. The thread that started the 
+	work may claim any task that has not been started to run itself.
+*/
+class work_pool
+{
+public:
+	typedef std::function<void (size_t)>	task_fn;
+
+	explicit work_pool(unsigned int threads);
+	~work_pool();
+
+	/** Start running task(0) to task(n-1) on the pool's threads.
+	*/
+	void	start(size_t n, const task_fn & task);
+
+	/** Take task i from the pool.
+		@return false if a pool thread has already started it.
+	*/
+	bool	claim(size_t i);
+
+	/** Wait for a task started by a pool thread to finish.
+	*/
+	void	wait(size_t i);
+
+	/** Drop the tasks not started yet and wait for those running.
+	*/
+	void	stop();
+
+private:
+	enum state_t { pending, running, done };
+
+	struct queue
+	{
+		std::mutex			lock;
+		std::deque<size_t>	tasks;
+	};
+
+	// Hide copy constructor and assignment operator.
+	work_pool(const work_pool &);
+	work_pool & operator = (const work_pool &);
+
+	void	work(size_t w);
+	bool	take(size_t w, size_t & i);
+
+	std::vector<queue>			_queues;
+	std::vector<std::thread>	_threads;
+	std::unique_ptr<std::atomic<int>[]>	_states;
+	task_fn						_task;
+	std::atomic<bool>			_stopping;
+	std::mutex					_done_lock;
+	std::condition_variable		_done;
+};
+
+} // end of namespace standin
+} // end of namespace nrsc
\ No newline at end of file
@@ -0,0 +1,1188 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* grind-bench: micro and paragraph benchmarks for the layout engine.
+
+Measures shaping (graphite_run and fallback_run filling, which is their 
+layout_span plus control character handling), tile::break_into, 
+tile::justify, tile::apply_tab_widths and full paragraph composition 
+through the headless composer. Each is parameterised by script, paragraph 
+length in words and, where it matters, alignment and tab density.
+
+Paragraphs are generated deterministically from a small embedded word list 
+for each script. Fonts are not part of the repository; a script is 
+benchmarked when a font for it is given with --font script=FILE. Graphite 
+shaping is skipped for fonts Graphite cannot load.
+
+Results are written to stdout as a JSON array, one object per measurement.
+Builds with GRIND_ALLOCATIONS on also report the allocations one operation 
+makes, in total and by composer phase and object kind; for compose that is 
+per paragraph.
+
+Classify times sorting a paragraph's code units into spaces and break 
+opportunities as fallback runs do, with a Latin-1 table and SSE2, and 
+classify_each the per character ICU calls it replaced, which must agree 
+on every code unit.
+
+Justify results are checked against the switch based stretch totals and 
+width adjustment that glyf::stretch_classes and the kern table in 
+run::adjust_widths replaced, which must agree bit for bit.
+
+Render hands the runs of a shaped paragraph to stand-in wax runs, which 
+only store what they are given, so what it measures is assembling each 
+run's glyph batch and the host calls that submit it.
+
+Edit measures typing a character into the middle of a composed paragraph 
+and deleting it again, recomposing incrementally after each and 
+rebuilding the lines that came out different. The wax lines and runs 
+recomposing keeps must be those composing afresh gives, which is checked 
+after typing mid-paragraph, changing a paragraph's first line and 
+breaking a paragraph in two and joining it again, hyphenating too given 
+patterns.
+
+Measure breaks an already shaped paragraph into lines with 
+nrsc::measurer, which must break it where composing it does. Copyfit 
+finds the tracking that sets a paragraph in a tenth fewer lines, which 
+composing with that tracking must then do. Balance composes heading and 
+caption length paragraphs with their rag balanced, whatever --words asks 
+for, which must not change how many lines they take.
+
+Given hyphenation patterns for a script with --patterns SCRIPT=FILE, 
+hyphen_load measures loading them, hyphen_map using the image compiled 
+from them in place, as from a memory mapped grind-patterns file, 
+hyphen_verify checking that image through, as is done once when it is 
+compiled, 
+hyphenate looking up every word of the paragraph with nothing memoized 
+and hyphenate_cached with every word memoized, both also reported as 
+lookups per second, and hyphen_compose composing with hyphenation, which 
+measuring must again agree with.
+
+Compose results carry the fingerprint of the paragraph's layout, edit 
+results that of the paragraph recomposed after typing, which must match 
+composing the edited paragraph afresh. Given 
+--golden FILE, a results file from an earlier run, each compose fingerprint 
+is checked against the one for the same parameters there and grind-bench 
+exits with status 1 if any differ, so a speed up can be shown not to have 
+changed the output.
+*/
+
+// Language headers
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+// Interface headers
+#include "VCPlugInHeaders.h"
+// Library headers
+// Module header
+#include "Allocations.h"
+#include "Composer.h"
+#include "Copyfit.h"
+#include "FallbackRun.h"
+#include "Fingerprint.h"
+#include "Font.h"
+#include "GlyphBatch.h"
+#include "GraphiteRun.h"
+#include "GrFaceCache.h"
+#include "Hyphenator.h"
+#include "Measure.h"
+#include "Story.h"
+#include "StyleRuns.h"
+#include "Style.h"
+#include "Tile.h"
+#include "Wax.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+using namespace nrsc::standin;
+
+namespace
+{
+	typedef std::chrono::steady_clock	bench_clock;
+	typedef std::chrono::nanoseconds	ns_t;
+
+	struct script_sample
+	{
+		const char * name;
+		const char * words;
+	};
+
+	// Space separated words, roughly Genesis 1:1-2 in each script.
+	const script_sample samples[] =
+	{
+		{"latin",		"in the beginning God created the heaven and the earth and the earth was "
+						"without form and void and darkness was upon the face of the deep"},
+		{"arabic",		"\xd9\x81\xd9\x8a \xd8\xa7\xd9\x84\xd8\xa8\xd8\xaf\xd8\xa1 \xd8\xae\xd9\x84\xd9\x82 "
+						"\xd8\xa7\xd9\x84\xd9\x84\xd9\x87 \xd8\xa7\xd9\x84\xd8\xb3\xd9\x85\xd8\xa7\xd9\x88\xd8\xa7\xd8\xaa "
+						"\xd9\x88\xd8\xa7\xd9\x84\xd8\xa3\xd8\xb1\xd8\xb6 \xd9\x88\xd9\x83\xd8\xa7\xd9\x86\xd8\xaa "
+						"\xd8\xa7\xd9\x84\xd8\xa3\xd8\xb1\xd8\xb6 \xd8\xae\xd8\xb1\xd8\xa8\xd8\xa9 \xd9\x88\xd8\xae\xd8\xa7\xd9\x84\xd9\x8a\xd8\xa9 "
+						"\xd9\x88\xd8\xb9\xd9\x84\xd9\x89 \xd9\x88\xd8\xac\xd9\x87 \xd8\xa7\xd9\x84\xd8\xba\xd9\x85\xd8\xb1 \xd8\xb8\xd9\x84\xd9\x85\xd8\xa9"},
+		{"devanagari",	"\xe0\xa4\x86\xe0\xa4\xa6\xe0\xa4\xbf \xe0\xa4\xae\xe0\xa5\x87\xe0\xa4\x82 "
+						"\xe0\xa4\xaa\xe0\xa4\xb0\xe0\xa4\xae\xe0\xa5\x87\xe0\xa4\xb6\xe0\xa5\x8d\xe0\xa4\xb5\xe0\xa4\xb0 "
+						"\xe0\xa4\xa8\xe0\xa5\x87 \xe0\xa4\x86\xe0\xa4\x95\xe0\xa4\xbe\xe0\xa4\xb6 \xe0\xa4\x94\xe0\xa4\xb0 "
+						"\xe0\xa4\xaa\xe0\xa5\x83\xe0\xa4\xa5\xe0\xa5\x8d\xe0\xa4\xb5\xe0\xa5\x80 \xe0\xa4\x95\xe0\xa5\x80 "
+						"\xe0\xa4\xb8\xe0\xa5\x83\xe0\xa4\xb7\xe0\xa5\x8d\xe0\xa4\x9f\xe0\xa4\xbf "
+						"\xe0\xa4\xac\xe0\xa5\x87\xe0\xa4\xa1\xe0\xa5\x8c\xe0\xa4\xb2 "
+						"\xe0\xa4\xb8\xe0\xa5\x81\xe0\xa4\xa8\xe0\xa4\xb8\xe0\xa4\xbe\xe0\xa4\xa8 "
+						"\xe0\xa4\xaa\xe0\xa4\xa1\xe0\xa4\xbc\xe0\xa5\x80 \xe0\xa4\xa5\xe0\xa5\x80"},
+		{"myanmar",		"\xe1\x80\xa1\xe1\x80\x85\xe1\x80\xa1\xe1\x80\x9b\xe1\x80\xbe\xe1\x80\xac\xe1\x80\xb8 "
+						"\xe1\x80\x98\xe1\x80\xaf\xe1\x80\x9b\xe1\x80\xac\xe1\x80\xb8\xe1\x80\x9e\xe1\x80\x81\xe1\x80\x84\xe1\x80\xba "
+						"\xe1\x80\x80\xe1\x80\xad\xe1\x80\xaf \xe1\x80\x80\xe1\x80\xbb\xe1\x80\xad\xe1\x80\xaf\xe1\x80\xb8 "
+						"\xe1\x80\x80\xe1\x80\xb1\xe1\x80\xac\xe1\x80\x84\xe1\x80\xba\xe1\x80\xb8\xe1\x80\x80\xe1\x80\x84\xe1\x80\xba "
+						"\xe1\x80\x94\xe1\x80\xbe\xe1\x80\x84\xe1\x80\xb7\xe1\x80\xba "
+						"\xe1\x80\x99\xe1\x80\xbc\xe1\x80\xb1\xe1\x80\x80\xe1\x80\xbc\xe1\x80\xae\xe1\x80\xb8 "
+						"\xe1\x80\x96\xe1\x80\x94\xe1\x80\xba\xe1\x80\x86\xe1\x80\x84\xe1\x80\xba\xe1\x80\xb8"},
+		{"ethiopic",	"\xe1\x89\xa0\xe1\x88\x98\xe1\x8c\x80\xe1\x88\x98\xe1\x88\xaa\xe1\x8b\xab "
+						"\xe1\x8a\xa5\xe1\x8c\x8d\xe1\x8b\x9a\xe1\x8a\xa0\xe1\x89\xa5\xe1\x88\x94\xe1\x88\xad "
+						"\xe1\x88\xb0\xe1\x88\x9b\xe1\x8b\xad\xe1\x8a\x95\xe1\x8a\x93 \xe1\x88\x9d\xe1\x8b\xb5\xe1\x88\xad\xe1\x8a\x95 "
+						"\xe1\x8d\x88\xe1\x8c\xa0\xe1\x88\xa8 \xe1\x88\x9d\xe1\x8b\xb5\xe1\x88\xad\xe1\x88\x9d "
+						"\xe1\x89\x85\xe1\x88\xad\xe1\x8d\x85 \xe1\x8b\xa8\xe1\x88\x8c\xe1\x88\x8b\xe1\x89\xb5 "
+						"\xe1\x89\xa3\xe1\x8b\xb6\xe1\x88\x9d \xe1\x8a\x90\xe1\x89\xa0\xe1\x88\xa8\xe1\x89\xbd"}
+	};
+
+
+	struct options
+	{
+		std::map<std::string, std::string>	fonts,
+											patterns;
+		std::vector<int>	lengths;
+		std::string			filter,
+							golden;
+		double				size,
+							width,
+							min_time;
+
+		options() : size(12), width(300), min_time(0.2) {}
+	};
+
+
+	struct params
+	{
+		std::string		bench,
+						script,
+						align;
+		int				words,
+						tab_every;
+	};
+
+
+	struct result
+	{
+		size_t	iterations;
+		double	ns_per_op;
+	};
+
+
+	/* Generate a paragraph of n words picked with a fixed LCG from the 
+	sample, with a tab before every tab_every'th word.
+	*/
+	std::string paragraph(const char * sample, int n, int tab_every)
+	{
+		std::vector<std::string> words;
+		std::istringstream ss(sample);
+		for (std::string w; ss >> w;)
+			words.push_back(w);
+
+		std::string para;
+		unsigned int seed = 12345;
+		for (int i = 0; i != n; ++i)
+		{
+			seed = seed*1103515245 + 12345;
+			if (i)	para += tab_every && i % tab_every == 0 ? '\t' : ' ';
+			para += words[(seed >> 16) % words.size()];
+		}
+		return para + char(kTextChar_CR);
+	}
+
+
+	/* Run op, which times its own operation excluding any set up and 
+	returns the elapsed time, doubling the iteration count until the total 
+	time reaches min_time. Set up can dwarf cheap operations, so wall time 
+	is capped at ten times min_time.
+	*/
+	template <class F>
+	result measure(F op, double min_time)
+	{
+		const ns_t	target = std::chrono::duration_cast<ns_t>(std::chrono::duration<double>(min_time));
+		const bench_clock::time_point	start = bench_clock::now();
+		result		r = {0, 0};
+		for (size_t n = 1;; n *= 2)
+		{
+			ns_t total(0);
+			for (size_t i = 0; i != n; ++i)
+				total += op();
+
+			if (total >= target || bench_clock::now() - start >= 10*target || n >= (size_t(1) << 24))
+			{
+				r.iterations = n;
+				r.ns_per_op  = double(total.count())/n;
+				return r;
+			}
+		}
+	}
+
+
+	/* The switch based stretch accumulation and width adjustment that 
+	cluster::calculate_stretch and run::adjust_widths replaced with tables, 
+	kept to show the tables give bit for bit the same results.
+	*/
+	void switch_stretch(const cluster & cl, const PMReal & space_width, const glyf::stretch & js, glyf::stretch & s)
+	{
+		for (cluster::const_iterator g = cl.begin(), g_e = cl.end(); g != g_e; ++g)
+		{
+			switch(g->justification())
+			{
+			case glyf::fill:
+				s[glyf::fill].min += space_width*js[glyf::fill].min;
+				s[glyf::fill].max += space_width*js[glyf::fill].max;
+				++s[glyf::fill].num;
+				break;
+			case glyf::space:
+				s[glyf::space].min += space_width*js[glyf::space].min;
+				s[glyf::space].max += space_width*js[glyf::space].max;
+				++s[glyf::space].num;
+				// fall through
+			case glyf::letter:
+				s[glyf::letter].min += space_width*js[glyf::letter].min;
+				s[glyf::letter].max += space_width*js[glyf::letter].max;
+				++s[glyf::letter].num;
+				// fall through
+			case glyf::glyph:
+				s[glyf::glyph].min += g->advance()*js[glyf::glyph].min;
+				s[glyf::glyph].max += g->advance()*js[glyf::glyph].max;
+				++s[glyf::glyph].num;
+				break;
+			case glyf::fixed:
+				++s[glyf::fixed].num;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void switch_adjust_widths(run & r, PMReal fill_space, PMReal word_space, PMReal letter_space, PMReal glyph_scale)
+	{
+		for (run::iterator cl = r.begin(), cl_e = r.trailing_whitespace(); cl != cl_e; ++cl)
+		{
+			for (cluster::iterator g = cl->begin(), g_e = cl->end(); g != g_e; ++g)
+			{
+				g->kern(glyph_scale*g->width());
+				g->shift(glyph_scale*g->pos().X());
+
+				switch (g->justification())
+				{
+				case glyf::fill:
+					g->kern(fill_space);
+					break;
+				case glyf::space:
+					g->kern(letter_space + word_space);
+					break;
+				case glyf::letter:
+					g->kern(letter_space);
+					break;
+				case glyf::glyph:
+					g->shift(-letter_space);
+					break;
+				case glyf::fixed:
+					if (g->width() > 0) g->kern(letter_space);
+					break;
+				default: 
+					break;
+				}
+			}
+		}
+
+		for (run::iterator cl = r.trailing_whitespace(), cl_e = r.end(); cl != cl_e; ++cl)
+		{
+			for (cluster::iterator g = cl->begin(), g_e = cl->end(); g != g_e; ++g)
+			{
+				if (g->justification() != glyf::fill) continue;
+
+				g->kern(fill_space);
+			}
+		}
+	}
+
+	bool identical(const PMReal & a, const PMReal & b)
+	{
+		const double	x = ToDouble(a),
+						y = ToDouble(b);
+		return std::memcmp(&x, &y, sizeof x) == 0;
+	}
+
+
+	/* Times an operation, adding the allocations it makes to a tally.
+	*/
+	class stopwatch
+	{
+		allocations::table &	_allocs;
+		allocations::table		_before;
+		bench_clock::time_point	_start;
+
+	public:
+		explicit stopwatch(allocations::table & allocs)
+		: _allocs(allocs)
+		{
+			allocations::snapshot(_before);
+			_start = bench_clock::now();
+		}
+
+		ns_t stop()
+		{
+			const ns_t elapsed = bench_clock::now() - _start;
+			allocations::table after;
+			allocations::snapshot(after);
+			_allocs += after -= _before;
+			return elapsed;
+		}
+	};
+
+
+	class bench_context
+	{
+	public:
+		bench_context(font & f, const options & opts, const params & p, gr_face_cache & faces, const std::string & patterns)
+		: _style(f, opts.size),
+		  _faces(faces),
+		  _width(opts.width),
+		  _patterns(patterns),
+		  _allocs()
+		{
+			_style.alignment = p.align == "justify" ? ICompositionStyle::kTextAlignJustifyLeft 
+							 : p.align == "center"  ? ICompositionStyle::kTextAlignCenter 
+							 : ICompositionStyle::kTextAlignLeft;
+			_text = paragraph(sample_for(p.script), p.words, p.tab_every);
+			_story.append_utf8(_text, _style);
+			_styles.build(_story, 0, _story.length());
+
+			if (!_patterns.empty() && _hyphens.load(_patterns.data(), _patterns.size()))
+			{
+				const unsigned int * const image = static_cast<const unsigned int *>(_hyphens.image());
+				_image.assign(image, image + _hyphens.image_size()/sizeof(unsigned int));
+			}
+			const story::string_t & text = _story.text();
+			for (size_t i = 0, n = text.size(); i != n;)
+			{
+				for (; i != n && !hyphenator::word_char(text[i]); ++i);
+				if (i == n)	break;
+				_words.push_back(hyphenator::word_t());
+				for (; i != n && hyphenator::word_char(text[i]); ++i)
+					_words.back().push_back(text[i]);
+			}
+		}
+
+		static const char * sample_for(const std::string & script)
+		{
+			for (size_t i = 0; i != sizeof samples/sizeof *samples; ++i)
+				if (script == samples[i].name)	return samples[i].words;
+			return samples[0].words;
+		}
+
+		TextIndex	length() const	{ return _story.length(); }
+
+		// Allocations made by the timed part of the operations run so far.
+		allocations::table &	allocs()	{ return _allocs; }
+		gr_face *	face()			{ return _faces[&const_cast<font &>(_style.get_font())]; }
+		const hyphenator *	hyphens() const	{ return _patterns.empty() ? nil : &_hyphens; }
+
+		ns_t	shape_graphite()
+		{
+			TextIterator ti = _story.QueryDataAt(0, nil, nil);
+			stopwatch sw(_allocs);
+			{
+				graphite_run r(face(), &_style);
+				r.fill(ti, length());
+			}
+			return sw.stop();
+		}
+
+		ns_t	shape_fallback()
+		{
+			TextIterator ti = _story.QueryDataAt(0, nil, nil);
+			stopwatch sw(_allocs);
+			{
+				fallback_run r(&_style);
+				r.fill(ti, length());
+			}
+			return sw.stop();
+		}
+
+		// Classify the paragraph's code units as fallback runs do.
+		ns_t	classify()
+		{
+			return classify_with(&fallback_run::classify);
+		}
+
+		// Classify them asking ICU about each one, as fallback runs did.
+		ns_t	classify_each()
+		{
+			return classify_with(&fallback_run::classify_each);
+		}
+
+		// Whether both ways of classifying agree on every code unit.
+		bool	classify_matches() const
+		{
+			const story::string_t &		text = _story.text();
+			std::vector<unsigned char>	bulk(text.size()),
+										each(text.size());
+			fallback_run::classify(text.data(), text.data() + text.size(), bulk.data());
+			fallback_run::classify_each(text.data(), text.data() + text.size(), each.data());
+			return bulk == each;
+		}
+
+		ns_t	break_into()
+		{
+			tile t(region()), rest;
+			t.fill_by_span(_styles, _faces, 0, length());
+			t.apply_tab_widths();
+			stopwatch sw(_allocs);
+			t.break_into(rest, cluster::penalty::letter);
+			return sw.stop();
+		}
+
+		ns_t	justify()
+		{
+			tile t(region()), rest;
+			t.fill_by_span(_styles, _faces, 0, length());
+			t.apply_tab_widths();
+			t.break_into(rest, cluster::penalty::letter);
+			stopwatch sw(_allocs);
+			t.justify(_style.alignment != ICompositionStyle::kTextAlignJustifyLeft);
+			return sw.stop();
+		}
+
+		/* Whether the table driven stretch and width adjustment agree bit 
+		for bit with the switches they replaced, on the paragraph's runs 
+		with a cluster of every justification level added to each.
+		*/
+		bool	stretch_matches()
+		{
+			const glyf::stretch	js = {{0.25, 0.5, 0}, {0.15, 0.33, 0}, {0.05, 0.1, 0}, {0.02, 0.03, 0}, {0, 0, 0}};
+			const PMReal		space_width = _style.GetSpaceWidth();
+			tile t(region());
+			t.fill_by_span(_styles, _faces, 0, length());
+			t.apply_tab_widths();
+
+			bool same = true;
+			for (tile::const_iterator r = t.begin(), r_e = t.end(); r != r_e; ++r)
+			{
+				std::unique_ptr<run>	tables((*r)->copy()),
+									switches((*r)->copy());
+				for (int level = glyf::fill; level <= glyf::tab; ++level)
+				{
+					cluster & cl = *tables->open_cluster();
+					cl.add_glyf(glyf(1, glyf::justification_t(level), 3.7 + level, PMPoint(0.3*level, 0)));
+					cl.add_glyf(glyf(2, glyf::justification_t(level), level == glyf::fixed ? 0 : 1.1, PMPoint(-0.7, 0)));
+					*switches->open_cluster() = cl;
+				}
+
+				glyf::stretch	ts = {{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+								ss = {{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}};
+				for (run::const_iterator cl = tables->begin(), cl_e = tables->end(); cl != cl_e; ++cl)
+				{
+					cl->calculate_stretch(space_width, js, ts);
+					switch_stretch(*cl, space_width, js, ss);
+				}
+				for (int c = glyf::fill; c <= glyf::fixed; ++c)
+					same &= identical(ts[c].min, ss[c].min) && identical(ts[c].max, ss[c].max) && ts[c].num == ss[c].num;
+
+				tables->adjust_widths(1.9, 0.7, 0.13, 0.011);
+				switch_adjust_widths(*switches, 1.9, 0.7, 0.13, 0.011);
+				for (run::const_iterator a = tables->begin(), b = switches->begin(), a_e = tables->end(); a != a_e; ++a, ++b)
+					for (cluster::const_iterator g = a->begin(), h = b->begin(), g_e = a->end(); g != g_e; ++g, ++h)
+						same &= identical(g->width(), h->width()) 
+							 && identical(g->pos().X(), h->pos().X()) 
+							 && identical(g->pos().Y(), h->pos().Y());
+			}
+			return same;
+		}
+
+		ns_t	apply_tab_widths()
+		{
+			tile t(region());
+			t.fill_by_span(_styles, _faces, 0, length());
+			stopwatch sw(_allocs);
+			t.apply_tab_widths();
+			return sw.stop();
+		}
+
+		// Hand every run of the shaped paragraph to a stand-in wax run, as 
+		// rebuilding does, to show the host call overhead per glyph.
+		ns_t	render()
+		{
+			tile t(region());
+			t.fill_by_span(_styles, _faces, 0, length());
+			glyph_batch batch;
+			stopwatch sw(_allocs);
+			for (tile::const_iterator r = t.begin(), r_e = t.end(); r != r_e; ++r)
+			{
+				IWaxRun * const wr = (*r)->wax_run(batch);
+				if (wr)	wr->Release();
+			}
+			return sw.stop();
+		}
+
+		ns_t	compose()
+		{
+			const column	col(_width);
+			composer		comp(_story, col, _faces);
+			stopwatch sw(_allocs);
+			comp.compose();
+			comp.rebuild();
+			return sw.stop();
+		}
+
+		// Compose with the rag balanced.
+		ns_t	balance()
+		{
+			const column	col(_width);
+			composer		comp(_story, col, _faces);
+			comp.set_balance(balance_limits());
+			stopwatch sw(_allocs);
+			comp.compose();
+			comp.rebuild();
+			return sw.stop();
+		}
+
+		// Whether balancing the rag kept the paragraph to as many lines.
+		bool	balance_keeps_lines()
+		{
+			const column	col(_width);
+			composer		greedy(_story, col, _faces),
+							balanced(_story, col, _faces);
+			balanced.set_balance(balance_limits());
+			greedy.compose();
+			balanced.compose();
+			return greedy.lines().size() == balanced.lines().size();
+		}
+
+		// Load the hyphenation patterns afresh.
+		ns_t	hyphen_load()
+		{
+			hyphenator	h;
+			stopwatch sw(_allocs);
+			h.load(_patterns.data(), _patterns.size());
+			return sw.stop();
+		}
+
+		// Check and use the compiled patterns in place.
+		ns_t	hyphen_map()
+		{
+			hyphenator	h;
+			stopwatch sw(_allocs);
+			h.map(&_image[0], _image.size()*sizeof(unsigned int));
+			return sw.stop();
+		}
+
+		// Check the compiled patterns through, as grind-patterns does.
+		ns_t	hyphen_verify()
+		{
+			stopwatch sw(_allocs);
+			hyphenator::verify(&_image[0], _image.size()*sizeof(unsigned int));
+			return sw.stop();
+		}
+
+		// Hyphenate every word of the paragraph, none of them memoized.
+		ns_t	hyphenate()
+		{
+			_hyphens.clear_cache();
+			return lookup_words();
+		}
+
+		// Hyphenate every word of the paragraph, all of them memoized 
+		// after the first run.
+		ns_t	hyphenate_cached()
+		{
+			return lookup_words();
+		}
+
+		ns_t	hyphen_compose()
+		{
+			const column	col(_width);
+			composer		comp(_story, col, _faces);
+			comp.set_hyphenator(&_hyphens);
+			stopwatch sw(_allocs);
+			comp.compose();
+			comp.rebuild();
+			return sw.stop();
+		}
+
+		// Type a character into the middle of the paragraph and delete it 
+		// again, recomposing after each.
+		ns_t	edit()
+		{
+			const column	col(_width);
+			composer		comp(_story, col, _faces);
+			const UTF16TextChar	c = 'x';
+			comp.compose();
+			comp.rebuild();
+
+			stopwatch sw(_allocs);
+			_story.insert(length()/2, &c, 1);
+			comp.recompose();
+			comp.rebuild_pending();
+			_story.erase(length()/2, 1);
+			comp.recompose();
+			comp.rebuild_pending();
+			return sw.stop();
+		}
+
+		// Break the shaped paragraph into lines without composing it.
+		ns_t	measure()
+		{
+			const measurer	m(_story, _faces, 0, length());
+			measurer::lines_t	lines;
+			stopwatch sw(_allocs);
+			m.measure(_width, lines);
+			return sw.stop();
+		}
+
+		// Whether measuring breaks the paragraph where composing it does.
+		bool	measure_matches(const hyphenator * hyphens = nil)
+		{
+			const column	col(_width);
+			composer		comp(_story, col, _faces);
+			const measurer	m(_story, _faces, 0, length(), hyphens);
+			measurer::lines_t	lines;
+			comp.set_hyphenator(hyphens);
+			comp.compose();
+			if (!m.measure(_width, lines) || lines.size() != comp.lines().size())
+				return false;
+			for (size_t i = 0; i != lines.size(); ++i)
+				if (lines[i].start != comp.lines()[i]->start() || lines[i].span != comp.lines()[i]->span())
+					return false;
+			return true;
+		}
+
+		// Find the tracking that takes a tenth of the paragraph's lines off.
+		ns_t	copyfit()
+		{
+			const copyfitter	cf(_story, _faces, 0, length());
+			PMReal				tracking;
+			stopwatch sw(_allocs);
+			cf.solve(copyfitter::tracking, _width, copyfit_target(), -2, 2, tracking);
+			return sw.stop();
+		}
+
+		// Whether composing with the tracking found sets in the lines asked for.
+		bool	copyfit_fits()
+		{
+			const copyfitter	cf(_story, _faces, 0, length());
+			const copyfitter::target	t = copyfit_target();
+			PMReal				tracking;
+			if (!cf.solve(copyfitter::tracking, _width, t, -2, 2, tracking))
+				return false;
+
+			drawing_style	tracked(_style);
+			const PMReal	ls = tracking/_style.GetSpaceWidth();
+			tracked.letter_space = drawing_style::range(_style.letter_space.min + ls, 
+														_style.letter_space.desired + ls, 
+														_style.letter_space.max + ls);
+			story			s;
+			s.append_utf8(_text, tracked);
+			const column	col(_width);
+			composer		comp(s, col, _faces);
+			comp.compose();
+			return comp.lines().size() <= t.lines;
+		}
+
+		// The fingerprint of the composed paragraph, outside of any timing.
+		fingerprint::value_t	layout_fingerprint(const hyphenator * hyphens = nil)
+		{
+			const column	col(_width);
+			composer		comp(_story, col, _faces);
+			composer::fingerprints_t	fps;
+			comp.set_hyphenator(hyphens);
+			comp.compose();
+			comp.rebuild(&fps);
+			return fps.empty() ? 0 : fps.front();
+		}
+
+		/* The fingerprint of the paragraph recomposed after the edit, or 0 
+		if that differs from composing the edited paragraph afresh.
+		*/
+		fingerprint::value_t	edit_fingerprint()
+		{
+			const column	col(_width);
+			composer		comp(_story, col, _faces);
+			composer::fingerprints_t	fps;
+			const UTF16TextChar	c = 'x';
+			comp.compose();
+			comp.rebuild();
+			_story.insert(length()/2, &c, 1);
+			comp.recompose();
+			comp.rebuild_pending();
+			comp.rebuild(&fps);
+
+			const fingerprint::value_t	edited = layout_fingerprint();
+			_story.erase(length()/2, 1);
+			return fps.empty() || fps.front() != edited ? 0 : edited;
+		}
+
+		/* Whether the wax recompose() leaves, kept lines and all, is what 
+		composing afresh gives, after each of a run of edits to three 
+		copies of the paragraph: typing in the middle of the first, 
+		widening some characters on the last one's first line, breaking the 
+		first in two and joining it up again. Given patterns, this is 
+		checked again hyphenating. Both are checked again shaping ahead, 
+		where the edits land in paragraphs already shaped.
+		*/
+		bool	reuse_matches()
+		{
+			for (unsigned int look_ahead = 0; look_ahead <= 2; look_ahead += 2)
+				if (!reuse_matches(nil, look_ahead) 
+				 || (hyphens() != nil && !reuse_matches(hyphens(), look_ahead)))
+					return false;
+			return true;
+		}
+
+	private:
+		PMRect	region() const	{ return PMRect(0, 0, _width, _style.leading); }
+
+		bool	reuse_matches(const hyphenator * hyphens, unsigned int look_ahead)
+		{
+			const column	col(_width);
+			story			s;
+			s.append_utf8(_text + '\r' + _text + '\r' + _text, _style);
+			composer		comp(s, col, _faces, 1, look_ahead);
+			comp.set_hyphenator(hyphens);
+			comp.compose();
+			comp.rebuild();
+
+			const UTF16TextChar	x = 'x', 
+								cr = kTextChar_CR;
+			comp.shape_ahead(0);
+			s.insert(length()/2, &x, 1);
+			if (!recomposed_matches(comp, s, hyphens))	return false;
+
+			// The same length, so what was shaped ahead still fits it.
+			const TextIndex	last = s.paragraph_start(s.length() - 1),
+							wide = std::min<TextIndex>(8, s.length() - last - 2);
+			const std::vector<UTF16TextChar>	w(wide, 'W');
+			comp.shape_ahead(last);
+			s.erase(last + 2, wide);
+			s.insert(last + 2, w.data(), wide);
+			if (!recomposed_matches(comp, s, hyphens))	return false;
+
+			// After a word a third of the way into the first paragraph.
+			TextIndex	split = std::max<TextIndex>(1, length()/3);
+			while (split < length() && s.text()[split - 1] != ' ')	++split;
+			comp.shape_ahead(0);
+			s.insert(split, &cr, 1);
+			if (!recomposed_matches(comp, s, hyphens))	return false;
+
+			comp.shape_ahead(0);
+			s.erase(split, 1);
+			return recomposed_matches(comp, s, hyphens);
+		}
+
+		bool	recomposed_matches(composer & comp, story & s, const hyphenator * hyphens)
+		{
+			comp.recompose();
+			comp.rebuild_pending();
+			composer::fingerprints_t	kept, fresh;
+			comp.fingerprint_wax(kept);
+
+			const column	col(_width);
+			composer		afresh(s, col, _faces);
+			afresh.set_hyphenator(hyphens);
+			afresh.compose();
+			afresh.rebuild();
+			afresh.fingerprint_wax(fresh);
+			return kept == fresh;
+		}
+
+		ns_t	classify_with(void (* classify)(const textchar *, const textchar *, unsigned char *))
+		{
+			const story::string_t &		text = _story.text();
+			std::vector<unsigned char>	classes(text.size());
+			stopwatch sw(_allocs);
+			classify(text.data(), text.data() + text.size(), classes.data());
+			return sw.stop();
+		}
+
+		ns_t	lookup_words()
+		{
+			hyphenator::points_t	points;
+			stopwatch sw(_allocs);
+			for (std::vector<hyphenator::word_t>::const_iterator w = _words.begin(), w_e = _words.end(); w != w_e; ++w)
+				_hyphens.hyphenate(&(*w)[0], w->size(), points);
+			return sw.stop();
+		}
+
+		static nrsc::balance_limits	balance_limits()
+		{
+			const nrsc::balance_limits	limits = { 400, 8 };
+			return limits;
+		}
+
+		copyfitter::target	copyfit_target()
+		{
+			const column	col(_width);
+			composer		comp(_story, col, _faces);
+			comp.compose();
+			const copyfitter::target	t = { std::max<size_t>(1, comp.lines().size()*9/10), 0 };
+			return t;
+		}
+
+		drawing_style	_style;
+		story			_story;
+		style_runs		_styles;
+		gr_face_cache &	_faces;
+		PMReal			_width;
+		std::string		_text;
+		const std::string &	_patterns;
+		hyphenator		_hyphens;
+		std::vector<unsigned int>	_image;
+		std::vector<hyphenator::word_t>	_words;
+		allocations::table	_allocs;
+	};
+
+
+	void usage()
+	{
+		std::cerr << 
+			"usage: grind-bench --font SCRIPT=FILE... [options]\n"
+			"  --font SCRIPT=FILE  font for latin, arabic, devanagari, myanmar or ethiopic\n"
+			"  --patterns SCRIPT=FILE\n"
+			"                      TeX hyphenation patterns for a script's words\n"
+			"  --size PT           point size (default 12)\n"
+			"  --width PT          column width (default 300)\n"
+			"  --words N,N,...     paragraph lengths in words (default 16,64,256,1024)\n"
+			"  --min-time S        minimum time per measurement (default 0.2)\n"
+			"  --filter NAME       only run benchmarks whose name contains NAME\n"
+			"  --golden FILE       check compose fingerprints against earlier results\n";
+	}
+
+
+	bool parse_args(int argc, char * argv[], options & opts)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const bool has_value = i + 1 < argc;
+
+			if ((arg == "--font" || arg == "--patterns") && has_value)
+			{
+				const std::string v = argv[++i];
+				const std::string::size_type eq = v.find('=');
+				if (eq == std::string::npos)	return false;
+				(arg == "--font" ? opts.fonts : opts.patterns)[v.substr(0, eq)] = v.substr(eq + 1);
+			}
+			else if (arg == "--size" && has_value)		opts.size = std::atof(argv[++i]);
+			else if (arg == "--width" && has_value)		opts.width = std::atof(argv[++i]);
+			else if (arg == "--min-time" && has_value)	opts.min_time = std::atof(argv[++i]);
+			else if (arg == "--filter" && has_value)	opts.filter = argv[++i];
+			else if (arg == "--golden" && has_value)	opts.golden = argv[++i];
+			else if (arg == "--words" && has_value)
+			{
+				std::istringstream ss(argv[++i]);
+				for (int n; ss >> n; ss.ignore(1))
+					opts.lengths.push_back(n);
+			}
+			else
+				return false;
+		}
+
+		if (opts.lengths.empty())
+		{
+			const int defaults[] = {16, 64, 256, 1024};
+			opts.lengths.assign(defaults, defaults + 4);
+		}
+		return !opts.fonts.empty() && opts.size > 0 && opts.width > 0;
+	}
+
+
+	typedef std::map<std::string, std::string>	goldens_t;
+
+	// The parameters of a result, which identify it between runs.
+	std::string result_key(const params & p, TextIndex chars)
+	{
+		char key[256];
+		std::snprintf(key, sizeof key, "{\"bench\":\"%s\",\"script\":\"%s\",\"words\":%d,\"chars\":%d,\"align\":\"%s\",\"tab_every\":%d,",
+						p.bench.c_str(), p.script.c_str(), p.words, chars, p.align.c_str(), p.tab_every);
+		return key;
+	}
+
+
+	/* Read the fingerprints from a results file, keyed on the parameters 
+	each was measured with. Relies on report() writing one result per line.
+	*/
+	bool read_goldens(const std::string & path, goldens_t & goldens)
+	{
+		std::ifstream in(path.c_str());
+		if (!in)	return false;
+
+		const std::string tag = "\"fingerprint\":\"";
+		for (std::string l; std::getline(in, l);)
+		{
+			const std::string::size_type key = l.find('{'),
+										 params_end = l.find("\"iterations\""),
+										 fp = l.find(tag);
+			if (key == std::string::npos || params_end == std::string::npos || fp == std::string::npos)
+				continue;
+			goldens[l.substr(key, params_end - key)] = l.substr(fp + tag.size(), 16);
+		}
+		return true;
+	}
+
+
+	// Allocation counts by phase or kind, leaving out those with none.
+	template <typename T>
+	void report_allocations(const char * key, const allocations::table & allocs, int n)
+	{
+		std::printf(",\"%s\":{", key);
+		for (int i = 0, shown = 0; i != n; ++i)
+		{
+			const allocations::tally t = allocs.total(T(i));
+			if (t.count == 0)	continue;
+			std::printf("%s\"%s\":%llu", shown++ ? "," : "", allocations::name(T(i)), t.count);
+		}
+		std::printf("}");
+	}
+
+
+	void report(const params & p, const result & r, TextIndex chars, const allocations::table & allocs, const std::string & fp, bool & first)
+	{
+		std::printf("%s\n  %s\"iterations\":%zu,\"ns_per_op\":%.1f,\"chars_per_s\":%.0f",
+					first ? "[" : ",", result_key(p, chars).c_str(),
+					r.iterations, r.ns_per_op, r.ns_per_op > 0 ? chars*1e9/r.ns_per_op : 0.0);
+		if (p.bench.compare(0, 9, "hyphenate") == 0)
+			std::printf(",\"lookups_per_s\":%.0f", r.ns_per_op > 0 ? p.words*1e9/r.ns_per_op : 0.0);
+		if (!fp.empty())
+			std::printf(",\"fingerprint\":\"%s\"", fp.c_str());
+#if defined(NRSC_ALLOCATIONS)
+		const allocations::tally total = allocs.total();
+		std::printf(",\"allocs_per_op\":%llu,\"alloc_bytes_per_op\":%llu", total.count, total.bytes);
+		report_allocations<allocations::phase_t>("allocs_by_phase", allocs, allocations::phases);
+		report_allocations<allocations::kind_t>("allocs_by_kind", allocs, allocations::kinds);
+#else
+		(void)allocs;
+#endif
+		std::printf("}");
+		std::fflush(stdout);
+		first = false;
+	}
+}
+
+
+int main(int argc, char * argv[])
+{
+	options opts;
+	if (!parse_args(argc, argv, opts))
+	{
+		usage();
+		return 2;
+	}
+
+	goldens_t goldens;
+	if (!opts.golden.empty() && !read_goldens(opts.golden, goldens))
+	{
+		std::cerr << "grind-bench: cannot read " << opts.golden << std::endl;
+		return 2;
+	}
+
+	bool first = true;
+	int  differ = 0;
+	for (size_t s = 0; s != sizeof samples/sizeof *samples; ++s)
+	{
+		const std::map<std::string, std::string>::const_iterator fp = opts.fonts.find(samples[s].name);
+		if (fp == opts.fonts.end())	continue;
+
+		std::unique_ptr<font> f(font::load(fp->second));
+		if (!f)
+		{
+			std::cerr << "grind-bench: cannot load font " << fp->second << std::endl;
+			return 1;
+		}
+		gr_face_cache faces(4, 0);
+
+		std::string patterns;
+		const std::map<std::string, std::string>::const_iterator pp = opts.patterns.find(samples[s].name);
+		if (pp != opts.patterns.end())
+		{
+			std::ifstream in(pp->second.c_str(), std::ios::binary);
+			std::ostringstream ss;
+			ss << in.rdbuf();
+			patterns = ss.str();
+			hyphenator h;
+			if (!in || !h.load(patterns.data(), patterns.size()))
+			{
+				std::cerr << "grind-bench: cannot load patterns " << pp->second << std::endl;
+				return 1;
+			}
+		}
+
+		// Each benchmark with the alignments and tab densities it depends on.
+		struct variant { const char * bench; const char * align; int tab_every; ns_t (bench_context::*op)(); };
+		const variant variants[] =
+		{
+			{"shape_graphite",	 "left",	0,	&bench_context::shape_graphite},
+			{"shape_fallback",	 "left",	0,	&bench_context::shape_fallback},
+			{"classify",		 "left",	0,	&bench_context::classify},
+			{"classify_each",	 "left",	0,	&bench_context::classify_each},
+			{"break_into",		 "left",	0,	&bench_context::break_into},
+			{"break_into",		 "justify",	0,	&bench_context::break_into},
+			{"justify",			 "left",	0,	&bench_context::justify},
+			{"justify",			 "justify",	0,	&bench_context::justify},
+			{"apply_tab_widths", "left",	8,	&bench_context::apply_tab_widths},
+			{"apply_tab_widths", "left",	2,	&bench_context::apply_tab_widths},
+			{"render",			 "left",	0,	&bench_context::render},
+			{"compose",			 "left",	0,	&bench_context::compose},
+			{"compose",			 "justify",	0,	&bench_context::compose},
+			{"compose",			 "justify",	8,	&bench_context::compose},
+			{"measure",			 "left",	0,	&bench_context::measure},
+			{"measure",			 "justify",	0,	&bench_context::measure},
+			{"copyfit",			 "left",	0,	&bench_context::copyfit},
+			{"copyfit",			 "justify",	0,	&bench_context::copyfit},
+			{"balance",			 "left",	0,	&bench_context::balance},
+			{"balance",			 "center",	0,	&bench_context::balance},
+			{"edit",			 "left",	0,	&bench_context::edit},
+			{"edit",			 "justify",	0,	&bench_context::edit},
+			{"hyphen_load",		 "left",	0,	&bench_context::hyphen_load},
+			{"hyphen_map",		 "left",	0,	&bench_context::hyphen_map},
+			{"hyphen_verify",	 "left",	0,	&bench_context::hyphen_verify},
+			{"hyphenate",		 "left",	0,	&bench_context::hyphenate},
+			{"hyphenate_cached", "left",	0,	&bench_context::hyphenate_cached},
+			{"hyphen_compose",	 "left",	0,	&bench_context::hyphen_compose},
+			{"hyphen_compose",	 "justify",	0,	&bench_context::hyphen_compose}
+		};
+
+		for (size_t v = 0; v != sizeof variants/sizeof *variants; ++v)
+		{
+			if (std::string(variants[v].bench).find(opts.filter) == std::string::npos)
+				continue;
+			if (patterns.empty() && std::string(variants[v].bench).compare(0, 6, "hyphen") == 0)
+				continue;
+
+			// Balancing is for headings and captions, whatever the lengths asked for.
+			const int			heading_caption[] = {6, 24};
+			const std::vector<int>	lengths = variants[v].op == &bench_context::balance 
+											  ? std::vector<int>(heading_caption, heading_caption + 2) 
+											  : opts.lengths;
+			for (size_t l = 0; l != lengths.size(); ++l)
+			{
+				const params p = {variants[v].bench, samples[s].name, variants[v].align, lengths[l], variants[v].tab_every};
+				bench_context ctx(*f, opts, p, faces, patterns);
+				if (variants[v].op == &bench_context::shape_graphite && ctx.face() == nil)
+					continue;
+
+				const result r = measure([&]() { return (ctx.*variants[v].op)(); }, opts.min_time);
+
+				// Tally the allocations of one more run, the operations 
+				// are deterministic.
+				ctx.allocs() = allocations::table();
+				(ctx.*variants[v].op)();
+
+				if ((variants[v].op == &bench_context::measure && !ctx.measure_matches())
+					|| (variants[v].op == &bench_context::hyphen_compose && !ctx.measure_matches(ctx.hyphens())))
+				{
+					std::cerr << "grind-bench: " << p.bench << ' ' << p.script << ' ' << p.align 
+							  << ", " << p.words << " words: measured lines differ from composed ones" << std::endl;
+					++differ;
+				}
+				if ((variants[v].op == &bench_context::classify || variants[v].op == &bench_context::classify_each) 
+					&& !ctx.classify_matches())
+				{
+					std::cerr << "grind-bench: " << p.bench << ' ' << p.script 
+							  << ", " << p.words << " words: classifying in bulk differs from one at a time" << std::endl;
+					++differ;
+				}
+				if (variants[v].op == &bench_context::justify && !ctx.stretch_matches())
+				{
+					std::cerr << "grind-bench: " << p.bench << ' ' << p.script << ' ' << p.align 
+							  << ", " << p.words << " words: table driven stretch or kerning differs from the switches" << std::endl;
+					++differ;
+				}
+				if (variants[v].op == &bench_context::balance && !ctx.balance_keeps_lines())
+				{
+					std::cerr << "grind-bench: " << p.bench << ' ' << p.script << ' ' << p.align 
+							  << ", " << p.words << " words: balancing changed the number of lines" << std::endl;
+					++differ;
+				}
+				if (variants[v].op == &bench_context::edit && !ctx.reuse_matches())
+				{
+					std::cerr << "grind-bench: " << p.bench << ' ' << p.script << ' ' << p.align 
+							  << ", " << p.words << " words: lines recomposing kept differ from composing afresh" << std::endl;
+					++differ;
+				}
+				if (variants[v].op == &bench_context::copyfit && !ctx.copyfit_fits())
+				{
+					std::cerr << "grind-bench: " << p.bench << ' ' << p.script << ' ' << p.align 
+							  << ", " << p.words << " words: composing at the tracking found does not fit" << std::endl;
+					++differ;
+				}
+
+				std::string fp;
+				if (variants[v].op == &bench_context::compose || variants[v].op == &bench_context::edit 
+					|| variants[v].op == &bench_context::hyphen_compose)
+				{
+					const fingerprint::value_t	value = variants[v].op == &bench_context::edit 
+															? ctx.edit_fingerprint() 
+															: ctx.layout_fingerprint(ctx.hyphens());
+					char hex[17];
+					std::snprintf(hex, sizeof hex, "%016llx", value);
+					fp = hex;
+					if (value == 0)
+					{
+						std::cerr << "grind-bench: " << p.bench << ' ' << p.script << ' ' << p.align 
+								  << ", " << p.words << " words: recomposing differs from composing afresh" << std::endl;
+						++differ;
+					}
+
+					const goldens_t::const_iterator g = goldens.find(result_key(p, ctx.length()));
+					if (g != goldens.end() && g->second != fp)
+					{
+						std::cerr << "grind-bench: " << p.bench << ' ' << p.script << ' ' << p.align 
+								  << " tab_every " << p.tab_every << ", " << p.words 
+								  << " words: fingerprint " << fp << " differs from " << g->second << std::endl;
+						++differ;
+					}
+				}
+				report(p, r, ctx.length(), ctx.allocs(), fp, first);
+			}
+		}
+	}
+	std::printf(first ? "[]\n" : "\n]\n");
+
+	if (differ)
+	{
+		std::cerr << "grind-bench: " << differ << " results differ" 
+				  << (opts.golden.empty() ? "" : " from " + opts.golden) << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* grind-patterns: compile TeX hyphenation patterns into a dictionary image.
+
+Reads a pattern file, as grind-typeset --hyphenate takes, and writes the 
+hyphenator's compiled image of it (see layout/Hyphenator.h), which hosts 
+memory map and use in place instead of parsing the patterns every time 
+they start. The image is read back and checked after it is written. With 
+--check, an existing image is only checked, and what it holds reported.
+
+Images are in the byte order of the machine that compiled them and are 
+refused by a machine with the other order.
+*/
+
+// Language headers
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+// Interface headers
+#include "VCPlugInHeaders.h"
+// Library headers
+// Module header
+#include "Hyphenator.h"
+#include "MappedFile.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+using namespace nrsc::standin;
+
+namespace
+{
+	struct options
+	{
+		std::string		source,
+						image;
+		bool			check;
+
+		options() : check(false) {}
+	};
+
+
+	void usage()
+	{
+		std::cerr << 
+			"usage: grind-patterns PATTERNS IMAGE\n"
+			"       grind-patterns --check IMAGE\n"
+			"  --check          check a compiled image instead of writing one\n";
+	}
+
+
+	bool parse_args(int argc, char * argv[], options & opts)
+	{
+		std::string * next[] = { &opts.source, &opts.image };
+		size_t n = 0;
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--check")							opts.check = true;
+			else if (arg.compare(0, 2, "--") == 0 || n == 2)
+				return false;
+			else
+				*next[n++] = arg;
+		}
+
+		if (opts.check && n == 1)	opts.image.swap(opts.source);
+		return opts.check ? n == 1 : n == 2;
+	}
+
+
+	// Verify the image at path, map it and report what it holds.
+	bool check(const std::string & path)
+	{
+		const mapped_file	file(path);
+		hyphenator			h;
+		if (!file.is_open() || !hyphenator::verify(file.data(), file.size()) || !h.map(file.data(), file.size()))
+		{
+			std::cerr << "grind-patterns: " << path << " is not a valid version " 
+					  << hyphenator::image_version << " image" << std::endl;
+			return false;
+		}
+
+		std::cout << path << ": " << h.patterns() << " patterns, " << h.exceptions() << " exceptions, " 
+				  << h.nodes() << " trie nodes, " << h.image_size() << " bytes" << std::endl;
+		return true;
+	}
+}
+
+
+int main(int argc, char * argv[])
+{
+	options opts;
+	if (!parse_args(argc, argv, opts))
+	{
+		usage();
+		return 2;
+	}
+
+	if (opts.check)
+		return check(opts.image) ? 0 : 1;
+
+	std::ifstream in(opts.source.c_str(), std::ios::binary);
+	std::ostringstream source;
+	source << in.rdbuf();
+	const std::string text = source.str();
+	hyphenator h;
+	if (!in || !h.load(text.data(), text.size()))
+	{
+		std::cerr << "grind-patterns: cannot load patterns " << opts.source << std::endl;
+		return 1;
+	}
+
+	std::ofstream out(opts.image.c_str(), std::ios::binary | std::ios::trunc);
+	if (!out.write(static_cast<const char *>(h.image()), h.image_size()) || !out.flush())
+	{
+		std::cerr << "grind-patterns: cannot write " << opts.image << std::endl;
+		return 1;
+	}
+	out.close();
+
+	return check(opts.image) ? 0 : 1;
+}
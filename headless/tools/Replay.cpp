@@ -0,0 +1,797 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* grind-replay: run a composer recording back through the layout engine.
+
+A recording made by a GRIND_RECORD build of the plug-in or grind-typeset 
+(see layout/Recorder.h) holds every paragraph, drawing style and GetTiles 
+answer the composer saw. Each recorded paragraph becomes a story in the 
+recorded styles and every recompose and rebuild call is made again, with 
+GetTiles answered from the recording, so a slowdown seen in a document we 
+cannot have can be profiled and bisected from the recording alone. Lines 
+and wax runs that come out different from the recording are counted, and 
+listed with --verbose.
+
+Fonts are loaded from their recorded paths, by file name from --font-dir 
+if that fails, and from --font as a last resort.
+*/
+
+// Language headers
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IParagraphComposer.h>
+#include <ITextParcelList.h>
+// Library headers
+#include <textiterator.h>
+// Module header
+#include "Composer.h"
+#include "Font.h"
+#include "GrFaceCache.h"
+#include "Line.h"
+#include "Recorder.h"
+#include "Story.h"
+#include "Style.h"
+#include "Tiler.h"
+#include "Wax.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+using namespace nrsc::standin;
+
+namespace
+{
+	struct options
+	{
+		std::string		path,
+						font_dir,
+						fallback_font;
+		unsigned int	repeat;
+		bool			verbose;
+
+		options() : repeat(1), verbose(false) {}
+	};
+
+	struct style_rec
+	{
+		uint32			font;
+		double			point_size,
+						leading;
+		int32			alignment;
+		bool			no_break;
+		int32			drop_chars,
+						drop_lines;
+		double			indent_left,
+						indent_first,
+						indent_right,
+						tab_interval,
+						word_space[3],
+						letter_space[3],
+						glyph_scale[3];
+	};
+
+	struct paragraph_rec
+	{
+		TextIndex							start;
+		story::string_t						text;
+		std::vector<std::pair<int32, uint32> >	runs;
+	};
+
+	struct tiles_rec
+	{
+		bool			result;
+		double			y;
+		int32			TOF_metric;
+		bool			at_TOF,
+						parcel_dependent;
+		double			left_margin,
+						right_margin;
+		PMRectCollection	tiles;
+	};
+
+	struct line_rec
+	{
+		TextIndex				start;
+		double					y,
+								height;
+		wax_line::tiles_t		tiles;
+		int32					drop_indents;
+		double					drop_indent;
+		int32					drop_lines;
+	};
+
+	struct run_rec
+	{
+		double	x, 
+				y, 
+				width;
+		int32	span;
+	};
+
+	struct compose_rec
+	{
+		size_t					paragraph;
+		TextIndex				start;
+		double					y;
+		int32					TOF_metric;
+		int32					drop_indents;
+		double					drop_indent;
+		int32					drop_lines;
+		std::vector<tiles_rec>	tiles;
+		std::vector<line_rec>	lines;
+	};
+
+	struct rebuild_rec
+	{
+		size_t					paragraph;
+		line_rec				line;
+		std::vector<run_rec>	runs;
+		bool					ok;
+	};
+
+	// A recorded call, in recording order.
+	struct call
+	{
+		bool	rebuild;
+		size_t	index;
+	};
+
+	struct recording
+	{
+		std::map<uint32, std::string>	fonts;
+		std::map<uint32, style_rec>		styles;
+		std::vector<paragraph_rec>		paragraphs;
+		std::vector<compose_rec>		composes;
+		std::vector<rebuild_rec>		rebuilds;
+		std::vector<call>				calls;
+	};
+
+
+	class reader
+	{
+		const std::string & _data;
+		size_t				_pos;
+		bool				_ok;
+
+	public:
+		explicit reader(const std::string & data) : _data(data), _pos(0), _ok(true) {}
+
+		bool	ok() const		{ return _ok; }
+		bool	at_end() const	{ return _pos >= _data.size(); }
+		char	peek() const	{ return at_end() ? 0 : _data[_pos]; }
+
+		unsigned char u8()
+		{
+			if (at_end())	{ _ok = false; return 0; }
+			return static_cast<unsigned char>(_data[_pos++]);
+		}
+		uint16	u16()	{ const uint16 lo = u8(); return uint16(lo | u8() << 8); }
+		uint32	u32()	{ const uint32 lo = u16(); return lo | uint32(u16()) << 16; }
+		int32	i32()	{ return int32(u32()); }
+		double	real()
+		{
+			unsigned char b[sizeof(double)];
+			for (size_t i = 0; i != sizeof b; ++i)	b[i] = u8();
+			double d;
+			std::memcpy(&d, b, sizeof d);
+			return d;
+		}
+		std::string str()
+		{
+			const uint32 n = u32();
+			if (!_ok || n > _data.size() - _pos)	{ _ok = false; return std::string(); }
+			_pos += n;
+			return _data.substr(_pos - n, n);
+		}
+	};
+
+
+	void read_line(reader & in, line_rec & l)
+	{
+		l.y = in.real();
+		l.height = in.real();
+		l.tiles.resize(in.u32());
+		for (wax_line::tiles_t::iterator t = l.tiles.begin(); t != l.tiles.end() && in.ok(); ++t)
+		{
+			t->span = in.i32();
+			t->x = in.real();
+			t->width = in.real();
+		}
+		l.drop_indents = in.i32();
+		l.drop_indent = in.real();
+		l.drop_lines = in.i32();
+	}
+
+
+	bool read_recording(const std::string & data, recording & rec)
+	{
+		reader in(data);
+		if (data.compare(0, 4, "GRRC") != 0)	return false;
+		for (int i = 0; i != 4; ++i)	in.u8();
+		if (in.u32() != recorder::version)	return false;
+
+		while (in.ok() && !in.at_end())
+		{
+			switch (in.u8())
+			{
+			case 'F':
+			{
+				const uint32 id = in.u32();
+				rec.fonts[id] = in.str();
+				break;
+			}
+			case 'S':
+			{
+				const uint32 id = in.u32();
+				style_rec & s = rec.styles[id];
+				s.font = in.u32();
+				s.point_size = in.real();
+				s.leading = in.real();
+				s.alignment = in.i32();
+				s.no_break = in.u8() != 0;
+				s.drop_chars = in.i32();
+				s.drop_lines = in.i32();
+				s.indent_left = in.real();
+				s.indent_first = in.real();
+				s.indent_right = in.real();
+				s.tab_interval = in.real();
+				for (int i = 0; i != 3; ++i)	s.word_space[i] = in.real();
+				for (int i = 0; i != 3; ++i)	s.letter_space[i] = in.real();
+				for (int i = 0; i != 3; ++i)	s.glyph_scale[i] = in.real();
+				break;
+			}
+			case 'P':
+			{
+				rec.paragraphs.push_back(paragraph_rec());
+				paragraph_rec & p = rec.paragraphs.back();
+				p.start = in.u32();
+				p.text.resize(in.u32());
+				for (size_t i = 0; i != p.text.size() && in.ok(); ++i)	p.text[i] = in.u16();
+				p.runs.resize(in.u32());
+				for (size_t i = 0; i != p.runs.size() && in.ok(); ++i)
+				{
+					p.runs[i].first = in.i32();
+					p.runs[i].second = in.u32();
+				}
+				break;
+			}
+			case 'C':
+			{
+				if (rec.paragraphs.empty())	return false;
+				rec.composes.push_back(compose_rec());
+				compose_rec & c = rec.composes.back();
+				c.paragraph = rec.paragraphs.size() - 1;
+				c.start = in.u32();
+				c.y = in.real();
+				c.TOF_metric = in.u32();
+				c.drop_indents = in.i32();
+				c.drop_indent = in.real();
+				c.drop_lines = in.i32();
+				const call cl = { false, rec.composes.size() - 1 };
+				rec.calls.push_back(cl);
+				break;
+			}
+			case 'T':
+			{
+				if (rec.composes.empty())	return false;
+				rec.composes.back().tiles.push_back(tiles_rec());
+				tiles_rec & t = rec.composes.back().tiles.back();
+				for (int i = 0; i != 3; ++i)	in.real();		// min width, height, TOF height
+				in.u32();										// position
+				in.real();										// y in
+				t.result = in.u8() != 0;
+				t.y = in.real();
+				t.TOF_metric = in.i32();
+				t.at_TOF = in.u8() != 0;
+				t.parcel_dependent = in.u8() != 0;
+				t.left_margin = in.real();
+				t.right_margin = in.real();
+				for (uint32 n = in.u32(); n != 0 && in.ok(); --n)
+				{
+					const double l = in.real(), tp = in.real(), r = in.real(), b = in.real();
+					t.tiles.push_back(PMRect(l, tp, r, b));
+				}
+				break;
+			}
+			case 'L':
+			{
+				if (rec.composes.empty())	return false;
+				rec.composes.back().lines.push_back(line_rec());
+				line_rec & l = rec.composes.back().lines.back();
+				l.start = in.u32();
+				read_line(in, l);
+				break;
+			}
+			case 'B':
+			{
+				if (rec.paragraphs.empty())	return false;
+				rec.rebuilds.push_back(rebuild_rec());
+				rebuild_rec & r = rec.rebuilds.back();
+				r.paragraph = rec.paragraphs.size() - 1;
+				r.ok = false;
+				r.line.start = in.u32();
+				read_line(in, r.line);
+				const call cl = { true, rec.rebuilds.size() - 1 };
+				rec.calls.push_back(cl);
+				break;
+			}
+			case 'W':
+			{
+				if (rec.rebuilds.empty())	return false;
+				run_rec w;
+				w.x = in.real();
+				w.y = in.real();
+				w.width = in.real();
+				w.span = in.i32();
+				rec.rebuilds.back().runs.push_back(w);
+				break;
+			}
+			case 'E':
+				if (rec.rebuilds.empty())	return false;
+				rec.rebuilds.back().ok = true;
+				break;
+			default:
+				return false;
+			}
+		}
+
+		return in.ok();
+	}
+
+
+	/* The fonts, styles and stories a recording needs, built before any 
+	calls are replayed so that only the engine is timed.
+	*/
+	class document
+	{
+	public:
+		bool	load(const recording & rec, const options & opts);
+
+		story &	paragraph(size_t i)	{ return *_stories[i]; }
+
+	private:
+		std::map<uint32, std::unique_ptr<font> >			_fonts;
+		std::map<uint32, std::unique_ptr<drawing_style> >	_styles;
+		std::vector<std::unique_ptr<story> >				_stories;
+	};
+
+
+	font * load_font(const std::string & path, const options & opts)
+	{
+		if (font * f = font::load(path))	return f;
+
+		if (!opts.font_dir.empty())
+		{
+			const std::string::size_type slash = path.find_last_of("/\\");
+			const std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+			if (font * f = font::load(opts.font_dir + "/" + name))	return f;
+		}
+
+		return opts.fallback_font.empty() ? nil : font::load(opts.fallback_font);
+	}
+
+
+	bool document::load(const recording & rec, const options & opts)
+	{
+		for (std::map<uint32, std::string>::const_iterator f = rec.fonts.begin(); f != rec.fonts.end(); ++f)
+		{
+			_fonts[f->first].reset(load_font(f->second, opts));
+			if (!_fonts[f->first])
+			{
+				std::cerr << "grind-replay: cannot load font " << f->second << std::endl;
+				return false;
+			}
+		}
+
+		for (std::map<uint32, style_rec>::const_iterator s = rec.styles.begin(); s != rec.styles.end(); ++s)
+		{
+			const style_rec & sr = s->second;
+			if (_fonts.find(sr.font) == _fonts.end())	return false;
+
+			drawing_style * const ds = new drawing_style(*_fonts[sr.font], sr.point_size);
+			_styles[s->first].reset(ds);
+			ds->leading = sr.leading;
+			ds->alignment = ICompositionStyle::TextAlignment(sr.alignment);
+			ds->no_break = sr.no_break;
+			ds->drop_chars = int16(sr.drop_chars);
+			ds->drop_lines = int16(sr.drop_lines);
+			ds->indent_left = sr.indent_left;
+			ds->indent_first = sr.indent_first;
+			ds->indent_right = sr.indent_right;
+			if (sr.tab_interval > 0)	ds->tab_interval = sr.tab_interval;
+			ds->word_space = drawing_style::range(sr.word_space[0], sr.word_space[1], sr.word_space[2]);
+			ds->letter_space = drawing_style::range(sr.letter_space[0], sr.letter_space[1], sr.letter_space[2]);
+			ds->glyph_scale = drawing_style::range(sr.glyph_scale[0], sr.glyph_scale[1], sr.glyph_scale[2]);
+		}
+
+		for (std::vector<paragraph_rec>::const_iterator p = rec.paragraphs.begin(); p != rec.paragraphs.end(); ++p)
+		{
+			story * const s = new story();
+			_stories.push_back(std::unique_ptr<story>(s));
+
+			size_t offset = 0;
+			for (size_t r = 0; r != p->runs.size(); ++r)
+			{
+				const size_t span = std::min<size_t>(p->runs[r].first, p->text.size() - offset);
+				if (_styles.find(p->runs[r].second) == _styles.end())	return false;
+				s->append(p->text.data() + offset, span, *_styles[p->runs[r].second]);
+				offset += span;
+			}
+		}
+
+		return true;
+	}
+
+
+	class parcel_list : public ITextParcelList
+	{
+		Text::FirstLineOffsetMetric	_metric;
+
+	public:
+		explicit parcel_list(int32 metric) : _metric(Text::FirstLineOffsetMetric(metric)) {}
+
+		void	AddRef() const	{}
+		void	Release() const	{}
+
+		Text::FirstLineOffsetMetric	GetFirstLineOffsetMetric(const ParcelKey &) const	{ return _metric; }
+	};
+
+
+	/* Answers the composer from a recorded recompose call. Positions are 
+	relative to the paragraph's story, which starts at the recorded 
+	paragraph start.
+	*/
+	class replay_helper : public IParagraphComposer::RecomposeHelper
+	{
+	public:
+		replay_helper(story & s, TextIndex offset, const compose_rec & rec);
+		~replay_helper();
+
+		IComposeScanner	  *	GetComposeScanner() const		{ return &_story; }
+		ITextParcelList	  *	GetTextParcelList() const		{ return const_cast<parcel_list *>(&_parcels); }
+		IDataBase		  *	GetDataBase() const				{ return nil; }
+		TextIndex			GetParagraphStart() const		{ return 0; }
+		TextIndex			GetParagraphEnd() const			{ return _story.length(); }
+		TextIndex			GetStartingTextIndex() const	{ return _rec.start - _offset; }
+		ParcelKey			GetStartingParcelKey() const	{ return ParcelKey(0); }
+		PMReal				GetStartingYPosition() const	{ return _rec.y; }
+		const IWaxLine	  *	GetPreviousWaxLine() const		{ return _previous; }
+
+		bool16	GetTiles(const PMReal & min_width, const PMReal & height, const PMReal & TOF_height,
+						 Text::GridAlignmentMetric grid_metric, const PMReal & grid_offset,
+						 Text::LeadingModel leading_model, const PMReal & leading_model_height,
+						 const PMReal & leading_model_offset, const PMReal & descent,
+						 TextIndex position, bool16 affected_by_vertical_justification,
+						 ParcelKey * parcel, PMReal * y_position, Text::FirstLineOffsetMetric * TOF_metric,
+						 PMRectCollection & tiles, bool16 * at_TOF, bool16 * parcel_position_dependent,
+						 PMReal * left_margin, PMReal * right_margin);
+
+		IWaxLine  *	QueryNewWaxLine()	{ return new wax_line(); }
+		void		ApplyComposedLine(IWaxLine * line, int32 span);
+
+	private:
+		story			  &	_story;
+		TextIndex const		_offset;
+		const compose_rec &	_rec;
+		parcel_list			_parcels;
+		size_t				_next_tiles;
+		TextIndex			_next;
+		wax_line		  *	_drop_cap_line;
+		const IWaxLine	  *	_previous;
+	};
+
+
+	replay_helper::replay_helper(story & s, TextIndex offset, const compose_rec & rec)
+	: _story(s),
+	  _offset(offset),
+	  _rec(rec),
+	  _parcels(rec.TOF_metric),
+	  _next_tiles(0),
+	  _next(rec.start - offset),
+	  _drop_cap_line(nil),
+	  _previous(nil)
+	{
+		// Only the previous line's drop cap affects the composer.
+		if (rec.drop_indents > 0)
+		{
+			const PMReal	indent = rec.drop_indent;
+			const int32		lines = rec.drop_lines;
+			_drop_cap_line = new wax_line();
+			_drop_cap_line->SetDropCapIndents(rec.drop_indents, &indent, &lines);
+			_previous = _drop_cap_line;
+		}
+	}
+
+
+	replay_helper::~replay_helper()
+	{
+		if (_drop_cap_line)	_drop_cap_line->Release();
+	}
+
+
+	bool16 replay_helper::GetTiles(const PMReal &, const PMReal &, const PMReal &,
+								   Text::GridAlignmentMetric, const PMReal &,
+								   Text::LeadingModel, const PMReal &,
+								   const PMReal &, const PMReal &,
+								   TextIndex, bool16,
+								   ParcelKey * parcel, PMReal * y_position, Text::FirstLineOffsetMetric * TOF_metric,
+								   PMRectCollection & tiles, bool16 * at_TOF, bool16 * parcel_position_dependent,
+								   PMReal * left_margin, PMReal * right_margin)
+	{
+		tiles.clear();
+		*parcel = ParcelKey(0);
+
+		// More calls than were recorded, answer as if the frame were full.
+		if (_next_tiles == _rec.tiles.size())
+			return kTrue;
+
+		const tiles_rec & t = _rec.tiles[_next_tiles++];
+		tiles = t.tiles;
+		*y_position = t.y;
+		*TOF_metric = Text::FirstLineOffsetMetric(t.TOF_metric);
+		*at_TOF = t.at_TOF;
+		*parcel_position_dependent = t.parcel_dependent;
+		*left_margin = t.left_margin;
+		*right_margin = t.right_margin;
+		return t.result;
+	}
+
+
+	void replay_helper::ApplyComposedLine(IWaxLine * line, int32 span)
+	{
+		wax_line * const wl = dynamic_cast<wax_line *>(line);
+		if (wl == nil)	return;
+
+		wl->set_start(_next);
+		_next += span;
+		_previous = wl;
+	}
+
+
+	bool close(double a, double b)
+	{
+		return std::fabs(a - b) < 1.0e-3;
+	}
+
+
+	// Compare a composed line with its recording and describe any difference.
+	std::string compare(const wax_line & wl, TextIndex offset, const line_rec & l)
+	{
+		char buf[160];
+		if (wl.start() + offset != l.start || wl.tiles().size() != l.tiles.size())
+		{
+			std::snprintf(buf, sizeof buf, "line at %d: starts at %d with %u tiles, recorded %d with %u",
+						  l.start, wl.start() + offset, unsigned(wl.tiles().size()), l.start, unsigned(l.tiles.size()));
+			return buf;
+		}
+		if (!close(ToDouble(wl.GetYPosition()), l.y))
+		{
+			std::snprintf(buf, sizeof buf, "line at %d: y %.3f, recorded %.3f", l.start, ToDouble(wl.GetYPosition()), l.y);
+			return buf;
+		}
+		for (size_t t = 0; t != l.tiles.size(); ++t)
+		{
+			const wax_line::tile & a = wl.tiles()[t], & b = l.tiles[t];
+			if (a.span != b.span || !close(ToDouble(a.x), ToDouble(b.x)) || !close(ToDouble(a.width), ToDouble(b.width)))
+			{
+				std::snprintf(buf, sizeof buf, "line at %d tile %u: span %d x %.3f width %.3f, recorded %d %.3f %.3f", 
+							  l.start, unsigned(t), a.span, ToDouble(a.x), ToDouble(a.width), b.span, ToDouble(b.x), ToDouble(b.width));
+				return buf;
+			}
+		}
+		return std::string();
+	}
+
+
+	struct totals
+	{
+		size_t	composes,
+				lines,
+				rebuilds,
+				mismatches;
+
+		totals() : composes(0), lines(0), rebuilds(0), mismatches(0) {}
+	};
+
+
+	void mismatch(const options & opts, totals & t, const std::string & what)
+	{
+		++t.mismatches;
+		if (opts.verbose)	std::cerr << "grind-replay: " << what << std::endl;
+	}
+
+
+	void replay_compose(const options & opts, document & doc, gr_face_cache & faces, 
+						const recording & rec, const compose_rec & c, totals & t)
+	{
+		const paragraph_rec & p = rec.paragraphs[c.paragraph];
+		replay_helper		helper(doc.paragraph(c.paragraph), p.start, c);
+		tiler				tile_manager(helper);
+		std::vector<wax_line *>	lines;
+
+		++t.composes;
+		TextIndex ti = helper.GetStartingTextIndex();
+		for (size_t l = 0; l != c.lines.size(); ++l, ++t.lines)
+		{
+			wax_line * const wl = dynamic_cast<wax_line *>(compose_line(tile_manager, faces, helper, ti));
+			if (wl == nil)
+			{
+				mismatch(opts, t, "line at " + std::to_string(c.lines[l].start) + ": composition failed");
+				break;
+			}
+			lines.push_back(wl);
+
+			const std::string diff = compare(*wl, p.start, c.lines[l]);
+			if (!diff.empty())	mismatch(opts, t, diff);
+			if (wl->span() == 0)	break;
+			ti += wl->span();
+		}
+
+		for (size_t l = 0; l != lines.size(); ++l)
+			lines[l]->Release();
+	}
+
+
+	void replay_rebuild(const options & opts, document & doc, gr_face_cache & faces, 
+						const recording & rec, const rebuild_rec & r, totals & t)
+	{
+		const paragraph_rec & p = rec.paragraphs[r.paragraph];
+		wax_line * const wl = new wax_line();
+		wl->set_start(r.line.start - p.start);
+		wl->SetCompositionYPosition(r.line.y);
+		wl->SetLineHeight(r.line.height);
+		wl->SetNumberOfTiles(int32(r.line.tiles.size()));
+		for (size_t i = 0; i != r.line.tiles.size(); ++i)
+		{
+			wl->SetTextSpanInTile(r.line.tiles[i].span, int32(i));
+			wl->SetXPosition(r.line.tiles[i].x, int32(i));
+			wl->SetTargetWidth(r.line.tiles[i].width, int32(i));
+		}
+		if (r.line.drop_indents > 0)
+		{
+			const PMReal	indent = r.line.drop_indent;
+			const int32		lines = r.line.drop_lines;
+			wl->SetDropCapIndents(r.line.drop_indents, &indent, &lines);
+		}
+
+		++t.rebuilds;
+		const bool ok = rebuild_line(faces, rebuild_helper(doc.paragraph(r.paragraph), *wl));
+		char buf[160];
+		if (ok != r.ok)
+		{
+			std::snprintf(buf, sizeof buf, "rebuild at %d: %s, recorded %s", r.line.start, 
+						  ok ? "succeeded" : "failed", r.ok ? "succeeded" : "failed");
+			mismatch(opts, t, buf);
+		}
+		else if (wl->runs().size() != r.runs.size())
+		{
+			std::snprintf(buf, sizeof buf, "rebuild at %d: %u runs, recorded %u", r.line.start, 
+						  unsigned(wl->runs().size()), unsigned(r.runs.size()));
+			mismatch(opts, t, buf);
+		}
+		else for (size_t i = 0; i != r.runs.size(); ++i)
+		{
+			const IWaxRun & wr = *wl->runs()[i];
+			if (!close(ToDouble(wr.GetXPosition()), r.runs[i].x) || !close(ToDouble(wr.GetYPosition()), r.runs[i].y))
+			{
+				std::snprintf(buf, sizeof buf, "rebuild at %d run %u: at %.3f,%.3f, recorded %.3f,%.3f", r.line.start, unsigned(i), 
+							  ToDouble(wr.GetXPosition()), ToDouble(wr.GetYPosition()), r.runs[i].x, r.runs[i].y);
+				mismatch(opts, t, buf);
+				break;
+			}
+		}
+		wl->Release();
+	}
+
+
+	void usage()
+	{
+		std::cerr << 
+			"usage: grind-replay [options] RECORDING\n"
+			"  --font-dir DIR   look for fonts missing from their recorded path\n"
+			"                   in DIR by file name\n"
+			"  --font FILE      use FILE for any font that still cannot be found\n"
+			"  --repeat N       replay the recording N times (default 1)\n"
+			"  --verbose        describe each line or run that differs from the\n"
+			"                   recording\n";
+	}
+
+
+	bool parse_args(int argc, char * argv[], options & opts)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string	arg = argv[i];
+			const bool			has_value = i + 1 < argc;
+
+			if (arg == "--verbose")							opts.verbose = true;
+			else if (arg == "--font-dir" && has_value)		opts.font_dir = argv[++i];
+			else if (arg == "--font" && has_value)			opts.fallback_font = argv[++i];
+			else if (arg == "--repeat" && has_value)		opts.repeat = std::atoi(argv[++i]);
+			else if (arg.compare(0, 2, "--") == 0 || !opts.path.empty())
+				return false;
+			else
+				opts.path = arg;
+		}
+
+		return !opts.path.empty() && opts.repeat > 0;
+	}
+}
+
+
+int main(int argc, char * argv[])
+{
+	options opts;
+	if (!parse_args(argc, argv, opts))
+	{
+		usage();
+		return 2;
+	}
+
+	std::ifstream file(opts.path.c_str(), std::ios::binary);
+	const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	recording rec;
+	if (!file || !read_recording(data, rec))
+	{
+		std::cerr << "grind-replay: cannot read recording " << opts.path << std::endl;
+		return 1;
+	}
+
+	document doc;
+	if (!doc.load(rec, opts))
+		return 1;
+
+	gr_face_cache faces(4, 0);
+	totals t;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned int n = 0; n != opts.repeat; ++n)
+	{
+		for (std::vector<call>::const_iterator c = rec.calls.begin(); c != rec.calls.end(); ++c)
+		{
+			if (c->rebuild)	replay_rebuild(opts, doc, faces, rec, rec.rebuilds[c->index], t);
+			else			replay_compose(opts, doc, faces, rec, rec.composes[c->index], t);
+		}
+	}
+	const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::fprintf(stderr, "%zu recompose calls, %zu lines, %zu rebuilds in %.3fs: %.0f lines/s, %zu mismatches\n",
+				 t.composes, t.lines, t.rebuilds, secs, secs > 0 ? (t.lines + t.rebuilds)/secs : 0.0, t.mismatches);
+
+	return t.mismatches ? 1 : 0;
+}
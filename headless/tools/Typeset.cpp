@@ -0,0 +1,699 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* grind-typeset: compose text files with the headless layout engine.
+
+Each input file is composed as one story into a single column and the 
+resulting lines and glyph positions written as JSON or a binary dump. Files
+are shared out across worker threads, each of which can compose a file's 
+paragraphs on several more with --threads, and a throughput summary is 
+printed to stderr when all are done.
+
+Input is plain text, one paragraph per line, or with --markup a USFM like 
+subset: a line starting with a \marker begins a new paragraph, \v n keeps 
+its verse number, and any other \marker is dropped.
+
+The binary dump is little endian:
+	"GRND" uint32 version
+	per line:  int32 start, int32 span, float y, uint32 runs
+	per run:   float x, float y, uint32 glyphs
+	per glyph: uint16 id, float x, float y
+and ends with a start of 0 and a span of -1.
+*/
+
+// Language headers
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+// Interface headers
+#include "VCPlugInHeaders.h"
+// Library headers
+// Module header
+#include "Allocations.h"
+#include "Composer.h"
+#include "Counters.h"
+#include "Fingerprint.h"
+#include "Font.h"
+#include "GrFaceCache.h"
+#include "Hyphenator.h"
+#include "MappedFile.h"
+#include "Recorder.h"
+#include "Story.h"
+#include "Style.h"
+#include "Trace.h"
+#include "Wax.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+using namespace nrsc::standin;
+
+namespace
+{
+	enum format_t { json, binary, none };
+
+	struct options
+	{
+		std::string					font_path,
+									output_dir,
+									record_path,
+									fingerprints_path,
+									golden_path,
+									trace_path,
+									patterns_path;
+		double						size,
+									width,
+									leading;
+		ICompositionStyle::TextAlignment	alignment;
+		format_t					format;
+		bool						markup,
+									report_allocations;
+		unsigned int				jobs,
+									threads,
+									look_ahead,
+									counters_every,
+									balance;
+		std::vector<std::string>	files;
+
+		options() 
+		: size(12), width(0), leading(0), alignment(ICompositionStyle::kTextAlignLeft), 
+		  format(json), markup(false), report_allocations(false), jobs(std::thread::hardware_concurrency()), threads(1), look_ahead(0), counters_every(0), balance(0) {}
+	};
+
+	struct totals
+	{
+		size_t	files,
+				failed,
+				paragraphs,
+				lines,
+				chars;
+		allocations::table	allocs;
+
+		totals() : files(0), failed(0), paragraphs(0), lines(0), chars(0), allocs() {}
+
+		totals & operator += (const totals & rhs)
+		{
+			files += rhs.files; failed += rhs.failed; paragraphs += rhs.paragraphs;
+			lines += rhs.lines; chars += rhs.chars;
+			allocs += rhs.allocs;
+			return *this;
+		}
+	};
+
+
+	void usage()
+	{
+		std::cerr << 
+			"usage: grind-typeset --font FILE --width PT [options] FILE...\n"
+			"  --font FILE      TrueType or OpenType font to set the text in\n"
+			"  --size PT        point size (default 12)\n"
+			"  --leading PT     leading (default 120% of the size)\n"
+			"  --width PT       column width\n"
+			"  --align A        left, center, right or justify (default left)\n"
+			"  --balance N      balance the rag of ragged paragraphs of up to N\n"
+			"                   characters\n"
+			"  --hyphenate FILE hyphenate with the TeX patterns, or the image\n"
+			"                   compiled from them by grind-patterns, in FILE\n"
+			"  --format F       json, binary or none (default json)\n"
+			"  --output DIR     write FILE.json or FILE.bin into DIR, otherwise\n"
+			"                   JSON goes to stdout one document per line\n"
+			"  --markup         read USFM style paragraph markers\n"
+			"  --jobs N         worker threads (default one per core)\n"
+			"  --threads N      compose each file's paragraphs on N threads\n"
+			"                   (default 1)\n"
+			"  --look-ahead N   composing on one thread, shape up to N paragraphs\n"
+			"                   ahead of it on another\n"
+			"  --counters N     log composer counters every N lines and at the\n"
+			"                   end, in builds with GRIND_COUNTERS on\n"
+			"  --allocations    report the composer's allocations by phase and\n"
+			"                   object kind for each file and in total, in builds\n"
+			"                   with GRIND_ALLOCATIONS on\n"
+			"  --fingerprints FILE\n"
+			"                   write a layout fingerprint for every paragraph\n"
+			"                   to FILE\n"
+			"  --golden FILE    compare paragraph fingerprints with FILE, written\n"
+			"                   by --fingerprints, and fail if any differ\n"
+			"  --record FILE    record the composer's host calls to FILE for\n"
+			"                   grind-replay, in builds with GRIND_RECORD on;\n"
+			"                   implies --jobs 1 and --threads 1\n"
+			"  --trace FILE     write composer timing spans to FILE as Chrome\n"
+			"                   trace JSON, in builds with GRIND_TRACE on\n";
+	}
+
+
+	bool parse_args(int argc, char * argv[], options & opts)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const bool has_value = i + 1 < argc;
+
+			if (arg == "--markup")						opts.markup = true;
+			else if (arg == "--allocations")			opts.report_allocations = true;
+			else if (arg == "--font" && has_value)		opts.font_path = argv[++i];
+			else if (arg == "--size" && has_value)		opts.size = std::atof(argv[++i]);
+			else if (arg == "--leading" && has_value)	opts.leading = std::atof(argv[++i]);
+			else if (arg == "--width" && has_value)		opts.width = std::atof(argv[++i]);
+			else if (arg == "--jobs" && has_value)		opts.jobs = std::atoi(argv[++i]);
+			else if (arg == "--threads" && has_value)	opts.threads = std::atoi(argv[++i]);
+			else if (arg == "--look-ahead" && has_value)	opts.look_ahead = std::atoi(argv[++i]);
+			else if (arg == "--counters" && has_value)	opts.counters_every = std::atoi(argv[++i]);
+			else if (arg == "--balance" && has_value)	opts.balance = std::atoi(argv[++i]);
+			else if (arg == "--output" && has_value)	opts.output_dir = argv[++i];
+			else if (arg == "--fingerprints" && has_value)	opts.fingerprints_path = argv[++i];
+			else if (arg == "--golden" && has_value)	opts.golden_path = argv[++i];
+			else if (arg == "--record" && has_value)	opts.record_path = argv[++i];
+			else if (arg == "--trace" && has_value)		opts.trace_path = argv[++i];
+			else if (arg == "--hyphenate" && has_value)	opts.patterns_path = argv[++i];
+			else if (arg == "--align" && has_value)
+			{
+				const std::string a = argv[++i];
+				if (a == "left")			opts.alignment = ICompositionStyle::kTextAlignLeft;
+				else if (a == "center")		opts.alignment = ICompositionStyle::kTextAlignCenter;
+				else if (a == "right")		opts.alignment = ICompositionStyle::kTextAlignRight;
+				else if (a == "justify")	opts.alignment = ICompositionStyle::kTextAlignJustifyLeft;
+				else return false;
+			}
+			else if (arg == "--format" && has_value)
+			{
+				const std::string f = argv[++i];
+				if (f == "json")			opts.format = json;
+				else if (f == "binary")		opts.format = binary;
+				else if (f == "none")		opts.format = none;
+				else return false;
+			}
+			else if (arg.compare(0, 2, "--") == 0)
+				return false;
+			else
+				opts.files.push_back(arg);
+		}
+
+		// The recorder is not thread safe.
+		if (opts.jobs == 0 || !opts.record_path.empty())	opts.jobs = 1;
+		if (opts.threads == 0 || !opts.record_path.empty())	opts.threads = 1;
+		return !opts.font_path.empty() && opts.width > 0 && opts.size > 0 && !opts.files.empty()
+			&& (opts.format != binary || !opts.output_dir.empty());
+	}
+
+
+	bool read_file(const std::string & path, std::string & content)
+	{
+		std::ifstream file(path.c_str(), std::ios::binary);
+		if (!file)	return false;
+
+		std::ostringstream ss;
+		ss << file.rdbuf();
+		content = ss.str();
+		return true;
+	}
+
+
+	// Split into lines, dropping any carriage returns.
+	template <class F>
+	void for_each_line(const std::string & text, F f)
+	{
+		std::string::size_type b = 0;
+		while (b < text.size())
+		{
+			std::string::size_type e = text.find('\n', b);
+			if (e == std::string::npos)	e = text.size();
+
+			std::string line = text.substr(b, e - b);
+			if (!line.empty() && line[line.size()-1] == '\r')
+				line.erase(line.size()-1);
+			f(line);
+			b = e + 1;
+		}
+	}
+
+
+	void end_paragraph(std::string & para, story & s, drawing_style & ds)
+	{
+		const std::string::size_type first = para.find_first_not_of(' ');
+		if (first != std::string::npos)
+		{
+			para.erase(0, first);
+			para.erase(para.find_last_not_of(' ') + 1);
+			para += char(kTextChar_CR);
+			s.append_utf8(para, ds);
+		}
+		para.clear();
+	}
+
+
+	void read_plain(const std::string & text, story & s, drawing_style & ds)
+	{
+		std::string para;
+		for_each_line(text, [&](const std::string & line) 
+		{
+			para = line;
+			end_paragraph(para, s, ds);
+		});
+	}
+
+
+	void read_markup(const std::string & text, story & s, drawing_style & ds)
+	{
+		std::string para;
+		for_each_line(text, [&](const std::string & line)
+		{
+			std::string::size_type i = 0;
+			if (line.compare(0, 1, "\\") == 0 && line.compare(0, 2, "\\v") != 0)
+				end_paragraph(para, s, ds);
+			else if (!para.empty())
+				para += ' ';
+
+			while (i < line.size())
+			{
+				if (line[i] != '\\')
+				{
+					para += line[i++];
+					continue;
+				}
+
+				// Drop the marker, keeping a verse marker's number.
+				const std::string::size_type e = std::min(line.find(' ', i), line.size());
+				const bool verse = line.compare(i, e - i, "\\v") == 0;
+				i = e + 1;
+				if (verse && i < line.size())
+				{
+					const std::string::size_type n = std::min(line.find(' ', i), line.size());
+					para.append(line, i, n - i);
+					para += ' ';
+					i = n + 1;
+				}
+			}
+		});
+		end_paragraph(para, s, ds);
+	}
+
+
+	std::string json_string(const std::string & s)
+	{
+		std::string out = "\"";
+		for (std::string::const_iterator c = s.begin(); c != s.end(); ++c)
+		{
+			switch (*c)
+			{
+			case '"':	out += "\\\"";	break;
+			case '\\':	out += "\\\\";	break;
+			default:
+				if (static_cast<unsigned char>(*c) < 0x20)
+				{
+					char esc[8];
+					std::sprintf(esc, "\\u%04x", *c);
+					out += esc;
+				}
+				else
+					out += *c;
+			}
+		}
+		return out + '"';
+	}
+
+
+	void write_json(std::ostream & out, const std::string & path, const composer & comp)
+	{
+		char buf[64];
+		out << "{\"file\":" << json_string(path) << ",\"lines\":[";
+		for (composer::lines_t::const_iterator l = comp.lines().begin(), l_e = comp.lines().end(); l != l_e; ++l)
+		{
+			const wax_line & wl = **l;
+			std::sprintf(buf, "%.3f", ToDouble(wl.GetYPosition()));
+			out << (l == comp.lines().begin() ? "" : ",") 
+				<< "{\"start\":" << wl.start() << ",\"span\":" << wl.span() << ",\"y\":" << buf << ",\"glyphs\":[";
+
+			bool first = true;
+			for (wax_line::runs_t::const_iterator r = wl.runs().begin(); r != wl.runs().end(); ++r)
+			{
+				const wax_run & wr = dynamic_cast<const wax_run &>(**r);
+				double x = ToDouble(wl.GetXPosition() + wr.GetXPosition());
+				for (wax_run::glyphs_t::const_iterator g = wr.glyphs().begin(); g != wr.glyphs().end(); ++g)
+				{
+					std::sprintf(buf, "[%u,%.3f,%.3f]", g->id, x + g->x_offset, ToDouble(wr.GetYPosition()) + g->y_offset);
+					out << (first ? "" : ",") << buf;
+					x += g->advance;
+					first = false;
+				}
+			}
+			out << "]}";
+		}
+		out << "]}\n";
+	}
+
+
+	template <typename T>
+	void put(std::ostream & out, T v)
+	{
+		unsigned char b[sizeof(T)];
+		std::memcpy(b, &v, sizeof(T));
+		for (size_t i = 0; i != sizeof(T); ++i)
+			out.put(char(b[i]));
+	}
+
+
+	void write_binary(std::ostream & out, const composer & comp)
+	{
+		out.write("GRND", 4);
+		put<uint32>(out, 1);
+		for (composer::lines_t::const_iterator l = comp.lines().begin(), l_e = comp.lines().end(); l != l_e; ++l)
+		{
+			const wax_line & wl = **l;
+			put<int32>(out, wl.start());
+			put<int32>(out, wl.span());
+			put<float>(out, ToFloat(wl.GetYPosition()));
+			put<uint32>(out, uint32(wl.runs().size()));
+			for (wax_line::runs_t::const_iterator r = wl.runs().begin(); r != wl.runs().end(); ++r)
+			{
+				const wax_run & wr = dynamic_cast<const wax_run &>(**r);
+				const float x = ToFloat(wl.GetXPosition() + wr.GetXPosition());
+				put<float>(out, x);
+				put<float>(out, ToFloat(wr.GetYPosition()));
+				put<uint32>(out, uint32(wr.glyphs().size()));
+				float gx = 0;
+				for (wax_run::glyphs_t::const_iterator g = wr.glyphs().begin(); g != wr.glyphs().end(); ++g)
+				{
+					put<uint16>(out, g->id);
+					put<float>(out, x + gx + g->x_offset);
+					put<float>(out, g->y_offset);
+					gx += g->advance;
+				}
+			}
+		}
+		put<int32>(out, 0);
+		put<int32>(out, -1);
+	}
+
+
+	std::string output_path(const options & opts, const std::string & path)
+	{
+		std::string::size_type slash = path.find_last_of("/\\");
+		const std::string base = slash == std::string::npos ? path : path.substr(slash + 1);
+		return opts.output_dir + "/" + base + (opts.format == binary ? ".bin" : ".json");
+	}
+
+
+	/* Fingerprint files have a line for each paragraph composed: 
+	the input path, the paragraph number from 0 and the fingerprint in hex,
+	separated by tabs.
+	*/
+	bool write_fingerprints(const std::string & path, const std::vector<std::string> & files, 
+							const std::vector<composer::fingerprints_t> & fingerprints)
+	{
+		std::ofstream out(path.c_str());
+		char buf[32];
+		for (size_t f = 0; f != files.size(); ++f)
+			for (size_t p = 0; p != fingerprints[f].size(); ++p)
+			{
+				std::sprintf(buf, "%016llx", fingerprints[f][p]);
+				out << files[f] << '\t' << p << '\t' << buf << '\n';
+			}
+		return bool(out);
+	}
+
+
+	bool check_fingerprints(const std::string & path, const std::vector<std::string> & files, 
+							const std::vector<composer::fingerprints_t> & fingerprints)
+	{
+		std::string golden_text;
+		if (!read_file(path, golden_text))
+		{
+			std::cerr << "grind-typeset: cannot read " << path << std::endl;
+			return false;
+		}
+
+		typedef std::map<std::pair<std::string, size_t>, fingerprint::value_t>	golden_t;
+		golden_t golden;
+		for_each_line(golden_text, [&](const std::string & line)
+		{
+			const std::string::size_type t1 = line.find('\t'), t2 = line.find('\t', t1 + 1);
+			if (t2 == std::string::npos)	return;
+			golden[std::make_pair(line.substr(0, t1), size_t(std::atol(line.c_str() + t1 + 1)))] 
+				= std::strtoull(line.c_str() + t2 + 1, nil, 16);
+		});
+
+		size_t total = 0, differ = 0;
+		for (size_t f = 0; f != files.size(); ++f)
+			for (size_t p = 0; p != fingerprints[f].size(); ++p, ++total)
+			{
+				const golden_t::const_iterator g = golden.find(std::make_pair(files[f], p));
+				if (g != golden.end() && g->second == fingerprints[f][p])
+					continue;
+
+				++differ;
+				std::cerr << "grind-typeset: " << files[f] << " paragraph " << p 
+						  << (g == golden.end() ? " is not in " : " differs from ") << path << std::endl;
+			}
+
+		std::fprintf(stderr, "%zu of %zu paragraphs differ from %s\n", differ, total, path.c_str());
+		return differ == 0;
+	}
+
+
+	std::mutex	stdout_lock;
+
+	void log_counters(const char * text)
+	{
+		std::fprintf(stderr, "grind-typeset: %s\n", text);
+	}
+
+
+	// Allocation count and bytes in total, by phase and by object kind.
+	void log_allocations(const std::string & what, size_t paragraphs, const allocations::table & allocs)
+	{
+		const allocations::tally total = allocs.total();
+		std::ostringstream out;
+		out.setf(std::ios::fixed);
+		out.precision(1);
+		out << "grind-typeset: " << what << ": " << total.count << " allocations, " << total.bytes << " bytes, "
+			<< (paragraphs ? total.count/double(paragraphs) : 0.0) << " per paragraph; by phase";
+		for (int p = 0; p != allocations::phases; ++p)
+		{
+			const allocations::tally pt = allocs.total(allocations::phase_t(p));
+			if (pt.count)	out << ' ' << allocations::name(allocations::phase_t(p)) << ' ' << pt.count << '/' << pt.bytes;
+		}
+		out << "; by kind";
+		for (int k = 0; k != allocations::kinds; ++k)
+		{
+			const allocations::tally kt = allocs.total(allocations::kind_t(k));
+			if (kt.count)	out << ' ' << allocations::name(allocations::kind_t(k)) << ' ' << kt.count << '/' << kt.bytes;
+		}
+
+		std::lock_guard<std::mutex> lock(stdout_lock);
+		std::cerr << out.str() << std::endl;
+	}
+
+	bool typeset_file(const options & opts, drawing_style & ds, gr_face_cache & faces, const hyphenator * hyphens, 
+					  const std::string & path, totals & t, composer::fingerprints_t * fingerprints)
+	{
+		std::string text;
+		if (!read_file(path, text))
+		{
+			std::cerr << "grind-typeset: cannot read " << path << std::endl;
+			return false;
+		}
+
+		story s;
+		if (opts.markup)	read_markup(text, s, ds);
+		else				read_plain(text, s, ds);
+
+		const column		col(opts.width, 1.0e12);
+		composer			comp(s, col, faces, opts.threads, opts.look_ahead);
+		const balance_limits	balance = { TextIndex(opts.balance), 8 };
+		comp.set_balance(balance);
+		comp.set_hyphenator(hyphens);
+		allocations::table	allocs, before;
+		allocations::snapshot(before);
+		if (comp.compose() != s.length() || !comp.rebuild(fingerprints))
+		{
+			std::cerr << "grind-typeset: composition failed in " << path << std::endl;
+			return false;
+		}
+		allocations::snapshot(allocs);
+		allocs -= before;
+		allocs += comp.worker_allocations();
+
+		size_t paragraphs = 0;
+		for (TextIndex i = 0; i != s.length(); ++i)
+			paragraphs += s.text()[i] == kTextChar_CR;
+		t.paragraphs += paragraphs;
+		t.lines += comp.lines().size();
+		t.chars += s.length();
+		t.allocs += allocs;
+		if (opts.report_allocations)
+			log_allocations(path, paragraphs, allocs);
+
+		if (opts.format == none)	return true;
+
+		if (!opts.output_dir.empty())
+		{
+			const std::string out_path = output_path(opts, path);
+			std::ofstream out(out_path.c_str(), std::ios::binary);
+			if (opts.format == binary)	write_binary(out, comp);
+			else						write_json(out, path, comp);
+			if (!out)
+			{
+				std::cerr << "grind-typeset: cannot write " << out_path << std::endl;
+				return false;
+			}
+		}
+		else
+		{
+			std::ostringstream out;
+			write_json(out, path, comp);
+			std::lock_guard<std::mutex> lock(stdout_lock);
+			std::cout << out.str();
+		}
+
+		return true;
+	}
+}
+
+
+int main(int argc, char * argv[])
+{
+	options opts;
+	if (!parse_args(argc, argv, opts))
+	{
+		usage();
+		return 2;
+	}
+
+	std::unique_ptr<font> f(font::load(opts.font_path));
+	if (!f)
+	{
+		std::cerr << "grind-typeset: cannot load font " << opts.font_path << std::endl;
+		return 1;
+	}
+
+	drawing_style ds(*f, opts.size);
+	ds.alignment = opts.alignment;
+	if (opts.leading > 0)	ds.leading = opts.leading;
+
+	// A compiled image is used in place from its mapping, which must 
+	// outlive the hyphenator. Any file can be given, so it is verified 
+	// before it is mapped.
+	std::unique_ptr<mapped_file>	image;
+	hyphenator						hyphens;
+	if (!opts.patterns_path.empty())
+	{
+		image.reset(new mapped_file(opts.patterns_path));
+		std::string patterns;
+		const bool loaded = image->is_open() && hyphenator::is_image(image->data(), image->size())
+							? hyphenator::verify(image->data(), image->size()) && hyphens.map(image->data(), image->size())
+							: read_file(opts.patterns_path, patterns) && hyphens.load(patterns.data(), patterns.size());
+		if (!loaded)
+		{
+			std::cerr << "grind-typeset: cannot load patterns " << opts.patterns_path << std::endl;
+			return 1;
+		}
+	}
+
+	if (opts.counters_every)
+		counters::set_log(log_counters, opts.counters_every);
+
+	if (!opts.record_path.empty() && !recorder::open(opts.record_path.c_str()))
+	{
+		std::cerr << "grind-typeset: cannot write " << opts.record_path << std::endl;
+		return 1;
+	}
+
+	// Workers take the next file from a shared counter and share a face 
+	// cache.
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::atomic<size_t>		next(0);
+	std::vector<totals>		worker_totals(std::min<size_t>(opts.jobs, opts.files.size()));
+	const bool				want_fingerprints = !opts.fingerprints_path.empty() || !opts.golden_path.empty();
+	std::vector<composer::fingerprints_t>	fingerprints(opts.files.size());
+	std::vector<std::thread>	workers;
+	gr_face_cache			faces(4, 0);
+	for (size_t w = 0; w != worker_totals.size(); ++w)
+	{
+		workers.push_back(std::thread([&, w]()
+		{
+			const gr_face_cache::sharing	sharing(faces);
+			totals & t = worker_totals[w];
+			for (size_t i; (i = next++) < opts.files.size();)
+			{
+				++t.files;
+				if (!typeset_file(opts, ds, faces, opts.patterns_path.empty() ? nil : &hyphens, opts.files[i], t, want_fingerprints ? &fingerprints[i] : nil))
+					++t.failed;
+			}
+		}));
+	}
+	for (size_t w = 0; w != workers.size(); ++w)
+		workers[w].join();
+
+	totals sum;
+	for (size_t w = 0; w != worker_totals.size(); ++w)
+		sum += worker_totals[w];
+	const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::fprintf(stderr, "%zu files (%zu failed), %zu paragraphs, %zu lines, %zu chars in %.3fs: %.0f lines/s, %.0f chars/s\n",
+				 sum.files, sum.failed, sum.paragraphs, sum.lines, sum.chars, secs, 
+				 secs > 0 ? sum.lines/secs : 0.0, secs > 0 ? sum.chars/secs : 0.0);
+
+	if (opts.counters_every)
+		counters::dump(log_counters);
+
+	if (opts.report_allocations)
+		log_allocations("all files", sum.paragraphs, sum.allocs);
+
+	if (!opts.fingerprints_path.empty() && !write_fingerprints(opts.fingerprints_path, opts.files, fingerprints))
+	{
+		std::cerr << "grind-typeset: cannot write " << opts.fingerprints_path << std::endl;
+		return 1;
+	}
+
+	if (!opts.golden_path.empty() && !check_fingerprints(opts.golden_path, opts.files, fingerprints))
+		return 1;
+
+	recorder::close();
+
+	if (!opts.trace_path.empty())
+	{
+		std::ofstream out(opts.trace_path.c_str());
+		trace::export_chrome_json(out);
+		if (!out)
+		{
+			std::cerr << "grind-typeset: cannot write " << opts.trace_path << std::endl;
+			return 1;
+		}
+	}
+
+	return sum.failed ? 1 : 0;
+}
@@ -0,0 +1,176 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+// Interface headers
+// Library headers
+// Module header
+#include "Allocations.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+using namespace nrsc::allocations;
+
+#if defined(_MSC_VER)
+#define NRSC_THREAD_LOCAL	__declspec(thread)
+#else
+#define NRSC_THREAD_LOCAL	__thread
+#endif
+
+namespace
+{
+	const char * const phase_names[phases] =
+	{
+		"other",
+		"compose",
+		"fill",
+		"line_break",
+		"justify",
+		"rebuild",
+		"wax"
+	};
+
+	const char * const kind_names[kinds] =
+	{
+		"clusters",
+		"glyphs",
+		"runs",
+		"tiles",
+		"text",
+		"render"
+	};
+
+	NRSC_THREAD_LOCAL table		tallies;
+	NRSC_THREAD_LOCAL phase_t	current = other;
+}
+
+
+tally table::total() const
+{
+	tally t = {0, 0};
+	for (int p = 0; p != phases; ++p)
+	{
+		const tally pt = total(phase_t(p));
+		t.count += pt.count;
+		t.bytes += pt.bytes;
+	}
+	return t;
+}
+
+
+tally table::total(phase_t p) const
+{
+	tally t = {0, 0};
+	for (int k = 0; k != kinds; ++k)
+	{
+		t.count += entries[p][k].count;
+		t.bytes += entries[p][k].bytes;
+	}
+	return t;
+}
+
+
+tally table::total(kind_t k) const
+{
+	tally t = {0, 0};
+	for (int p = 0; p != phases; ++p)
+	{
+		t.count += entries[p][k].count;
+		t.bytes += entries[p][k].bytes;
+	}
+	return t;
+}
+
+
+table & table::operator += (const table & rhs)
+{
+	for (int p = 0; p != phases; ++p)
+		for (int k = 0; k != kinds; ++k)
+		{
+			entries[p][k].count += rhs.entries[p][k].count;
+			entries[p][k].bytes += rhs.entries[p][k].bytes;
+		}
+	return *this;
+}
+
+
+table & table::operator -= (const table & rhs)
+{
+	for (int p = 0; p != phases; ++p)
+		for (int k = 0; k != kinds; ++k)
+		{
+			entries[p][k].count -= rhs.entries[p][k].count;
+			entries[p][k].bytes -= rhs.entries[p][k].bytes;
+		}
+	return *this;
+}
+
+
+const char * allocations::name(phase_t p)
+{
+	return p < phases ? phase_names[p] : "";
+}
+
+
+const char * allocations::name(kind_t k)
+{
+	return k < kinds ? kind_names[k] : "";
+}
+
+
+void allocations::note(kind_t k, size_t bytes)
+{
+	tally & t = tallies.entries[current][k];
+	++t.count;
+	t.bytes += bytes;
+}
+
+
+void allocations::snapshot(table & t)
+{
+	t = tallies;
+}
+
+
+void allocations::reset()
+{
+	tallies = table();
+}
+
+
+phase_t allocations::enter(phase_t p)
+{
+	const phase_t previous = current;
+	current = p;
+	return previous;
+}
+
+
+void allocations::leave(phase_t previous)
+{
+	current = previous;
+}
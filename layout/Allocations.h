@@ -0,0 +1,166 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <cstddef>
+#include <memory>
+// Interface headers
+// Library headers
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+/* Allocation tracking for the composer.
+When NRSC_ALLOCATIONS is defined every allocation the engine makes for its 
+own objects is counted, with its size, against the kind of object and the 
+composer phase it was made in. NRSC_ALLOC_PHASE marks the enclosing scope 
+as a phase, nested phases take precedence until they end. The containers 
+behind clusters, runs, tiles and lines get their allocator from 
+allocations::allocator, and NRSC_ALLOC_NOTE records buffers allocated 
+directly. Without NRSC_ALLOCATIONS the macros expand to nothing and the 
+containers use std::allocator.
+
+Tallies are kept per thread, so a snapshot taken before and after some 
+work on one thread gives the allocations made by that work.
+*/
+#if defined(NRSC_ALLOCATIONS)
+#define NRSC_ALLOC_PHASE(p)			nrsc::allocations::phase_scope const nrsc_alloc_phase_(nrsc::allocations::p)
+#define NRSC_ALLOC_NOTE(k, bytes)	nrsc::allocations::note(nrsc::allocations::k, bytes)
+#else
+#define NRSC_ALLOC_PHASE(p)			((void)0)
+#define NRSC_ALLOC_NOTE(k, bytes)	((void)0)
+#endif
+
+namespace nrsc 
+{
+namespace allocations
+{
+	enum phase_t
+	{
+		other,			// Outside any composer phase.
+		compose,		// compose_line, outside the phases below.
+		fill,			// Shaping text into runs.
+		line_break,		// Breaking tiles.
+		justify,		// Aligning and justifying rebuilt tiles.
+		rebuild,		// rebuild_line, outside the phases above and below.
+		wax,			// Emitting wax runs.
+		phases
+	};
+
+	enum kind_t
+	{
+		clusters,		// Cluster list nodes in runs.
+		glyphs,			// Glyph buffers in clusters.
+		runs,			// Run objects.
+		tiles,			// Tile run lists and line tile nodes.
+		text,			// Text copied out of the story for shaping.
+		render,			// Glyph position and width arrays.
+		kinds
+	};
+
+	struct tally
+	{
+		unsigned long long	count,
+							bytes;
+	};
+
+	// A tally for each phase and kind of object.
+	struct table
+	{
+		tally	entries[phases][kinds];
+
+		tally	total() const;
+		tally	total(phase_t) const;
+		tally	total(kind_t) const;
+		table &	operator += (const table &);
+		table &	operator -= (const table &);
+	};
+
+	const char *	name(phase_t);
+	const char *	name(kind_t);
+
+	void	note(kind_t k, size_t bytes);
+
+	// The calling thread's tallies.
+	void	snapshot(table & t);
+	void	reset();
+
+	phase_t	enter(phase_t);
+	void	leave(phase_t previous);
+
+
+	class phase_scope
+	{
+		const phase_t	_previous;
+
+		// Hide copy constructor and assignment operator.
+		phase_scope(const phase_scope &);
+		phase_scope & operator = (const phase_scope &);
+
+	public:
+		explicit phase_scope(phase_t p) : _previous(enter(p)) {}
+		~phase_scope() { leave(_previous); }
+	};
+
+
+	/* A std::allocator that notes each allocation as kind K.
+	*/
+	template <typename T, kind_t K>
+	class tracking_allocator : public std::allocator<T>
+	{
+	public:
+		template <typename U> 
+		struct rebind { typedef tracking_allocator<U, K> other; };
+
+		tracking_allocator() throw() {}
+		tracking_allocator(const tracking_allocator & rhs) throw() : std::allocator<T>(rhs) {}
+		template <typename U> 
+		tracking_allocator(const tracking_allocator<U, K> & rhs) throw() : std::allocator<T>(rhs) {}
+
+		T * allocate(size_t n, const void * = 0)
+		{
+			note(K, n*sizeof(T));
+			return std::allocator<T>::allocate(n);
+		}
+	};
+
+
+	// The allocator containers of kind K should use.
+	template <typename T, kind_t K>
+	struct allocator
+	{
+#if defined(NRSC_ALLOCATIONS)
+		typedef tracking_allocator<T, K>	type;
+#else
+		typedef std::allocator<T>			type;
+#endif
+	};
+}
+
+} // end of namespace nrsc
\ No newline at end of file
@@ -39,6 +39,7 @@ const cluster::penalty::type
 	cluster::penalty::mandatory		= -10000.0,
 	cluster::penalty::whitespace	= -1.0,
 	cluster::penalty::word			= -0.5,
+	cluster::penalty::hyphen		= -0.25,
 	cluster::penalty::intra			= 0.5,
 	cluster::penalty::letter		= 0.75,
 	cluster::penalty::clip			= 1,
@@ -86,35 +87,58 @@ void cluster::trim(const PMReal alt_ltr_spc)
 }
 
 
+const unsigned char glyf::stretch_classes[] = 
+{
+	/* fill   */	1 << glyf::fill,
+	/* space  */	1 << glyf::space | 1 << glyf::letter | 1 << glyf::glyph,
+	/* letter */	1 << glyf::letter | 1 << glyf::glyph,
+	/* glyph  */	1 << glyf::glyph,
+	/* fixed  */	1 << glyf::fixed,
+	/* tab    */	0
+};
+
+
 void cluster::calculate_stretch(const PMReal & space_width, const glyf::stretch & js, glyf::stretch & s) const
 {
+	// The per class increments only depend on the space width, except 
+	// glyph stretch which is proportional to each glyph's advance.
+	const PMReal	fill_min = space_width*js[glyf::fill].min,
+					fill_max = space_width*js[glyf::fill].max,
+					space_min = space_width*js[glyf::space].min,
+					space_max = space_width*js[glyf::space].max,
+					letter_min = space_width*js[glyf::letter].min,
+					letter_max = space_width*js[glyf::letter].max;
+
 	for (cluster::const_iterator g = begin(), g_e = end(); g != g_e; ++g)
 	{
-		const glyf::justification_t level = g->justification();
+		const unsigned char classes = glyf::stretch_classes[g->justification()];
 
-		switch(level)
+		if (classes & 1 << glyf::fill)
 		{
-		case glyf::fill:
-			s[glyf::fill].min += space_width*js[glyf::fill].min;
-			s[glyf::fill].max += space_width*js[glyf::fill].max;
+			s[glyf::fill].min += fill_min;
+			s[glyf::fill].max += fill_max;
 			++s[glyf::fill].num;
-			break;
-		case glyf::space:
-			s[glyf::space].min += space_width*js[glyf::space].min;
-			s[glyf::space].max += space_width*js[glyf::space].max;
+		}
+		if (classes & 1 << glyf::space)
+		{
+			s[glyf::space].min += space_min;
+			s[glyf::space].max += space_max;
 			++s[glyf::space].num;
-		case glyf::letter:
-			s[glyf::letter].min += space_width*js[glyf::letter].min;
-			s[glyf::letter].max += space_width*js[glyf::letter].max;
+		}
+		if (classes & 1 << glyf::letter)
+		{
+			s[glyf::letter].min += letter_min;
+			s[glyf::letter].max += letter_max;
 			++s[glyf::letter].num;
-		case glyf::glyph:
-			s[glyf::glyph].min += g->advance()*js[glyf::glyph].min;
-			s[glyf::glyph].max += g->advance()*js[glyf::glyph].max;
+		}
+		if (classes & 1 << glyf::glyph)
+		{
+			const PMReal advance = g->advance();
+			s[glyf::glyph].min += advance*js[glyf::glyph].min;
+			s[glyf::glyph].max += advance*js[glyf::glyph].max;
 			++s[glyf::glyph].num;
-			break;
-		case glyf::fixed:
-			++s[glyf::fixed].num;
-			break;
 		}
+		if (classes & 1 << glyf::fixed)
+			++s[glyf::fixed].num;
 	}
 }
@@ -32,6 +32,7 @@ THE SOFTWARE.
 // Interface headers
 // Library headers
 // Module header
+#include "Allocations.h"
 
 // Forward declarations
 // InDesign interfaces
@@ -53,6 +54,10 @@ public:
 	enum justification_t		{fill, space, letter, glyph, fixed, tab};
 	typedef struct { PMReal min, max; TextIndex num; }	stretch[5];
 
+	// Bit set of the stretch classes each justification level contributes 
+	// to. A space also stretches as a letter, and both as a glyph.
+	static const unsigned char	stretch_classes[];
+
 private:
 	PMReal			_width;
 	PMPoint			_pos;
@@ -136,10 +141,10 @@ void glyf::set_glue() throw()
 
 
 
-class cluster : private std::vector<glyf>
+class cluster : private std::vector<glyf, allocations::allocator<glyf, allocations::glyphs>::type>
 {
 private:
-	typedef std::vector<glyf>	base_t;
+	typedef std::vector<glyf, allocations::allocator<glyf, allocations::glyphs>::type>	base_t;
 
 	unsigned char	_span;
 	float				_penalty;
@@ -161,6 +166,7 @@ public:
 		static const type	mandatory,
 							whitespace,
 							word,
+							hyphen,
 							intra,
 							letter,
 							clip,
@@ -192,7 +198,7 @@ public:
 	void trim(const PMReal ws);
 
 	// Properties
-	PMReal			width() const;
+	PMReal			width() const throw();
 	penalty::type	break_penalty() const;
 	penalty::type &	break_penalty();
 	bool			whitespace() const;
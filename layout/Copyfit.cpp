@@ -0,0 +1,134 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+// Language headers
+#include <algorithm>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IComposeScanner.h>
+// Library headers
+// Module header
+#include "Copyfit.h"
+#include "Trace.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+
+namespace
+{
+	// How close the bisection gets to the limit for each axis: a hundredth 
+	// of a point of tracking, a twentieth of a percent of scale or size.
+	const PMReal	precision[] = {0.01, 0.0005, 0.0005};
+}
+
+
+copyfitter::copyfitter(IComposeScanner & scanner, gr_face_cache & faces, TextIndex start, TextIndex end, 
+					   const hyphenator * hyphens)
+: _ok(true)
+{
+	NRSC_TRACE_SCOPE("copyfitter::copyfitter");
+	for (TextIndex p = start; _ok && p < end;)
+	{
+		int32 span = 0;
+		scanner.GetParagraphStyleAt(p, &span);
+		const TextIndex p_end = span > 0 ? std::min(p + TextIndex(span), end) : end;
+
+		_paragraphs.push_back(new measurer(scanner, faces, p, p_end, hyphens));
+		_ok = _paragraphs.back()->shaped();
+		p = p_end;
+	}
+}
+
+
+copyfitter::~copyfitter() throw()
+{
+	for (std::vector<measurer *>::iterator m = _paragraphs.begin(), m_e = _paragraphs.end(); m != m_e; ++m)
+		delete *m;
+}
+
+
+measurer::adjustment copyfitter::adjustment(axis_t axis, const PMReal & value)
+{
+	measurer::adjustment adj;
+	switch (axis)
+	{
+	case tracking:		adj.tracking = value;		break;
+	case glyph_scale:	adj.glyph_scale = value;	break;
+	case point_size:	adj.size = value;			break;
+	}
+	return adj;
+}
+
+
+// Whether the paragraphs set within t at width with adj made to them.
+bool copyfitter::fits(const PMReal & width, const target & t, const measurer::adjustment & adj) const
+{
+	if (!_ok)	return false;
+
+	size_t				lines = 0;
+	PMReal				depth = 0;
+	measurer::lines_t	measured;
+	for (std::vector<measurer *>::const_iterator m = _paragraphs.begin(), m_e = _paragraphs.end(); m != m_e; ++m)
+	{
+		if (!(*m)->measure(width, measured, adj))	return false;
+
+		lines += measured.size();
+		depth += measurer::depth(measured);
+		if ((t.lines && lines > t.lines) || (t.depth > 0 && depth > t.depth))
+			return false;
+	}
+	return true;
+}
+
+
+/* Find the largest value along axis, between min and max, at which the 
+paragraphs still fit t at width: the least a setting must come down for 
+text that overruns, or how far it can go up to fill a short frame. Tracking 
+is in points, glyph scale and point size are ratios of those set.
+Returns false if the paragraphs do not fit even at min.
+*/
+bool copyfitter::solve(axis_t axis, const PMReal & width, const target & t, 
+					   const PMReal & min, const PMReal & max, PMReal & value) const
+{
+	NRSC_TRACE_SCOPE("copyfitter::solve");
+	if (!fits(width, t, adjustment(axis, min)))	return false;
+
+	PMReal lo = min, hi = max;
+	if (fits(width, t, adjustment(axis, hi)))
+		lo = hi;
+
+	// Line breaking is only nearly monotonic in the setting, so this finds 
+	// a value that fits next to one that does not rather than the largest.
+	while (hi - lo > precision[axis])
+	{
+		const PMReal mid = (lo + hi)/2;
+		if (fits(width, t, adjustment(axis, mid)))	lo = mid;
+		else										hi = mid;
+	}
+
+	value = lo;
+	return true;
+}
@@ -0,0 +1,91 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#pragma once
+
+// Language headers
+#include <vector>
+// Interface headers
+// Library headers
+#include <textiterator.h>
+// Module header
+#include "Measure.h"
+
+// Forward declarations
+// InDesign interfaces
+class IComposeScanner;
+// Graphite forward delcarations
+
+namespace nrsc 
+{
+// Project forward declarations
+class gr_face_cache;
+
+/* copyfitter class
+Finds how far to change the tracking, glyph scale or point size of a run of 
+paragraphs for it to set in no more than a number of lines, or no deeper 
+than a frame, at a given width. Each paragraph is shaped once into a 
+measurer and every trial of a bisection measures them all with a 
+measurer::adjustment, which rescales the shaped advances, so no trial 
+shapes or composes anything. Depth is the sum of the lines' leading.
+*/
+class copyfitter
+{
+public:
+	enum axis_t {tracking, glyph_scale, point_size};
+
+	// What the text must fit in, either limit 0 for none.
+	struct target
+	{
+		size_t	lines;
+		PMReal	depth;
+	};
+
+	copyfitter(IComposeScanner & scanner, gr_face_cache & faces, TextIndex start, TextIndex end, 
+			   const hyphenator * hyphens = nil);
+	~copyfitter() throw();
+
+	bool	shaped() const;
+	bool	fits(const PMReal & width, const target & t, const measurer::adjustment & adj) const;
+	bool	solve(axis_t axis, const PMReal & width, const target & t, 
+				  const PMReal & min, const PMReal & max, PMReal & value) const;
+
+	static measurer::adjustment	adjustment(axis_t axis, const PMReal & value);
+
+private:
+	// Hide copy constructor and assignment operator.
+	copyfitter(const copyfitter &);
+	copyfitter & operator = (const copyfitter &);
+
+	std::vector<measurer *>	_paragraphs;
+	bool					_ok;
+};
+
+
+inline
+bool copyfitter::shaped() const
+{
+	return _ok;
+}
+
+} // end of namespace nrsc
\ No newline at end of file
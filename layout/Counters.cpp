@@ -0,0 +1,132 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <cstdio>
+// Interface headers
+// Library headers
+// Module header
+#include "Counters.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+
+std::atomic<counters::value_t>	counters::values[counters::count];
+
+namespace
+{
+	const char * const names[counters::count] =
+	{
+		"shaped_segments",
+		"shaped_chars",
+		"face_cache_hits",
+		"face_cache_misses",
+		"face_cache_evictions",
+		"line_retries",
+		"lines_composed",
+		"fill_chars",
+		"lines_rebuilt",
+		"wax_runs",
+		"break_candidates",
+		"lines_staged",
+		"staged_misses",
+		"shaped_ahead",
+		"hyphen_lookups",
+		"hyphen_cache_hits",
+		"wax_glyph_calls",
+		"lines_reused"
+	};
+
+	counters::log_fn			log_to = 0;
+	unsigned int				log_interval = 0;
+	std::atomic<unsigned int>	lines_since_log(0);
+}
+
+
+const char * counters::name(id c)
+{
+	return c < count ? names[c] : "";
+}
+
+
+counters::value_t counters::get(id c)
+{
+	return c < count ? values[c].load(std::memory_order_relaxed) : 0;
+}
+
+
+void counters::snapshot(value_t (& out)[count])
+{
+	for (int c = 0; c != count; ++c)
+		out[c] = values[c].load(std::memory_order_relaxed);
+}
+
+
+void counters::reset()
+{
+	for (int c = 0; c != count; ++c)
+		values[c].store(0, std::memory_order_relaxed);
+	lines_since_log.store(0, std::memory_order_relaxed);
+}
+
+
+void counters::set_log(log_fn log, unsigned int every_n_lines)
+{
+	log_to = log;
+	log_interval = every_n_lines;
+	lines_since_log.store(0, std::memory_order_relaxed);
+}
+
+
+void counters::dump(log_fn log)
+{
+	if (log == 0)	return;
+
+	value_t	v[count];
+	snapshot(v);
+
+	char	text[64*count];
+	size_t	len = 0;
+	for (int c = 0; c != count; ++c)
+		len += std::sprintf(text + len, "%s%s=%llu", c ? " " : "", names[c], v[c]);
+
+	// Derived per line averages.
+	const value_t lines = v[lines_composed], rebuilt = v[lines_rebuilt];
+	std::sprintf(text + len, " fill_chars_per_line=%.1f wax_runs_per_line=%.2f",
+				 lines ? double(v[fill_chars])/lines : 0.0,
+				 rebuilt ? double(v[wax_runs])/rebuilt : 0.0);
+	log(text);
+}
+
+
+void counters::tick()
+{
+	// Only the thread whose tick lands on a multiple of the interval logs.
+	if (log_to && log_interval 
+		&& (lines_since_log.fetch_add(1, std::memory_order_relaxed) + 1) % log_interval == 0)
+		dump(log_to);
+}
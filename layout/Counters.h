@@ -0,0 +1,103 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <atomic>
+#include <cstddef>
+// Interface headers
+// Library headers
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+/* Composer hot path counters.
+Counting is compiled in when NRSC_COUNTERS is defined, otherwise the 
+NRSC_COUNT macros expand to nothing and the query functions report zero. 
+Counters are atomics bumped with relaxed ordering, so threads composing at 
+once all count without racing, though a snapshot taken meanwhile need not 
+be consistent across counters.
+*/
+#if defined(NRSC_COUNTERS)
+#define NRSC_COUNT(c)			(nrsc::counters::values[nrsc::counters::c].fetch_add(1, std::memory_order_relaxed))
+#define NRSC_COUNT_N(c, n)		(nrsc::counters::values[nrsc::counters::c].fetch_add((n), std::memory_order_relaxed))
+#define NRSC_COUNTERS_TICK()	(nrsc::counters::tick())
+#else
+#define NRSC_COUNT(c)			((void)0)
+#define NRSC_COUNT_N(c, n)		((void)0)
+#define NRSC_COUNTERS_TICK()	((void)0)
+#endif
+
+namespace nrsc 
+{
+namespace counters
+{
+	enum id
+	{
+		shaped_segments,		// gr_make_seg calls
+		shaped_chars,			// characters passed to gr_make_seg
+		face_cache_hits,
+		face_cache_misses,
+		face_cache_evictions,
+		line_retries,			// need_retry_line asking for a line to be recomposed
+		lines_composed,
+		fill_chars,				// characters filled into tiles by fill_by_span
+		lines_rebuilt,
+		wax_runs,				// wax runs added to rebuilt lines
+		break_candidates,		// break points evaluated by break_into
+		lines_staged,			// lines composed off the host put on it by apply_staged_line
+		staged_misses,			// staged lines the host gave different tiles for
+		shaped_ahead,			// first lines filled from paragraphs shaped ahead
+		hyphen_lookups,			// words looked up by a hyphenator
+		hyphen_cache_hits,		// of those, words found memoized
+		wax_glyph_calls,		// IWaxGlyphs and IWaxGlyphsME calls rendering runs
+		lines_reused,			// recomposed lines the host kept its old wax line for
+		count
+	};
+
+	typedef unsigned long long	value_t;
+	typedef void (*log_fn)(const char * text);
+
+	extern std::atomic<value_t>	values[count];
+
+	// Query
+	const char *	name(id c);
+	value_t			get(id c);
+	void			snapshot(value_t (& out)[count]);
+	void			reset();
+
+	/** Log a dump of all counters every n composed lines.
+		@param log IN Called with the formatted dump, nil to stop logging.
+		@param every_n_lines IN The logging interval.
+	*/
+	void	set_log(log_fn log, unsigned int every_n_lines);
+	void	dump(log_fn log);
+	void	tick();
+}
+
+} // end of namespace nrsc
\ No newline at end of file
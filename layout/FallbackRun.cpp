@@ -23,6 +23,11 @@ THE SOFTWARE.
 */
 
 // Language headers
+#include <vector>
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define NRSC_SSE2_CLASSIFY
+#include <emmintrin.h>
+#endif
 // Interface headers
 #include "VCPlugInHeaders.h"
 #include <IDrawingStyle.h>
@@ -32,6 +37,7 @@ THE SOFTWARE.
 #include <PMRealGlyphPoint.h>
 #include <textiterator.h>
 // Module header
+#include "Allocations.h"
 #include "FallbackRun.h"
 
 // Forward declarations
@@ -40,9 +46,81 @@ THE SOFTWARE.
 // Project forward declarations
 using namespace nrsc;
 
-run * fallback_run::clone_empty() const
+namespace
 {
-	return new fallback_run();
+	inline
+	unsigned char icu_classify(const textchar c)
+	{
+		return u_isspace(c) 
+			? (u_isWhitespace(c) ? fallback_run::cc_space | fallback_run::cc_break : fallback_run::cc_space) 
+			: 0;
+	}
+
+
+	/* Latin-1 lookup table
+	Built once from the same ICU predicates the per character path uses, so the
+	fast path cannot disagree with it.
+	*/
+	class latin1_classes
+	{
+		unsigned char	_table[0x100];
+
+	public:
+		latin1_classes()
+		{
+			for (UChar32 c = 0; c != 0x100; ++c)
+				_table[c] = icu_classify(textchar(c));
+		}
+
+		unsigned char operator [] (const textchar c) const
+		{
+			return _table[c];
+		}
+	};
+
+	const latin1_classes	latin1;
+
+
+	inline
+	unsigned char classify_one(const textchar c)
+	{
+		if (c < 0x100)	return latin1[c];
+
+		return icu_classify(c);
+	}
+}
+
+
+void fallback_run::classify(const textchar * c, const textchar * const c_e, unsigned char * f)
+{
+#if defined(NRSC_SSE2_CLASSIFY)
+	// Printable ASCII (0x21-0x7E) never needs flags, so skip whole blocks
+	// of it eight code units at a time. Code units >= 0x8000 compare as 
+	// negative and so fail the lower bound test.
+	const __m128i lo = _mm_set1_epi16(0x20),
+				  hi = _mm_set1_epi16(0x7f);
+	for (; c_e - c >= 8; c += 8, f += 8)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c));
+		if (_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi16(v, lo), _mm_cmplt_epi16(v, hi))) == 0xffff)
+		{
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(f), _mm_setzero_si128());
+			continue;
+		}
+
+		for (int i = 0; i != 8; ++i)
+			f[i] = classify_one(c[i]);
+	}
+#endif
+	for (; c != c_e; ++c, ++f)
+		*f = classify_one(*c);
+}
+
+
+void fallback_run::classify_each(const textchar * c, const textchar * const c_e, unsigned char * f)
+{
+	for (; c != c_e; ++c, ++f)
+		*f = icu_classify(*c);
 }
 
 
@@ -55,35 +133,48 @@ bool fallback_run::layout_span(TextIterator ti, size_t span)
 	if (font == nil)
 		return false;
 
-	const PMReal min_width = _drawing_style->GetEmSpaceWidth(false)/48.0;
+	const PMReal min_width = _drawing_style->GetEmSpaceWidth(false)/48.0,
+				 space_width = _drawing_style->GetSpaceWidth();
 	WideString	chars;
 	ti.AppendToStringAndIncrement(&chars, span);
+	NRSC_ALLOC_NOTE(text, span*sizeof(textchar));
 
 	// Make a segment
+	const textchar * const text = chars.GrabUTF16Buffer(0);
 	PMRealGlyphPoint * gps = new PMRealGlyphPoint[span];
-	font->FillOutGlyphIDs(gps, span, chars.GrabUTF16Buffer(0), chars.NumUTF16TextChars());
+	NRSC_ALLOC_NOTE(render, span*sizeof(PMRealGlyphPoint));
+	font->FillOutGlyphIDs(gps, span, text, chars.NumUTF16TextChars());
 	font->GetKerns(gps, span);
 
+	// Classify the whole span up front, then mark zero width glyphs.
+	std::vector<unsigned char>	flags(span);
+	std::vector<PMReal>			widths(span);
+	NRSC_ALLOC_NOTE(render, span*(sizeof(unsigned char) + sizeof(PMReal)));
+	classify(text, text + span, &flags[0]);
+	for (size_t i = 0; i != span; ++i)
+	{
+		if (flags[i] & cc_space) continue;
+
+		widths[i] = font->GetGlyphWidth(gps[i].GetGlyphID());
+		if (widths[i] < min_width)
+			flags[i] |= cc_zero_width;
+	}
 
 	// Add the glyphs with their natural widths
 	PMReal prev_shift = 0;
-	PMRealGlyphPoint * gp = gps;
-	for (WideString::const_iterator c = chars.begin(); c != chars.end(); ++c, ++gp)
+	for (size_t i = 0; i != span; ++i)
 	{
-		const int gid = gp->GetGlyphID();
-		
-		if (u_isspace(*c))
-			add_glue(glyf::space, _drawing_style->GetSpaceWidth(), u_isWhitespace(*c) ? cluster::penalty::whitespace : cluster::penalty::never);
+		const unsigned char f = flags[i];
+
+		if (f & cc_space)
+			add_glue(glyf::space, space_width, f & cc_break ? cluster::penalty::whitespace : cluster::penalty::never);
 		else
-		{
-			PMReal glyph_width = font->GetGlyphWidth(gid);
-			add_letter(gid, glyph_width, cluster::penalty::letter, glyph_width < min_width);
-		}
+			add_letter(gps[i].GetGlyphID(), widths[i], cluster::penalty::letter, (f & cc_zero_width) != 0);
 
 		// Set the kerning.
 		glyf & last_glyf = back().back();
-		last_glyf.shift(PMPoint(gp->GetXPosition() - prev_shift, 0));
-		prev_shift = gp->GetXPosition();
+		last_glyf.shift(PMPoint(gps[i].GetXPosition() - prev_shift, 0));
+		prev_shift = gps[i].GetXPosition();
 	}
 	
 	delete [] gps;
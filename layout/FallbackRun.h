@@ -40,28 +40,48 @@ namespace nrsc
 
 class fallback_run : public run
 {
+	friend class run;
+
 	fallback_run();
 
 	// Prevent automatic copy-ctor and assignment generation
 	fallback_run(const fallback_run &);
 	fallback_run & operator = (const fallback_run &);
 
-	virtual bool layout_span(TextIterator first, size_t span);
-	virtual run * clone_empty() const;
+	bool layout_span(TextIterator first, size_t span);
 
 public:
+	// Classes layout_span gives each UTF-16 code unit, as flags.
+	enum
+	{
+		cc_space		= 1 << 0,	// Laid out as glue.
+		cc_break		= 1 << 1,	// A break opportunity after this glue.
+		cc_zero_width	= 1 << 2	// Attach the glyph to the preceding cluster.
+	};
+
 	fallback_run(IDrawingStyle * ds);
+
+	/** Classify the code units from c to c_e into f, looking Latin-1 up in 
+		a table and skipping printable ASCII eight at a time where SSE2 is 
+		available. Only sets cc_space and cc_break.
+	*/
+	static void	classify(const textchar * c, const textchar * const c_e, unsigned char * f);
+	/** As classify, asking ICU about each code unit in turn as layout_span 
+		once did, to check and time classify against.
+	*/
+	static void	classify_each(const textchar * c, const textchar * const c_e, unsigned char * f);
 };
 
 
 inline
 fallback_run::fallback_run()
+: run(fallback)
 {
 }
 
 inline
 fallback_run::fallback_run(IDrawingStyle * ds)
-: run(ds)
+: run(fallback, ds)
 {
 }
 
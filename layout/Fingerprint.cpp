@@ -0,0 +1,243 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <cmath>
+#include <cstring>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <ICompositionStyle.h>
+#include <IDrawingStyle.h>
+#include <IJustificationStyle.h>
+#include <IPMFont.h>
+#include <IWaxLine.h>
+// Library headers
+#include <TabStop.h>
+// Module header
+#include "Fingerprint.h"
+#include "Run.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+
+
+void fingerprint::mix(unsigned long v)
+{
+	for (int i = 0; i != 4; ++i, v >>= 8)
+	{
+		_hash ^= v & 0xff;
+		_hash *= prime;
+	}
+}
+
+
+void fingerprint::mix(const PMReal & r)
+{
+	mix(static_cast<unsigned long>(static_cast<long>(std::floor(ToDouble(r)*64 + 0.5))));
+}
+
+
+void fingerprint::mix_bits(const PMReal & r)
+{
+	const double	d = ToDouble(r);
+	value_t			v;
+	std::memcpy(&v, &d, sizeof v);
+	mix_bits(v);
+}
+
+
+void fingerprint::add_line(TextIndex offset, const IWaxLine & wl)
+{
+	mix(static_cast<unsigned long>(offset));
+	mix(wl.GetYAdvance());
+
+	const int32 n_tiles = wl.GetNumberOfTiles();
+	mix(static_cast<unsigned long>(n_tiles));
+	for (int32 t = 0; t != n_tiles; ++t)
+	{
+		mix(static_cast<unsigned long>(wl.GetTextSpanInTile(t)));
+		mix(wl.GetXPosition(t));
+		mix(wl.GetTargetWidth(t));
+	}
+}
+
+
+void fingerprint::add_run(const run & r, const PMReal & x, const PMReal & y)
+{
+	mix(static_cast<unsigned long>(r.span()));
+	mix(x);
+	mix(y);
+
+	// Glyph origins along the run, as render_run positions them.
+	PMReal advance = 0;
+	for (run::const_iterator cl = r.begin(), cl_e = r.end(); cl != cl_e; ++cl)
+	{
+		for (cluster::const_iterator g = cl->begin(), g_e = cl->end(); g != g_e; ++g)
+		{
+			mix(static_cast<unsigned long>(g->id()));
+			mix(advance + r._scale*g->pos().X());
+			mix(r._scale*g->pos().Y());
+			advance += r._scale*g->advance();
+		}
+	}
+}
+
+
+void fingerprint::add(const fingerprint & fp)
+{
+	mix(static_cast<unsigned long>(fp._hash));
+	mix(static_cast<unsigned long>(fp._hash >> 32));
+}
+
+
+void fingerprint::add_composed_line(bool first, const IWaxLine & wl)
+{
+	mix(static_cast<unsigned long>(first));
+	mix(wl.GetYAdvance());
+
+	const int32 n_tiles = wl.GetNumberOfTiles();
+	mix(static_cast<unsigned long>(n_tiles));
+	for (int32 t = 0; t != n_tiles; ++t)
+	{
+		mix(static_cast<unsigned long>(wl.GetTextSpanInTile(t)));
+		mix(wl.GetXPosition(t));
+		mix(wl.GetTargetWidth(t));
+	}
+
+	PMReal	drop_indent = 0;
+	int32	drop_lines = 0;
+	mix(static_cast<unsigned long>(wl.GetDropCapIndents(&drop_indent, &drop_lines)));
+	mix(drop_indent);
+	mix(static_cast<unsigned long>(drop_lines));
+	mix(static_cast<unsigned long>(wl.GetNextLineAffectedByDropcap()));
+}
+
+
+void fingerprint::add_style(const IDrawingStyle * style)
+{
+	mix_bits(static_cast<value_t>(style != nil));
+	if (style == nil)	return;
+
+	// The font by its path, as the recorder names it.
+	InterfacePtr<IPMFont> font(style->QueryFont());
+	const K2Vector<PMString> * const paths = font ? font->GetFullPath() : nil;
+	if (paths && !paths->empty())
+	{
+		const PMString & path = (*paths)[0];
+		for (PMString::const_iterator c = path.begin(), c_e = path.end(); c != c_e; ++c)
+			mix_bits(static_cast<value_t>(*c));
+	}
+	mix_bits(value_t(0));
+
+	mix_bits(style->GetPointSize());
+	mix_bits(style->GetLeading());
+	mix_bits(style->GetEffectiveBaseline());
+	mix_bits(style->GetSkewAngle());
+	mix_bits(style->GetXScale());
+	mix_bits(style->GetYScale());
+
+	InterfacePtr<ICompositionStyle>		cs(const_cast<IDrawingStyle *>(style), UseDefaultIID());
+	InterfacePtr<IJustificationStyle>	js(const_cast<IDrawingStyle *>(style), UseDefaultIID());
+	int16	drop_chars = 0, 
+			drop_lines = 0;
+	PMReal	ws[3], ls[3], gs[3];
+	if (cs)	cs->GetDropCapInfo(&drop_chars, &drop_lines);
+	if (js)
+	{
+		js->GetWordspace(&ws[0], &ws[1], &ws[2]);
+		js->GetLetterspace(&ls[0], &ls[1], &ls[2]);
+		js->GetGlyphscale(&gs[0], &gs[1], &gs[2]);
+	}
+
+	mix_bits(static_cast<value_t>(cs ? cs->GetParagraphAlignment() : ICompositionStyle::kTextAlignLeft));
+	mix_bits(static_cast<value_t>(cs && cs->GetNoBreak()));
+	mix_bits(static_cast<value_t>(drop_chars));
+	mix_bits(static_cast<value_t>(drop_lines));
+	mix_bits(cs ? cs->IndentLeftBody() : PMReal(0));
+	mix_bits(cs ? cs->IndentLeftFirst() : PMReal(0));
+	mix_bits(cs ? cs->IndentRightBody() : PMReal(0));
+	mix_bits(cs ? cs->GetTabStopAfter(0).GetPosition() : PMReal(0));
+	for (int i = 0; i != 3; ++i)	mix_bits(ws[i]);
+	for (int i = 0; i != 3; ++i)	mix_bits(ls[i]);
+	for (int i = 0; i != 3; ++i)	mix_bits(gs[i]);
+}
+
+
+void fingerprint::add_composed_run(const run & r, const PMReal & x)
+{
+	mix_bits(r.span());
+	mix_bits(x);
+	mix_bits(r._scale);
+
+	for (run::const_iterator cl = r.begin(), cl_e = r.end(); cl != cl_e; ++cl)
+	{
+		for (cluster::const_iterator g = cl->begin(), g_e = cl->end(); g != g_e; ++g)
+		{
+			mix_bits(g->id());
+			mix_bits(g->pos().X());
+			mix_bits(g->pos().Y());
+			mix_bits(g->advance());
+		}
+	}
+}
+
+
+void fingerprint::add_break(bool hyphen)
+{
+	mix(static_cast<unsigned long>(hyphen));
+}
+
+
+void fingerprint::add_wax_line(TextIndex offset, const IWaxLine & wl)
+{
+	add_line(offset, wl);
+	mix_bits(wl.GetYPosition());
+}
+
+
+void fingerprint::add_wax_run(const PMReal & x, const PMReal & y)
+{
+	mix_bits(x);
+	mix_bits(y);
+}
+
+
+void fingerprint::add_wax_glyph(Text::GlyphID id, float advance, float x_offset, float y_offset)
+{
+	mix_bits(static_cast<value_t>(id));
+	mix_bits(PMReal(advance));
+	mix_bits(PMReal(x_offset));
+	mix_bits(PMReal(y_offset));
+}
+
+
+void fingerprint::add_wax_mapping(const PMReal & width, int32 glyph_index, int32 num_glyphs)
+{
+	mix_bits(width);
+	mix_bits(static_cast<value_t>(glyph_index));
+	mix_bits(static_cast<value_t>(num_glyphs));
+}
@@ -0,0 +1,130 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+// Interface headers
+// Library headers
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+class IDrawingStyle;
+class IWaxLine;
+// Graphite forward delcarations
+
+namespace nrsc 
+{
+// Project forward declarations
+class run;
+
+/* fingerprint class
+A deterministic hash of composed output, for checking that a change to the 
+engine leaves layout alone. It covers each line's span and offset into its 
+paragraph, its tile spans, positions and widths, line height, and the id 
+and position of every glyph in its wax runs. Positions are quantized to 
+1/64 of a point so differences in the last bits of a float do not show. 
+Absolute y positions are left out, so a paragraph's fingerprint only 
+changes when the paragraph itself lays out differently.
+The hash is 64 bit FNV-1a over the values in little endian byte order, so 
+it is the same on every platform.
+A line as composed, before it has wax runs, gets a fingerprint of its own 
+from add_composed_line, add_style, add_composed_run and add_break: what 
+rebuilding it depends on, so a line composed again with the same one 
+rebuilds the same. Styles go in by the attributes layout reads from them, 
+as the recorder writes them, so two styles that set a line alike match 
+whichever objects they are. The runs' glyphs go in a word at a time without 
+quantizing, which is cheaper to compute on every line composed, so those 
+only compare within a session.
+What the host was given for a line can be fingerprinted from its wax with 
+add_wax_line, add_wax_run, add_wax_glyph and add_wax_mapping, all values 
+taken exactly, to check lines kept from an earlier composition against 
+ones composed afresh.
+*/
+class fingerprint
+{
+public:
+	typedef unsigned long long	value_t;
+
+	fingerprint();
+
+	value_t	value() const;
+	void	clear();
+
+	// Modifiers
+	void	add_line(TextIndex offset, const IWaxLine & wl);
+	void	add_run(const run & r, const PMReal & x, const PMReal & y);
+	void	add(const fingerprint & fp);
+	// Whether it starts its paragraph, its height, tiles and drop caps.
+	void	add_composed_line(bool first, const IWaxLine & wl);
+	void	add_style(const IDrawingStyle * style);
+	void	add_composed_run(const run & r, const PMReal & x);
+	// A tile's end and whether a hyphen is set there.
+	void	add_break(bool hyphen);
+	// As add_line, and the line's baseline.
+	void	add_wax_line(TextIndex offset, const IWaxLine & wl);
+	void	add_wax_run(const PMReal & x, const PMReal & y);
+	void	add_wax_glyph(Text::GlyphID id, float advance, float x_offset, float y_offset);
+	void	add_wax_mapping(const PMReal & width, int32 glyph_index, int32 num_glyphs);
+
+private:
+	static const value_t	basis = 14695981039346656037ULL,
+							prime = 1099511628211ULL;
+
+	void	mix(unsigned long v);
+	void	mix(const PMReal & r);
+	void	mix_bits(value_t v);
+	void	mix_bits(const PMReal & r);
+
+	value_t	_hash;
+};
+
+
+inline
+fingerprint::fingerprint()
+: _hash(basis)
+{
+}
+
+inline
+fingerprint::value_t fingerprint::value() const
+{
+	return _hash;
+}
+
+inline
+void fingerprint::clear()
+{
+	_hash = basis;
+}
+
+inline
+void fingerprint::mix_bits(value_t v)
+{
+	_hash = (_hash ^ v)*prime;
+	_hash ^= _hash >> 32;
+}
+
+} // end of namespace nrsc
\ No newline at end of file
@@ -0,0 +1,134 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <algorithm>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IWaxGlyphs.h>
+#include <IWaxGlyphsME.h>
+// Library headers
+// Module header
+#include "Allocations.h"
+#include "Counters.h"
+#include "GlyphBatch.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+
+
+glyph_batch::glyph_batch()
+: _buffer(nil),
+  _glyph_capacity(0),
+  _char_capacity(0),
+  _n_glyphs(0),
+  _n_chars(0),
+  _char_widths(nil),
+  _advances(nil),
+  _x_offsets(nil),
+  _y_offsets(nil),
+  _widths(nil),
+  _first_glyphs(nil),
+  _num_glyphs(nil),
+  _ids(nil)
+{
+}
+
+
+glyph_batch::~glyph_batch() throw()
+{
+	delete [] _buffer;
+}
+
+
+/* Move the arrays into a buffer with room for at least the given number of
+glyphs and characters, laid out widest element first so each is aligned.
+*/
+void glyph_batch::grow(size_t glyphs, size_t chars)
+{
+	glyphs = std::max(glyphs, _glyph_capacity);
+	chars = std::max(chars, _char_capacity);
+	const size_t bytes = chars*(sizeof(PMReal) + 2*sizeof(int32)) 
+					   + glyphs*(4*sizeof(float) + sizeof(Text::GlyphID));
+	NRSC_ALLOC_NOTE(render, bytes);
+
+	char * const	buffer = new char[bytes];
+	PMReal * const	char_widths = reinterpret_cast<PMReal *>(buffer);
+	float * const	advances = reinterpret_cast<float *>(char_widths + chars),
+		  * const	x_offsets = advances + glyphs,
+		  * const	y_offsets = x_offsets + glyphs,
+		  * const	widths = y_offsets + glyphs;
+	int32 * const	first_glyphs = reinterpret_cast<int32 *>(widths + glyphs),
+		  * const	num_glyphs = first_glyphs + chars;
+	Text::GlyphID * const ids = reinterpret_cast<Text::GlyphID *>(num_glyphs + chars);
+
+	std::copy(_char_widths, _char_widths + _n_chars, char_widths);
+	std::copy(_advances, _advances + _n_glyphs, advances);
+	std::copy(_x_offsets, _x_offsets + _n_glyphs, x_offsets);
+	std::copy(_y_offsets, _y_offsets + _n_glyphs, y_offsets);
+	std::fill(widths, widths + glyphs, 0.0f);
+	std::copy(_first_glyphs, _first_glyphs + _n_chars, first_glyphs);
+	std::copy(_num_glyphs, _num_glyphs + _n_chars, num_glyphs);
+	std::copy(_ids, _ids + _n_glyphs, ids);
+
+	delete [] _buffer;
+	_buffer = buffer;
+	_glyph_capacity = glyphs;
+	_char_capacity = chars;
+	_char_widths = char_widths;
+	_advances = advances;
+	_x_offsets = x_offsets;
+	_y_offsets = y_offsets;
+	_widths = widths;
+	_first_glyphs = first_glyphs;
+	_num_glyphs = num_glyphs;
+	_ids = ids;
+}
+
+
+void glyph_batch::submit(IWaxGlyphs & glyphs) const
+{
+	for (size_t i = 0; i != _n_glyphs; ++i)
+		glyphs.AddGlyph(_ids[i], _advances[i]);
+	NRSC_COUNT_N(wax_glyph_calls, _n_glyphs);
+
+	// Position shifted glyphs
+	InterfacePtr<IWaxGlyphsME> glyphs_me(&glyphs, UseDefaultIID());
+	if (glyphs_me != nil)
+	{
+		glyphs_me->AddGlyphMEData(int32(_n_glyphs), _x_offsets, _y_offsets, _widths);
+		NRSC_COUNT(wax_glyph_calls);
+	}
+
+	// Do the mappings
+	for (size_t i = 0; i != _n_chars; ++i)
+	{
+		glyphs.AddMappingWidth(_char_widths[i]);
+		glyphs.AddMappingRange(int32(i), _first_glyphs[i], _num_glyphs[i]);
+	}
+	NRSC_COUNT_N(wax_glyph_calls, 2*_n_chars);
+}
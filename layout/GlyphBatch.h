@@ -0,0 +1,145 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+// Interface headers
+// Library headers
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+class IWaxGlyphs;
+// Graphite forward delcarations
+
+namespace nrsc 
+{
+// Project forward declarations
+
+/* glyph_batch class
+A run's glyphs as the wax wants them: glyph ids, advances and offsets, and
+each character's width and glyph range, each in its own contiguous array.
+A run is walked once to fill the batch, which is then handed over in as 
+few host calls as IWaxGlyphs allows: one call per glyph and two per 
+character, which the interface has no bulk form of, and a single 
+IWaxGlyphsME call taking the offset arrays as they are. The arrays share one buffer that only ever grows, so a 
+batch costs one allocation and one kept between lines stops allocating.
+*/
+class glyph_batch
+{
+public:
+	glyph_batch();
+	~glyph_batch() throw();
+
+	// Capacity
+	size_t	glyphs() const;
+	size_t	chars() const;
+	void	reserve(size_t glyphs, size_t chars);
+
+	// Modifiers
+	void	clear();
+	void	add_glyph(Text::GlyphID id, float advance, float x_offset, float y_offset);
+	void	add_char(const PMReal & width, int32 glyph_index, int32 num_glyphs);
+
+	// Operations
+	void	submit(IWaxGlyphs & glyphs) const;
+
+private:
+	// Hide copy constructor and assignment operator.
+	glyph_batch(const glyph_batch &);
+	glyph_batch & operator = (const glyph_batch &);
+
+	void	grow(size_t glyphs, size_t chars);
+
+	char		  *	_buffer;
+	size_t			_glyph_capacity,
+					_char_capacity,
+					_n_glyphs,
+					_n_chars;
+	PMReal		  *	_char_widths;
+	float		  *	_advances,
+				  *	_x_offsets,
+				  *	_y_offsets,
+				  *	_widths;		// Extra widths for IWaxGlyphsME, all 0.
+	int32		  *	_first_glyphs,
+				  *	_num_glyphs;
+	Text::GlyphID *	_ids;
+};
+
+
+inline
+size_t glyph_batch::glyphs() const
+{
+	return _n_glyphs;
+}
+
+
+inline
+size_t glyph_batch::chars() const
+{
+	return _n_chars;
+}
+
+
+inline
+void glyph_batch::reserve(size_t glyphs, size_t chars)
+{
+	if (glyphs > _glyph_capacity || chars > _char_capacity)
+		grow(glyphs, chars);
+}
+
+
+inline
+void glyph_batch::clear()
+{
+	_n_glyphs = _n_chars = 0;
+}
+
+
+inline
+void glyph_batch::add_glyph(Text::GlyphID id, float advance, float x_offset, float y_offset)
+{
+	if (_n_glyphs == _glyph_capacity)	grow(2*_glyph_capacity + 16, _char_capacity);
+
+	const size_t i = _n_glyphs++;
+	_ids[i] = id;
+	_advances[i] = advance;
+	_x_offsets[i] = x_offset;
+	_y_offsets[i] = y_offset;
+}
+
+
+inline
+void glyph_batch::add_char(const PMReal & width, int32 glyph_index, int32 num_glyphs)
+{
+	if (_n_chars == _char_capacity)	grow(_glyph_capacity, 2*_char_capacity + 16);
+
+	const size_t i = _n_chars++;
+	_char_widths[i] = width;
+	_first_glyphs[i] = glyph_index;
+	_num_glyphs[i] = num_glyphs;
+}
+
+} // end of namespace nrsc
\ No newline at end of file
@@ -34,13 +34,15 @@ THE SOFTWARE.
 #include <graphite2/Font.h>
 
 // Module header
+#include "Counters.h"
 #include "GrFaceCache.h"
 
 using namespace nrsc;
 
 gr_face_cache::gr_face_cache(size_t capacity, unsigned int max_dwell)
 : _capacity(capacity), 
-  _max_dwell(max_dwell)
+  _max_dwell(max_dwell),
+  _sharers(0)
 {
 }
 
@@ -62,12 +64,18 @@ gr_face_cache::value_t gr_face_cache::operator [] (const key_t font)
 		|| path.empty())
 		return 0;
 
+	mutex::scope lock(_lock);
 	store_t::iterator i = std::find(_faces.begin(), _faces.end(), path);
 	if (i == _faces.end())
 	{
-		spring_clean();
-		i = _faces.insert(_faces.begin(), entry(path, face_from_platform_font(path)));
+		NRSC_COUNT(face_cache_misses);
+		if (_sharers == 0 && _capacity != 0)
+			spring_clean(_capacity - 1);
+		const bool preload = _sharers != 0;
+		i = _faces.insert(_faces.begin(), entry(path, face_from_platform_font(path, preload), preload));
 	}
+	else
+		NRSC_COUNT(face_cache_hits);
 
 //	freshen(i);
 	return i == _faces.end() ? 0 : (*i).face;
@@ -80,12 +88,13 @@ void gr_face_cache::destroy_entry(const entry & e)
 }
 
 
-void gr_face_cache::spring_clean()
+void gr_face_cache::spring_clean(size_t keep)
 {
-	while (_faces.size() >= _capacity)
+	while (_faces.size() > keep)
 	{
 		destroy_entry(_faces.back());
 		_faces.pop_back();
+		NRSC_COUNT(face_cache_evictions);
 	}
 }
 
@@ -94,18 +103,49 @@ void gr_face_cache::freshen(const store_t::iterator & i)
 	_faces.splice(_faces.begin(), _faces, i);
 }
 
-gr_face * gr_face_cache::face_from_platform_font(const PMString & path)
+void gr_face_cache::preload_all()
+{
+	for (store_t::iterator i = _faces.begin(); i != _faces.end(); ++i)
+	{
+		if (i->preloaded)	continue;
+		destroy_entry(*i);
+		i->face = face_from_platform_font(i->key, true);
+		i->preloaded = true;
+	}
+}
+
+gr_face * gr_face_cache::face_from_platform_font(const PMString & path, bool preload)
 {
 	std::string utf8_path;
 	adobe::to_utf8(path.begin(), path.end(), std::back_inserter(utf8_path));
 
-	return gr_make_file_face(utf8_path.c_str(), gr_face_default);
+	return gr_make_file_face(utf8_path.c_str(), preload ? gr_face_preloadAll : gr_face_default);
+}
+
+
+gr_face_cache::sharing::sharing(gr_face_cache & c)
+: _cache(c)
+{
+	mutex::scope lock(_cache._lock);
+	// No other thread has the cache yet, so faces loaded lazily can be 
+	// swapped for preloaded ones.
+	if (_cache._sharers++ == 0)
+		_cache.preload_all();
+}
+
+
+gr_face_cache::sharing::~sharing()
+{
+	mutex::scope lock(_cache._lock);
+	if (--_cache._sharers == 0 && _cache._capacity != 0)
+		_cache.spring_clean(_cache._capacity);
 }
 
 inline
-gr_face_cache::entry::entry(const PMString & k, const value_t f) throw()
+gr_face_cache::entry::entry(const PMString & k, const value_t f, bool p) throw()
 : key(k),
-  face(f)
+  face(f),
+  preloaded(p)
 {}
 
 inline
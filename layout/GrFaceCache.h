@@ -30,6 +30,7 @@ THE SOFTWARE.
 // Library headers
 #include <PMString.h>
 // Module header
+#include "Mutex.h"
 
 // Forward declarations
 // InDesign interfaces
@@ -45,6 +46,11 @@ namespace nrsc
 	recorded counting accesses and an entry's dwell time is reset if it is 
 	accessed and an entry is evicted if it is the oldest and the cache is at 
 	capacity or if it's dwell time is greater than the maximum allowed.
+	Lookups are thread safe. Graphite loads a face's glyphs as they are 
+	first shaped, writing to the face, so while a sharing scope is open 
+	faces are loaded with their glyphs preloaded and shaping with one only 
+	reads from it. Nothing is evicted then, as another thread may still be 
+	shaping with it. Outside sharing faces load lazily, as they always have.
 */
 class gr_face_cache
 {
@@ -79,14 +85,32 @@ public:
 
 	value_t	operator [] (const key_t k);
 
+	/** Shares the cache between threads for the scope's lifetime. The cache 
+		may grow past its capacity meanwhile, it is brought back down when 
+		the last sharing scope closes.
+	*/
+	class sharing
+	{
+	public:
+		explicit sharing(gr_face_cache & c);
+		~sharing();
+
+	private:
+		// Hide copy constructor and assignment operator.
+		sharing(const sharing &);
+		sharing & operator = (const sharing &);
+
+		gr_face_cache & _cache;
+	};
 
 private:
 	struct entry
 	{
 		PMString key;
 		value_t face;
+		bool	preloaded;
 
-		entry(const PMString &, const value_t=0) throw();
+		entry(const PMString &, const value_t=0, bool preloaded=false) throw();
 
 		bool operator == (const entry & rhs) const throw();
 	};
@@ -94,14 +118,18 @@ private:
 	typedef std::list<entry>	store_t;
 
 	void					destroy_entry(const entry & e);
-	void					spring_clean();
+	void					spring_clean(size_t keep);
 	void					freshen(const store_t::iterator & i);
 
-	gr_face *				face_from_platform_font(const PMString &);
+	void					preload_all();
+
+	gr_face *				face_from_platform_font(const PMString &, bool preload);
 	store_t					_faces;
 
 	const size_t			_capacity;
 	const unsigned int		_max_dwell;
+	mutex					_lock;
+	unsigned int			_sharers;
 };
 
 
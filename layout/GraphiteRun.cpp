@@ -34,6 +34,8 @@ THE SOFTWARE.
 #include "graphite2/Font.h"
 #include "graphite2/Segment.h"
 // Module header
+#include "Allocations.h"
+#include "Counters.h"
 #include "GraphiteRun.h"
 
 // Forward declarations
@@ -82,12 +84,6 @@ namespace
 }
 
 
-run * graphite_run::clone_empty() const
-{
-	return new graphite_run();
-}
-
-
 bool graphite_run::layout_span(TextIterator ti, size_t span)
 {
 	if (span ==0)
@@ -101,6 +97,7 @@ bool graphite_run::layout_span(TextIterator ti, size_t span)
 	// Make a segment
 	WideString	chars;
 	ti.AppendToStringAndIncrement(&chars, span);
+	NRSC_ALLOC_NOTE(text, span*sizeof(textchar));
 
 	gr_segment * const seg = gr_make_seg(grfont, _face, 0, nil, gr_utf16, chars.GrabUTF16Buffer(0), span, gr_nobidi + gr_nomirror);
 	if (seg == nil)
@@ -108,6 +105,8 @@ bool graphite_run::layout_span(TextIterator ti, size_t span)
 		gr_font_destroy(grfont);
 		return false;
 	}
+	NRSC_COUNT(shaped_segments);
+	NRSC_COUNT_N(shaped_chars, span);
 
 
 	// Add the glyphs with their natural widths
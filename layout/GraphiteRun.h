@@ -41,6 +41,8 @@ namespace nrsc
 
 class graphite_run : public run
 {
+	friend class run;
+
 	const gr_face * const	_face;
 
 	graphite_run();
@@ -49,8 +51,7 @@ class graphite_run : public run
 	graphite_run(const graphite_run &);
 	graphite_run & operator = (const graphite_run &);
 
-	virtual bool layout_span(TextIterator first, size_t span);
-	virtual run * clone_empty() const;
+	bool layout_span(TextIterator first, size_t span);
 
 public:
 	graphite_run(const gr_face * const, IDrawingStyle * ds);
@@ -59,13 +60,14 @@ public:
 
 inline
 graphite_run::graphite_run()
-: _face(0)
+: run(graphite),
+  _face(0)
 {
 }
 
 inline
 graphite_run::graphite_run(const gr_face * const face, IDrawingStyle * ds)
-: run(ds),
+: run(graphite, ds),
   _face(face)
 {
 }
@@ -0,0 +1,613 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <algorithm>
+#include <cstring>
+#include <string>
+// Interface headers
+#include "VCPlugInHeaders.h"
+// Library headers
+#include <unicode/uchar.h>
+// Module header
+#include "Counters.h"
+#include "Hyphenator.h"
+#include "Trace.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+
+/* The image is a header followed by its sections, each 4 byte aligned and 
+found by its offset from the start of the image, in native byte order. The
+checksum covers everything after the header.
+*/
+struct hyphenator::header
+{
+	struct section
+	{
+		unsigned int	offset,
+						count;
+	};
+
+	char			magic[4];
+	unsigned int	version,
+					byte_order,
+					size,
+					checksum,
+					patterns;
+	section			nodes,
+					labels,
+					values,
+					exceptions,
+					exception_chars,
+					exception_points;
+};
+
+const unsigned int	hyphenator::image_version = 1;
+
+namespace
+{
+	const char			image_magic[4] = { 'G', 'R', 'H', 'Y' };
+	const unsigned int	image_byte_order = 0x01020304;
+
+
+	// 32 bit FNV-1a.
+	unsigned int checksum(const unsigned char * b, const unsigned char * const e)
+	{
+		unsigned int h = 2166136261U;
+		for (; b != e; ++b)
+			h = (h ^ *b) * 16777619U;
+		return h;
+	}
+
+
+	// Append a section of n elements to the image, aligned to 4 bytes.
+	template <typename T>
+	void add_section(std::vector<unsigned char> & image, unsigned int & offset, unsigned int & count, const T * data, size_t n)
+	{
+		image.resize((image.size() + 3) & ~size_t(3));
+		offset = static_cast<unsigned int>(image.size());
+		count = static_cast<unsigned int>(n);
+		if (n)
+			image.insert(image.end(), reinterpret_cast<const unsigned char *>(data), reinterpret_cast<const unsigned char *>(data + n));
+	}
+
+
+	// Whether n elements of T at offset lie inside an image of size bytes.
+	template <typename T>
+	bool in_image(unsigned int offset, unsigned int n, size_t size, size_t first)
+	{
+		return offset % 4 == 0 
+			&& offset >= first && offset <= size 
+			&& n <= (size - offset)/sizeof(T);
+	}
+
+	// A trie node as the patterns are added, before it is packed.
+	struct trie_node
+	{
+		std::map<UTF16TextChar, size_t>	children;
+		std::vector<unsigned char>		values;
+	};
+	typedef std::vector<trie_node>	trie_t;
+
+
+	inline
+	bool is_space(const char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+
+
+	// Decode UTF-8 to UTF-16, code points past the BMP as surrogate pairs.
+	bool utf16(const char * b, const char * const e, hyphenator::word_t & out)
+	{
+		out.clear();
+		while (b != e)
+		{
+			const unsigned char lead = *b++;
+			const int		trail = lead < 0x80 ? 0 : lead < 0xC2 ? -1 : lead < 0xE0 ? 1 : lead < 0xF0 ? 2 : lead < 0xF5 ? 3 : -1;
+			if (trail < 0 || e - b < trail)	return false;
+
+			uint32 c = trail == 0 ? lead : lead & (0x3F >> trail);
+			for (int i = 0; i != trail; ++i)
+			{
+				const unsigned char cont = *b++;
+				if ((cont & 0xC0) != 0x80)	return false;
+				c = c << 6 | (cont & 0x3F);
+			}
+
+			if (c < 0x10000)
+				out.push_back(UTF16TextChar(c));
+			else
+			{
+				out.push_back(UTF16TextChar(0xD7C0 + (c >> 10)));
+				out.push_back(UTF16TextChar(0xDC00 | (c & 0x3FF)));
+			}
+		}
+		return true;
+	}
+
+
+	inline
+	void lower(hyphenator::word_t & w)
+	{
+		for (hyphenator::word_t::iterator c = w.begin(), c_e = w.end(); c != c_e; ++c)
+			*c = UTF16TextChar(u_tolower(*c));
+	}
+
+
+	// Call f on each whitespace separated token from b to e.
+	template <typename F>
+	void for_each_token(const char * b, const char * const e, F & f)
+	{
+		for (;;)
+		{
+			for (; b != e && is_space(*b); ++b);
+			if (b == e)	return;
+
+			const char * const t = b;
+			for (; b != e && !is_space(*b); ++b);
+			f(t, b);
+		}
+	}
+
+
+	// Adds each pattern, such as .hy3ph, to the trie.
+	struct pattern_reader
+	{
+		trie_t				  & trie;
+		size_t					added;
+		hyphenator::word_t		token;
+
+		pattern_reader(trie_t & t) : trie(t), added(0) {}
+
+		void operator () (const char * b, const char * e)
+		{
+			if (!utf16(b, e, token))	return;
+
+			size_t						at = 0;
+			std::vector<unsigned char>	values(1, 0);
+			for (hyphenator::word_t::const_iterator c = token.begin(), c_e = token.end(); c != c_e; ++c)
+			{
+				if (*c >= '0' && *c <= '9')
+				{
+					values.back() = *c - '0';
+					continue;
+				}
+
+				const UTF16TextChar letter = UTF16TextChar(u_tolower(*c));
+				std::map<UTF16TextChar, size_t>::const_iterator const child = trie[at].children.find(letter);
+				if (child == trie[at].children.end())
+				{
+					const size_t next = trie.size();
+					trie[at].children[letter] = next;
+					trie.push_back(trie_node());
+					at = next;
+				}
+				else
+					at = child->second;
+				values.push_back(0);
+			}
+			if (at == 0 || values.size() > 255)	return;
+
+			trie[at].values.swap(values);
+			++added;
+		}
+	};
+
+
+	// Adds each exception, such as ta-ble, with the offsets it breaks after.
+	struct exception_reader
+	{
+		std::map<hyphenator::word_t, hyphenator::points_t>	& words;
+		hyphenator::word_t		token,
+								word;
+
+		exception_reader(std::map<hyphenator::word_t, hyphenator::points_t> & w) : words(w) {}
+
+		void operator () (const char * b, const char * e)
+		{
+			if (!utf16(b, e, token))	return;
+
+			hyphenator::points_t	points;
+			word.clear();
+			for (hyphenator::word_t::const_iterator c = token.begin(), c_e = token.end(); c != c_e; ++c)
+			{
+				if (*c != '-')					word.push_back(*c);
+				else if (!word.empty())			points.push_back(static_cast<unsigned short>(word.size() - 1));
+			}
+			if (word.empty())	return;
+
+			lower(word);
+			words[word].swap(points);
+		}
+	};
+
+
+	// The text of the group opened by command, such as \patterns{, or an
+	// empty range if there is none.
+	void group(const std::string & text, const char * command, const char * & b, const char * & e)
+	{
+		b = e = text.data();
+		const std::string::size_type open = text.find(command);
+		if (open == std::string::npos)	return;
+
+		const std::string::size_type first = open + std::char_traits<char>::length(command),
+									 close = text.find('}', first);
+		b = text.data() + first;
+		e = text.data() + (close == std::string::npos ? text.size() : close);
+	}
+}
+
+
+hyphenator::hyphenator(size_t left_min, size_t right_min, size_t cache_limit)
+: _header(nil),
+  _nodes(nil),
+  _labels(nil),
+  _values(nil),
+  _exceptions(nil),
+  _exception_chars(nil),
+  _exception_points(nil),
+  _left_min(std::max(left_min, size_t(1))),
+  _right_min(std::max(right_min, size_t(1))),
+  _cache_limit(cache_limit)
+{
+}
+
+
+bool hyphenator::load(const char * source, size_t length)
+{
+	NRSC_TRACE_SCOPE("hyphenator::load");
+	clear();
+
+	// Drop the comments.
+	std::string text;
+	text.reserve(length);
+	for (const char * s = source, * const s_e = source + length; s != s_e; ++s)
+	{
+		if (*s != '%')	text += *s;
+		else			for (; s + 1 != s_e && s[1] != '\n'; ++s);
+	}
+
+	trie_t				trie(1);
+	words_t				words;
+	pattern_reader		patterns(trie);
+	exception_reader	exceptions(words);
+	const char		  * b, * e;
+	group(text, "\\patterns{", b, e);
+	if (b == e && text.find("\\hyphenation{") == std::string::npos)
+		for_each_token(text.data(), text.data() + text.size(), patterns);
+	else
+		for_each_token(b, e, patterns);
+	group(text, "\\hyphenation{", b, e);
+	for_each_token(b, e, exceptions);
+
+	if (patterns.added == 0 && words.empty())
+		return false;
+
+	// Pack the trie breadth first, so each node's children are together 
+	// and in label order, and the pattern values into one pool.
+	std::vector<size_t>			order(1, 0);
+	std::vector<node>			nodes;
+	std::vector<UTF16TextChar>	labels(1, 0);
+	std::vector<unsigned char>	values;
+	nodes.reserve(trie.size());
+	labels.reserve(trie.size());
+	for (size_t i = 0; i != order.size(); ++i)
+	{
+		const trie_node & tn = trie[order[i]];
+		const node n = { static_cast<unsigned int>(order.size()), 
+						 static_cast<unsigned int>(values.size()), 
+						 static_cast<unsigned short>(tn.children.size()), 
+						 static_cast<unsigned char>(tn.values.size()),
+						 0 };
+		nodes.push_back(n);
+		values.insert(values.end(), tn.values.begin(), tn.values.end());
+		for (std::map<UTF16TextChar, size_t>::const_iterator c = tn.children.begin(), c_e = tn.children.end(); c != c_e; ++c)
+		{
+			order.push_back(c->second);
+			labels.push_back(c->first);
+		}
+	}
+
+	// Lay the exceptions out in word order, their letters and points pooled.
+	std::vector<exception>		excs;
+	std::vector<UTF16TextChar>	chars;
+	points_t					points;
+	excs.reserve(words.size());
+	for (words_t::const_iterator w = words.begin(), w_e = words.end(); w != w_e; ++w)
+	{
+		const exception x = { static_cast<unsigned int>(chars.size()), 
+							  static_cast<unsigned int>(points.size()), 
+							  static_cast<unsigned short>(w->first.size()), 
+							  static_cast<unsigned short>(w->second.size()) };
+		excs.push_back(x);
+		chars.insert(chars.end(), w->first.begin(), w->first.end());
+		points.insert(points.end(), w->second.begin(), w->second.end());
+	}
+
+	header h;
+	std::memset(&h, 0, sizeof h);
+	std::memcpy(h.magic, image_magic, sizeof h.magic);
+	h.version = image_version;
+	h.byte_order = image_byte_order;
+	h.patterns = static_cast<unsigned int>(patterns.added);
+
+	std::vector<unsigned char>	image(sizeof h);
+	add_section(image, h.nodes.offset, h.nodes.count, &nodes[0], nodes.size());
+	add_section(image, h.labels.offset, h.labels.count, &labels[0], labels.size());
+	add_section(image, h.values.offset, h.values.count, values.empty() ? nil : &values[0], values.size());
+	add_section(image, h.exceptions.offset, h.exceptions.count, excs.empty() ? nil : &excs[0], excs.size());
+	add_section(image, h.exception_chars.offset, h.exception_chars.count, chars.empty() ? nil : &chars[0], chars.size());
+	add_section(image, h.exception_points.offset, h.exception_points.count, points.empty() ? nil : &points[0], points.size());
+	image.resize((image.size() + 3) & ~size_t(3));
+	h.size = static_cast<unsigned int>(image.size());
+	h.checksum = checksum(&image[0] + sizeof h, &image[0] + image.size());
+	std::memcpy(&image[0], &h, sizeof h);
+
+	_owned.resize(image.size()/sizeof(unsigned int));
+	std::memcpy(&_owned[0], &image[0], image.size());
+	use(&_owned[0]);
+	return true;
+}
+
+
+// The image's header, if it is one this build can map, else nil.
+const hyphenator::header * hyphenator::check_header(const void * const image, size_t size)
+{
+	if (!image || reinterpret_cast<size_t>(image) % 4 != 0 || size < sizeof(header))
+		return nil;
+
+	const header & h = *static_cast<const header *>(image);
+	const size_t first = sizeof h;
+	if (std::memcmp(h.magic, image_magic, sizeof h.magic) != 0
+		|| h.version != image_version
+		|| h.byte_order != image_byte_order
+		|| h.size != size
+		|| !in_image<node>(h.nodes.offset, h.nodes.count, size, first)
+		|| !in_image<UTF16TextChar>(h.labels.offset, h.labels.count, size, first)
+		|| !in_image<unsigned char>(h.values.offset, h.values.count, size, first)
+		|| !in_image<exception>(h.exceptions.offset, h.exceptions.count, size, first)
+		|| !in_image<UTF16TextChar>(h.exception_chars.offset, h.exception_chars.count, size, first)
+		|| !in_image<unsigned short>(h.exception_points.offset, h.exception_points.count, size, first)
+		|| h.nodes.count == 0 || h.labels.count != h.nodes.count)
+		return nil;
+
+	return &h;
+}
+
+
+bool hyphenator::map(const void * const image, size_t size)
+{
+	NRSC_TRACE_SCOPE("hyphenator::map");
+	clear();
+
+	if (!check_header(image, size))
+		return false;
+
+	use(image);
+	return true;
+}
+
+
+bool hyphenator::verify(const void * const image, size_t size)
+{
+	NRSC_TRACE_SCOPE("hyphenator::verify");
+	const header * const h = check_header(image, size);
+	const unsigned char * const bytes = static_cast<const unsigned char *>(image);
+	if (!h || h->checksum != checksum(bytes + sizeof *h, bytes + size))
+		return false;
+
+	// Every child and value run must stay inside its section, as must every
+	// exception's letters and points.
+	const node * const nodes = reinterpret_cast<const node *>(bytes + h->nodes.offset);
+	for (unsigned int i = 0; i != h->nodes.count; ++i)
+		if (nodes[i].first_child > h->nodes.count || nodes[i].n_children > h->nodes.count - nodes[i].first_child
+			|| nodes[i].values > h->values.count || nodes[i].n_values > h->values.count - nodes[i].values)
+			return false;
+	const exception * const excs = reinterpret_cast<const exception *>(bytes + h->exceptions.offset);
+	for (unsigned int i = 0; i != h->exceptions.count; ++i)
+		if (excs[i].chars > h->exception_chars.count || excs[i].length > h->exception_chars.count - excs[i].chars
+			|| excs[i].points > h->exception_points.count || excs[i].n_points > h->exception_points.count - excs[i].points)
+			return false;
+
+	return true;
+}
+
+
+bool hyphenator::is_image(const void * const data, size_t size)
+{
+	return size >= sizeof image_magic && std::memcmp(data, image_magic, sizeof image_magic) == 0;
+}
+
+
+void hyphenator::clear()
+{
+	_header = nil;
+	_nodes = nil;
+	_labels = nil;
+	_values = nil;
+	_exceptions = nil;
+	_exception_chars = nil;
+	_exception_points = nil;
+	std::vector<unsigned int>().swap(_owned);
+	clear_cache();
+}
+
+
+void hyphenator::use(const void * const image)
+{
+	const unsigned char * const bytes = static_cast<const unsigned char *>(image);
+	_header = static_cast<const header *>(image);
+	_nodes = reinterpret_cast<const node *>(bytes + _header->nodes.offset);
+	_labels = reinterpret_cast<const UTF16TextChar *>(bytes + _header->labels.offset);
+	_values = bytes + _header->values.offset;
+	_exceptions = reinterpret_cast<const exception *>(bytes + _header->exceptions.offset);
+	_exception_chars = reinterpret_cast<const UTF16TextChar *>(bytes + _header->exception_chars.offset);
+	_exception_points = reinterpret_cast<const unsigned short *>(bytes + _header->exception_points.offset);
+}
+
+
+size_t hyphenator::image_size() const
+{
+	return _header ? _header->size : 0;
+}
+
+
+size_t hyphenator::patterns() const
+{
+	return _header ? _header->patterns : 0;
+}
+
+
+size_t hyphenator::exceptions() const
+{
+	return _header ? _header->exceptions.count : 0;
+}
+
+
+size_t hyphenator::nodes() const
+{
+	return _header ? _header->nodes.count : 0;
+}
+
+
+size_t hyphenator::cached() const
+{
+	mutex::scope lock(_lock);
+	return _cache.size();
+}
+
+
+void hyphenator::clear_cache()
+{
+	mutex::scope lock(_lock);
+	_cache.clear();
+}
+
+
+bool hyphenator::word_char(UTF32TextChar c)
+{
+	const UChar32 u = c.GetValue();
+	return u_isalpha(u) || (U_GET_GC_MASK(u) & U_GC_M_MASK) != 0;
+}
+
+
+/* Liang's algorithm: every pattern matching anywhere in the word, with a 
+dot at either end, sets the values between its letters, the highest value
+wins, and odd values mark where the word may break.
+*/
+void hyphenator::match(const word_t & word, points_t & points) const
+{
+	const size_t	n = word.size(),
+					m = n + 2;
+	word_t			dotted;
+	dotted.reserve(m);
+	dotted.push_back('.');
+	dotted.insert(dotted.end(), word.begin(), word.end());
+	dotted.push_back('.');
+
+	std::vector<unsigned char> values(m + 1, 0);
+	for (size_t i = 0; i != m; ++i)
+	{
+		size_t at = 0;
+		for (size_t j = i; j != m; ++j)
+		{
+			const node & parent = _nodes[at];
+			const UTF16TextChar	  * const first = _labels + parent.first_child,
+								  * const last = first + parent.n_children,
+								  * const child = std::lower_bound(first, last, dotted[j]);
+			if (child == last || *child != dotted[j])	break;
+
+			at = child - _labels;
+			const node & nd = _nodes[at];
+			const size_t n_values = std::min(size_t(nd.n_values), values.size() - i);
+			for (size_t k = 0; k != n_values; ++k)
+				values[i + k] = std::max(values[i + k], _values[nd.values + k]);
+		}
+	}
+
+	// Break after word[o] where the value before dotted[o+2] is odd.
+	points.clear();
+	for (size_t o = _left_min - 1; o + _right_min < n; ++o)
+		if (values[o + 2] & 1)	points.push_back(static_cast<unsigned short>(o));
+}
+
+
+const hyphenator::exception * hyphenator::find_exception(const word_t & word) const
+{
+	size_t lo = 0, hi = _header->exceptions.count;
+	while (lo != hi)
+	{
+		const size_t		mid = (lo + hi)/2;
+		const exception   & x = _exceptions[mid];
+		const UTF16TextChar * const chars = _exception_chars + x.chars;
+		if (std::lexicographical_compare(chars, chars + x.length, word.begin(), word.end()))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == _header->exceptions.count)	return nil;
+
+	const exception & x = _exceptions[lo];
+	return x.length == word.size() && std::equal(word.begin(), word.end(), _exception_chars + x.chars) ? &x : nil;
+}
+
+
+void hyphenator::hyphenate(const UTF16TextChar * const word, size_t n, points_t & points) const
+{
+	points.clear();
+	if (n < _left_min + _right_min || n > 0xFFFF || !_header)	return;
+	NRSC_COUNT(hyphen_lookups);
+
+	word_t w(word, word + n);
+	lower(w);
+	{
+		mutex::scope lock(_lock);
+		words_t::const_iterator const c = _cache.find(w);
+		if (c != _cache.end())
+		{
+			NRSC_COUNT(hyphen_cache_hits);
+			points = c->second;
+			return;
+		}
+	}
+
+	const exception * const x = find_exception(w);
+	if (!x)
+		match(w, points);
+	else
+	{
+		for (const unsigned short * o = _exception_points + x->points, * const o_e = o + x->n_points; o != o_e; ++o)
+			if (size_t(*o) + 1 >= _left_min && size_t(*o) + _right_min < n)	points.push_back(*o);
+	}
+
+	mutex::scope lock(_lock);
+	if (_cache_limit && _cache.size() >= _cache_limit)
+		_cache.clear();
+	_cache.insert(std::make_pair(w, points));
+}
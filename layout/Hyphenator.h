@@ -0,0 +1,175 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#pragma once
+
+// Language headers
+#include <map>
+#include <vector>
+// Interface headers
+// Library headers
+// Module header
+#include "Mutex.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+
+namespace nrsc 
+{
+// Project forward declarations
+
+/* hyphenator class
+Finds the hyphenation points of words with Liang's algorithm from a set of 
+TeX hyphenation patterns for one language, as loaded from a pattern file. 
+The patterns are built into a trie and then packed breadth first into flat 
+arrays, so a lookup walks from a node to a run of sorted sibling labels 
+without chasing a pointer per letter. Words are memoized, as running text 
+asks for the same few thousand words over and over; lookups are thread 
+safe.
+
+The packed trie and the sorted exceptions live in one versioned image of 
+offsets rather than pointers. Loading pattern source compiles an image the 
+hyphenator owns, which can be saved, and map uses a saved image in place, 
+so a host can memory map a dictionary compiled offline, read-only, and 
+share it between every document using the language without parsing or 
+copying it.
+*/
+class hyphenator
+{
+public:
+	typedef std::vector<UTF16TextChar>	word_t;
+	typedef std::vector<unsigned short>	points_t;	// Offsets a word may break after.
+
+	/** Create a hyphenator with no patterns.
+		@param left_min IN Fewest characters left before a hyphen.
+		@param right_min IN Fewest characters carried over after one.
+		@param cache_limit IN Words memoized before the cache is emptied, 
+			0 for no limit.
+	*/
+	hyphenator(size_t left_min = 2, size_t right_min = 3, size_t cache_limit = 65536);
+
+	/** Replace the patterns and exceptions with those in UTF-8 TeX source: 
+		the contents of \patterns{} and \hyphenation{}, or if there is 
+		neither, the whole text taken as patterns. % comments are skipped.
+		@return false, leaving no patterns, if none could be read.
+	*/
+	bool	load(const char * source, size_t length);
+
+	/** Use a compiled image, as saved from image(), in place. Only its 
+		header is checked, for the right version, byte order and size and 
+		that each section lies inside the image, so mapping costs the same
+		whatever the size of the dictionary. What the sections hold is 
+		trusted, so the image must have passed verify, as grind-patterns 
+		checks the images it writes. It must outlive its use here.
+		@param image IN The image, 4 byte aligned, as from a memory map.
+		@return false, leaving no patterns, if the header is not valid.
+	*/
+	bool	map(const void * image, size_t size);
+
+	/** Whether an image is valid throughout: its header as map checks it, 
+		its checksum, and every offset in it staying inside it. This reads 
+		the whole image, so check it once when it is compiled or installed
+		rather than each time it is mapped.
+	*/
+	static bool	verify(const void * image, size_t size);
+
+	// The image in use, to save for map.
+	const void *	image() const;
+	size_t			image_size() const;
+
+	// Whether data starts as an image does, valid or not.
+	static bool	is_image(const void * data, size_t size);
+
+	static const unsigned int	image_version;
+
+	// Capacity
+	size_t	patterns() const;
+	size_t	exceptions() const;
+	size_t	nodes() const;
+	size_t	cached() const;
+
+	/** Put in points the offsets into word, of n characters, after which it
+		may be hyphenated.
+	*/
+	void	hyphenate(const UTF16TextChar * word, size_t n, points_t & points) const;
+	void	clear_cache();
+
+	// Whether c belongs in a word for hyphenating.
+	static bool	word_char(UTF32TextChar c);
+
+private:
+	// Hide copy constructor and assignment operator.
+	hyphenator(const hyphenator &);
+	hyphenator & operator = (const hyphenator &);
+
+	struct header;
+	struct node
+	{
+		unsigned int	first_child,
+						values;			// Offset into _values.
+		unsigned short	n_children;
+		unsigned char	n_values,		// 0 if no pattern ends here.
+						reserved;
+	};
+	struct exception
+	{
+		unsigned int	chars,			// Offset into _exception_chars.
+						points;			// Offset into _exception_points.
+		unsigned short	length,
+						n_points;
+	};
+
+	typedef std::map<word_t, points_t>	words_t;
+
+	static const header *	check_header(const void * image, size_t size);
+
+	void				clear();
+	void				use(const void * image);
+	void				match(const word_t & word, points_t & points) const;
+	const exception *	find_exception(const word_t & word) const;
+
+	std::vector<unsigned int>	_owned;			// The image, when compiled here.
+	const header			  * _header;
+	const node				  * _nodes;
+	const UTF16TextChar		  * _labels;		// Each node's letter, siblings sorted.
+	const unsigned char		  * _values;
+	const exception			  * _exceptions;	// Sorted by word.
+	const UTF16TextChar		  * _exception_chars;
+	const unsigned short	  * _exception_points;
+
+	const size_t				_left_min,
+								_right_min,
+								_cache_limit;
+	mutable words_t				_cache;
+	mutable mutex				_lock;
+};
+
+
+inline
+const void * hyphenator::image() const
+{
+	return _header;
+}
+
+} // end of namespace nrsc
\ No newline at end of file
@@ -44,12 +44,6 @@ THE SOFTWARE.
 using namespace nrsc;
 
 
-run * inline_object::clone_empty() const
-{
-	return new inline_object();
-}
-
-
 bool inline_object::layout_span(TextIterator ti, size_t span)
 {
 	InterfacePtr<const ITextModel> model(ti.QueryTextModel());
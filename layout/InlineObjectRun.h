@@ -40,6 +40,8 @@ namespace nrsc
 
 class inline_object : public run
 {
+	friend class run;
+
 	UIDRef	_inline_UID_ref;
 
 	inline_object();
@@ -48,9 +50,8 @@ class inline_object : public run
 	inline_object(const inline_object &);
 	inline_object & operator = (const inline_object &);
 
-	virtual bool  layout_span(TextIterator first, size_t span);
-	virtual bool  render_run(IWaxRun & run) const;
-	virtual run * clone_empty() const;
+	bool  layout_span(TextIterator first, size_t span);
+	bool  render_run(IWaxRun & run) const;
 
 public:
 	inline_object(IDrawingStyle * ds);
@@ -59,13 +60,14 @@ public:
 
 inline
 inline_object::inline_object()
-: _inline_UID_ref(nil, kInvalidUID)
+: run(object),
+  _inline_UID_ref(nil, kInvalidUID)
 {
 }
 
 inline
 inline_object::inline_object(IDrawingStyle * ds)
-: run(ds),
+: run(object, ds),
   _inline_UID_ref(nil, kInvalidUID)
 {
 }
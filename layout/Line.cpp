@@ -23,11 +23,13 @@ THE SOFTWARE.
 */
 
 // Language headers
+#include <algorithm>
+#include <limits>
 // Interface headers
 #include "VCPlugInHeaders.h"
 #include <IComposeScanner.h>
 #include <ICompositionStyle.h>
-//#include <IDrawingStyle.h>
+#include <IDrawingStyle.h>
 //#include <IFontInstance.h>
 //#include <IHierarchy.h>
 #include <IJustificationStyle.h>
@@ -43,10 +45,17 @@ THE SOFTWARE.
 //#include "GraphiteRun.h"
 //#include "GrFaceCache.h"
 //#include "InlineObjectRun.h"
+#include "Allocations.h"
+#include "Counters.h"
+#include "Fingerprint.h"
+#include "GlyphBatch.h"
 #include "Line.h"
+#include "Recorder.h"
 #include "Run.h"
+#include "StyleRuns.h"
 #include "Tile.h"
 #include "Tiler.h"
+#include "Trace.h"
 
 // Forward declarations
 // InDesign interfaces
@@ -54,6 +63,156 @@ THE SOFTWARE.
 // Project forward declarations
 using namespace nrsc;
 
+namespace
+{
+	void stage_attempt(staged_line & stage, const line_metrics & lm, const line & ln)
+	{
+		stage.attempts.push_back(staged_line::attempt());
+		staged_line::attempt & a = stage.attempts.back();
+		a.metrics = lm;
+		a.retried = false;
+		for (line::const_iterator t = ln.begin(), t_e = ln.end(); t != t_e; ++t)
+		{
+			a.edges.push_back(t->position().X());
+			a.edges.push_back(t->position().X() + t->dimensions().X());
+		}
+	}
+
+
+	bool same_edges(const line & ln, const std::vector<PMReal> & edges)
+	{
+		if (ln.size()*2 != edges.size())	return false;
+
+		std::vector<PMReal>::const_iterator e = edges.begin();
+		for (line::const_iterator t = ln.begin(), t_e = ln.end(); t != t_e; ++t)
+		{
+			if (*e++ != t->position().X())							return false;
+			if (*e++ != t->position().X() + t->dimensions().X())	return false;
+		}
+		return true;
+	}
+
+
+	// Whether an alignment leaves a rag to balance.
+	bool ragged(ICompositionStyle::TextAlignment alignment)
+	{
+		switch (alignment)
+		{
+		case ICompositionStyle::kTextAlignJustifyLeft:
+		case ICompositionStyle::kTextAlignJustifyCenter:
+		case ICompositionStyle::kTextAlignJustifyRight:
+		case ICompositionStyle::kTextAlignJustifyFull:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+
+	size_t const	never_fits = std::numeric_limits<size_t>::max();
+
+	/* The lines breaking copies of t's runs takes, each shrink narrower than 
+	its tile, t's for the first and one from later_left for the rest. Counts 
+	no further than limit.
+	*/
+	size_t count_lines(const tile & t, const PMReal & later_left, const PMReal & shrink, 
+					   cluster::penalty::type const max_penalty, size_t const limit)
+	{
+		PMReal const	right = t.position().X() + t.dimensions().X();
+		tile			pending;
+		for (tile::const_iterator r = t.begin(), r_e = t.end(); r != r_e; ++r)
+			pending.push_back((*r)->copy());
+
+		size_t n = 0;
+		for (PMReal left = t.position().X(); !pending.empty(); left = later_left)
+		{
+			if (++n > limit)	return n;
+
+			tile l(PMRect(left, 0, right, 0));
+			l.take_runs(pending);
+			l.apply_tab_widths();
+			l.break_into(pending, max_penalty, right - left - shrink);
+			if (l.span() == 0)	return never_fits;
+		}
+		return n;
+	}
+
+
+	/* How much narrower than its tile to break t, which holds the rest of 
+	the paragraph, for that to take no more lines than it does at full width. 
+	Bisects for the most that fits, to within a point or the trials allowed. 
+	No line of n can be narrower than the text's width over n, which bounds 
+	the search.
+	*/
+	PMReal balance_shrink(const tile & t, const PMReal & later_left, 
+						  cluster::penalty::type const max_penalty, int trials)
+	{
+		PMReal const	width = t.dimensions().X(),
+						text = t.content_dimensions().X();
+		if (text <= width)	return 0;
+
+		size_t const	n = count_lines(t, later_left, 0, max_penalty, never_fits);
+		if (n < 2 || n == never_fits)	return 0;
+
+		PMReal	fits = 0,
+				too_far = std::min(width - text/n, t.position().X() + width - later_left) + 1;
+		while (trials-- > 0 && too_far - fits > 1)
+		{
+			PMReal const shrink = (fits + too_far)/2;
+			if (count_lines(t, later_left, shrink, max_penalty, n) <= n)	fits = shrink;
+			else															too_far = shrink;
+		}
+		return fits;
+	}
+
+
+	PMReal line_width(const line & ln)
+	{
+		PMReal w = 0;
+		for (line::const_iterator t = ln.begin(), t_e = ln.end(); t != t_e; ++t)
+			w += t->dimensions().X();
+		return w;
+	}
+
+
+	/* Fingerprint a line as composed with what rebuilding it depends on: 
+	its tiles, the paragraph style, each run's style and shaped glyphs, and 
+	whether each tile ends with a hyphen, which hangs on the text after it.
+	*/
+	void fingerprint_line(const line & ln, const IWaxLine & wl, IComposeScanner & scanner, TextIndex ti, 
+						  bool first_line, const hyphenator * hyphens, fingerprint & fp)
+	{
+		fp.add_composed_line(first_line, wl);
+		fp.add_style(scanner.GetParagraphStyleAt(ti));
+		for (line::const_iterator t = ln.begin(), t_e = ln.end(); t != t_e; ++t)
+		{
+			PMReal x = 0;
+			for (tile::const_iterator r = t->begin(), r_e = t->end(); r != r_e; ++r)
+			{
+				fp.add_style((*r)->get_style());
+				fp.add_composed_run(**r, x);
+				x += (*r)->width();
+			}
+			fp.add_break(hyphens && t->ends_at_hyphen());
+		}
+	}
+
+
+	// As line::fill_wax_line, from the tiles of a staged line.
+	void fill_wax_line(IWaxLine & wl, const std::vector<staged_line::tile_span> & tiles)
+	{
+		wl.SetNumberOfTiles(tiles.size());
+		if (tiles.size() > 1)	wl.SetNoShuffle(kTrue);
+
+		for (int tile_num = 0, n = tiles.size(); tile_num != n; ++tile_num)
+		{
+			wl.SetTextSpanInTile(tiles[tile_num].span, tile_num); 
+			wl.SetXPosition(tiles[tile_num].x, tile_num);
+			wl.SetTargetWidth(tiles[tile_num].width, tile_num);
+		}
+	}
+}
+
 
 void line::update_line_metrics(line_metrics & lm)
 {
@@ -88,50 +247,125 @@ void line::fill_wax_line(IWaxLine & wl) const
 
 
 
-IWaxLine * nrsc::compose_line(tiler & tile_manager, gr_face_cache & faces, IParagraphComposer::RecomposeHelper & helper, const TextIndex ti)
+bool nrsc::fill_window(tile & t, const style_runs & styles, gr_face_cache & faces, TextIndex ti, TextIndex & filled, 
+					   TextIndex end, const PMReal & line_width, const PMReal & em)
 {
+	PMReal const	wanted = 2*line_width;
+	TextIndex		window = em > 0 ? TextIndex(ToDouble(4*wanted/em)) + 1 : end - ti;
+
+	for (; filled < end && (filled == ti || t.content_dimensions().X() < wanted); window = std::min(2*window, end - ti))
+	{
+		TextIndex const cut = styles.segment_end(std::min(filled + window, end), end);
+		if (!t.fill_by_span(styles, faces, filled, cut - filled))
+			return false;
+		filled = cut;
+	}
+	return true;
+}
+
+
+IWaxLine * nrsc::compose_line(tiler & tile_manager, gr_face_cache & faces, IParagraphComposer::RecomposeHelper & helper, const TextIndex ti, 
+								staged_line * stage, shaped_source * shaped, const balance_limits * balance,
+								const hyphenator * hyphens, fingerprint * fp)
+{
+	NRSC_TRACE_SCOPE("compose_line");
+	NRSC_ALLOC_PHASE(compose);
 	IComposeScanner	* scanner = helper.GetComposeScanner();
 	line_metrics	lm(scanner->GetCompleteStyleAt(ti));
 	line			ln;
 	bool const		first_line = helper.GetParagraphStart() == ti;
+	style_runs		styles;
+	InterfacePtr<ICompositionStyle>	cs(scanner->GetParagraphStyleAt(ti), UseDefaultIID());
+	bool const		balanced = balance 
+							   && helper.GetParagraphEnd() - helper.GetParagraphStart() <= balance->max_chars
+							   && ragged(cs->GetParagraphAlignment());
+
+	// Index the style runs once, every retry refills from the same text.
+	if (!styles.build(*scanner, ti, helper.GetParagraphEnd()))
+		return nil;
+
+	if (stage)
+	{
+		stage->start = ti;
+		stage->attempts.clear();
+		stage->tiles.clear();
+	}
 
+	bool retry;
 	do
 	{
 		// Get tiles for the line.
 		if (!tile_manager.next_line(ti, lm, ln))
+		{
+			if (stage)	stage->attempts.clear();
 			break;
+		}
+		if (stage)	stage_attempt(*stage, lm, ln);
 
-		// Create the first tile and fill with the entire paragraph (this will almost always be overset)
+		// Create the first tile and fill it with enough of the paragraph to 
+		// be overset, or all of it to balance.
 		line::iterator t = ln.begin();
-		if (!t->fill_by_span(*scanner, faces, ti, helper.GetParagraphEnd()-ti))
+		bool const balancing = balanced && ln.size() == 1 && tile_manager.drop_lines() <= 1 && tile_manager.drop_indent() == 0;
+		TextIndex filled = ti;
+		if (first_line && shaped && (filled = shaped->take(ti, helper.GetParagraphEnd(), *t)) != ti)
+			NRSC_COUNT(shaped_ahead);
+		if (balancing 
+			? filled < helper.GetParagraphEnd() && !t->fill_by_span(styles, faces, filled, helper.GetParagraphEnd()-filled) 
+			: !fill_window(*t, styles, faces, ti, filled, helper.GetParagraphEnd(), line_width(ln), lm.em_box_height))
 			return nil;
 
 		// Handle drop caps.
+		TextIndex broken = ti;
 		if (first_line && tile_manager.drop_lines() > 1)
 		{
 			tile & drop_tile = *t;
 			PMReal scale = (lm.ascent+(tile_manager.drop_lines()-1)*lm.leading)/lm.ascent;
 			drop_tile.break_drop_caps(scale, tile_manager.drop_clusters(), *++t);
+			broken += drop_tile.span();
 		}
 
+		// Mark hyphen breaks in the text left to break, as rebuild_line 
+		// does, which never sets a hyphen after a drop cap.
+		if (hyphens)
+			t->hyphenate(*hyphens, scanner->QueryDataAt(broken, nil, nil));
+
 		// Flow text into any remaining tiles, (not the common case)
 		// Push the runoff tile onto the end of the line to collect 
 		//  any overset text.
 		cluster::penalty::type const max_penalty = ln.size() > 1 || tile_manager.drop_indent() > 0 
 													? cluster::penalty::intra 
 													: cluster::penalty::letter;
+		PMReal const shrink = balancing 
+							  ? balance_shrink(*t, t->position().X() - (first_line ? cs->IndentLeftFirst() : 0), 
+											   max_penalty, balance->max_trials) 
+							  : 0;
 		ln.push_back(tile());
 		for (line::iterator t_e = --ln.end(); t != t_e && !t->empty();)
 		{
 			tile & last = *t;
 			last.apply_tab_widths();
-			last.break_into(*++t, max_penalty);
+			last.break_into(*++t, max_penalty, last.dimensions().X() - shrink);
 		}
 		ln.pop_back();
 
 		// Check tile depths
 		ln.update_line_metrics(lm);
-	} while (tile_manager.need_retry_line(lm) || ln.span() == 0);
+		retry = tile_manager.need_retry_line(lm);
+		if (stage)	stage->attempts.back().retried = retry;
+	} while (retry || ln.span() == 0);
+
+	if (stage)
+	{
+		stage->span = ln.span();
+		stage->metrics = lm;
+		stage->drop_indent = tile_manager.drop_indent();
+		stage->drop_lines = tile_manager.drop_lines();
+		for (line::const_iterator t = ln.begin(), t_e = ln.end(); t != t_e; ++t)
+		{
+			const staged_line::tile_span ts = { TextIndex(t->span()), t->position().X(), t->dimensions().X() };
+			stage->tiles.push_back(ts);
+		}
+	}
 
 
 	IWaxLine* wl = helper.QueryNewWaxLine();
@@ -147,13 +381,78 @@ IWaxLine * nrsc::compose_line(tiler & tile_manager, gr_face_cache & faces, IPara
 	ln.fill_wax_line(*wl);
 	tile_manager.setup_wax_line(wl, lm);
 
+	if (fp || stage)
+	{
+		fingerprint line_fp;
+		fingerprint_line(ln, *wl, *scanner, ti, first_line, hyphens, line_fp);
+		if (stage)	stage->composed = line_fp;
+		if (fp)		*fp = line_fp;
+	}
+
 	helper.ApplyComposedLine(wl, ln.span());
+	NRSC_RECORD(composed_line(ti, *wl));
+	NRSC_COUNT(lines_composed);
+	NRSC_COUNTERS_TICK();
+	return wl;
+}
+
+
+IWaxLine * nrsc::apply_staged_line(tiler & tile_manager, IParagraphComposer::RecomposeHelper & helper, const staged_line & stage)
+{
+	NRSC_TRACE_SCOPE("apply_staged_line");
+	NRSC_ALLOC_PHASE(compose);
+	if (stage.attempts.empty() || stage.tiles.empty())
+		return nil;
+
+	// Ask for tiles exactly as compose_line did. Getting the same ones back 
+	// every time means filling and breaking them would give the same line.
+	line	ln;
+	bool	same = true;
+	for (size_t a = 0, n = stage.attempts.size(); same && a != n; ++a)
+	{
+		const staged_line::attempt & at = stage.attempts[a];
+		const line_metrics & filled = a + 1 < n ? stage.attempts[a + 1].metrics : stage.metrics;
+		same = tile_manager.next_line(stage.start, at.metrics, ln) 
+			&& same_edges(ln, at.edges)
+			&& tile_manager.need_retry_line(filled) == at.retried;
+	}
+	if (!same
+		|| tile_manager.drop_indent() != stage.drop_indent 
+		|| tile_manager.drop_lines() != stage.drop_lines)
+	{
+		tile_manager.restart_line();
+		NRSC_COUNT(staged_misses);
+		return nil;
+	}
+
+	IWaxLine* wl = helper.QueryNewWaxLine();
+	if (wl == nil)		return nil;
+
+	if (tile_manager.drop_lines() > 1)
+	{
+		bool const	 first_line = helper.GetParagraphStart() == stage.start;
+		PMReal const indent = first_line ? stage.tiles.front().width : tile_manager.drop_indent();
+		int32  const n_lines = tile_manager.drop_lines();
+		wl->SetDropCapIndents(1, &indent, &n_lines);
+	}
+
+	line_metrics lm = stage.metrics;
+	fill_wax_line(*wl, stage.tiles);
+	tile_manager.setup_wax_line(wl, lm);
+
+	helper.ApplyComposedLine(wl, stage.span);
+	NRSC_RECORD(composed_line(stage.start, *wl));
+	NRSC_COUNT(lines_staged);
+	NRSC_COUNTERS_TICK();
 	return wl;
 }
 
 
-bool nrsc::rebuild_line(gr_face_cache & faces, const IParagraphComposer::RebuildHelper & helper)
+bool nrsc::rebuild_line(gr_face_cache & faces, const IParagraphComposer::RebuildHelper & helper, fingerprint * fp,
+						const hyphenator * hyphens, glyph_batch * batch)
 {
+	NRSC_TRACE_SCOPE("rebuild_line");
+	NRSC_ALLOC_PHASE(rebuild);
 	TextIndex	      ti = helper.GetTextIndex();
 	IWaxLine const 	* wl = helper.GetWaxLine();
 	IComposeScanner * scanner = helper.GetComposeScanner();
@@ -163,6 +462,15 @@ bool nrsc::rebuild_line(gr_face_cache & faces, const IParagraphComposer::Rebuild
 	InterfacePtr<ICompositionStyle>		cs(para_style, UseDefaultIID());
 	InterfacePtr<IJustificationStyle>	js(para_style, UseDefaultIID());
 	bool			  has_drop_cap = ti == helper.GetParagraphStart() && wl->GetDropCapIndents() == 1;
+	NRSC_RECORD(rebuild(helper));
+
+	// Index the style runs for the whole line once.
+	style_runs	styles;
+	TextIndex	line_span = 0;
+	for (int i=0, n_tiles = wl->GetNumberOfTiles(); i != n_tiles; ++i)
+		line_span += wl->GetTextSpanInTile(i);
+	if (!styles.build(*scanner, ti, ti + line_span))
+		return false;
 
 	// Rebuild the and refill tile list from the wax line.
 	line	ln;
@@ -172,10 +480,16 @@ bool nrsc::rebuild_line(gr_face_cache & faces, const IParagraphComposer::Rebuild
 	{
 		ln.push_back(tile(PMRect(wl->GetXPosition(i), y_top, wl->GetXPosition(i) + wl->GetTargetWidth(i), y_bottom)));
 		tile & t = ln.back();
-		t.fill_by_span(*scanner, faces, ti, wl->GetTextSpanInTile(i));
+		t.fill_by_span(styles, faces, ti, wl->GetTextSpanInTile(i));
 
 		tile_span = t.span();
 		if (tile_span != wl->GetTextSpanInTile(i)) return false;
+
+		if (hyphens && !(i == 0 && has_drop_cap))
+		{
+			t.hyphenate(*hyphens, scanner->QueryDataAt(ti, nil, nil));
+			if (t.ends_at_hyphen())	t.back()->add_hyphen();
+		}
 	}
 
 	for (line::iterator t = has_drop_cap ? ++ln.begin() : ln.begin(), t_e = ln.end(); t != t_e; ++t)
@@ -188,6 +502,11 @@ bool nrsc::rebuild_line(gr_face_cache & faces, const IParagraphComposer::Rebuild
 	if (wc->GetWaxLine() == nil)
 		wc->SetWaxLine(wl);
 
+	fingerprint line_fp;
+	if (fp)	line_fp.add_line(helper.GetTextIndex() - helper.GetParagraphStart(), *wl);
+
+	glyph_batch	line_batch;
+	if (!batch)	batch = &line_batch;
 	line::iterator t = ln.begin();
 	// Handle drop capse
 	if (has_drop_cap)
@@ -202,13 +521,16 @@ bool nrsc::rebuild_line(gr_face_cache & faces, const IParagraphComposer::Rebuild
 		for (tile::iterator r = t->begin(), r_e = t->end(); r != r_e; ++r)
 		{
 			(*r)->scale(scale);
-			IWaxRun * wr = (*r)->wax_run();
+			IWaxRun * wr = (*r)->wax_run(*batch);
 			if (wr == nil)
 				return false;
 			wr->SetXPosition(x);
 			wr->SetYPosition(wr->GetYPosition() + (drop_lines-1)*lm.leading);
 			x += (*r)->width();
+			if (fp)	line_fp.add_run(**r, wr->GetXPosition(), wr->GetYPosition());
 			wc->AddRun(wr);
+			NRSC_RECORD(wax_run(*wr, (*r)->width(), (*r)->span()));
+			NRSC_COUNT(wax_runs);
 		}
 
 		++t;
@@ -221,15 +543,21 @@ bool nrsc::rebuild_line(gr_face_cache & faces, const IParagraphComposer::Rebuild
 
 		for (tile::iterator r = t->begin(), r_e = t->end(); r != r_e; ++r)
 		{
-			IWaxRun * wr = (*r)->wax_run();
+			IWaxRun * wr = (*r)->wax_run(*batch);
 			if (wr == nil)
 				return false;
 			wr->SetXPosition(x);
 			x += (*r)->width();
+			if (fp)	line_fp.add_run(**r, wr->GetXPosition(), wr->GetYPosition());
 			wc->AddRun(wr);
+			NRSC_RECORD(wax_run(*wr, (*r)->width(), (*r)->span()));
+			NRSC_COUNT(wax_runs);
 		}
 	}
 	wc->ConstructionComplete();
+	NRSC_COUNT(lines_rebuilt);
+	if (fp)	fp->add(line_fp);
+	NRSC_RECORD(rebuilt());
 
 	return true;
 }
@@ -25,11 +25,16 @@ THE SOFTWARE.
 #pragma once
 
 // Language headers
+#include <list>
+#include <vector>
 // Interface headers
 #include <IParagraphComposer.h>
 // Library headers
 // Module header
+#include "Allocations.h"
+#include "Fingerprint.h"
 #include "Tile.h"
+#include "Tiler.h"
 
 // Forward declarations
 // InDesign interfaces
@@ -39,13 +44,14 @@ class IWaxLine;
 namespace nrsc 
 {
 // Project forward declarations
+class glyph_batch;
 class gr_face_cache;
-struct line_metrics;
-class tiler;
+class hyphenator;
+class style_runs;
 
-class line : private std::list<tile>
+class line : private std::list<tile, allocations::allocator<tile, allocations::tiles>::type>
 {
-	typedef std::list<tile>	base_t;
+	typedef std::list<tile, allocations::allocator<tile, allocations::tiles>::type>	base_t;
 	size_t	_span;
 public:
 	line();
@@ -82,9 +88,119 @@ public:
 };
 
 
+/** A line composed away from the host, with enough recorded to put the 
+	same line on the host later without shaping or breaking it again: the 
+	line metrics each attempt at the line asked the tiler for tiles with, 
+	the tile edges it got back and whether the attempt was retried for its 
+	depth, then the finished line's tiles and metrics and the drop cap 
+	state it was composed under.
+*/
+struct staged_line
+{
+	struct attempt
+	{
+		line_metrics		metrics;
+		std::vector<PMReal>	edges;		// Left and right of each tile.
+		bool				retried;	// need_retry_line asked for another go.
+	};
+
+	struct tile_span
+	{
+		TextIndex	span;
+		PMReal		x,
+					width;
+	};
+
+	TextIndex				start,
+							span;
+	std::vector<attempt>	attempts;	// Empty if the tiler ran out of tiles.
+	std::vector<tile_span>	tiles;
+	line_metrics			metrics;
+	PMReal					drop_indent;
+	int						drop_lines;
+	fingerprint				composed;	// As compose_line's fp.
+};
+
+
+
+/** Paragraphs shaped before compose_line gets to them, so a paragraph's 
+	first line can be filled without shaping it there and then. Only the 
+	window fill_window would shape for that line is wanted.
+*/
+class shaped_source
+{
+public:
+	virtual ~shaped_source() {}
+
+	/** Move the runs shaped for the start of the paragraph from start to 
+		end into t.
+		@return Where the text shaped for t ends, or start, leaving t alone, 
+			if none of it has been shaped.
+	*/
+	virtual TextIndex	take(TextIndex start, TextIndex end, tile & t) = 0;
+};
 
-IWaxLine *	compose_line(tiler &, gr_face_cache &, IParagraphComposer::RecomposeHelper &, const TextIndex ti);
-bool		rebuild_line(gr_face_cache & faces, const IParagraphComposer::RebuildHelper &);
+
+/** How far compose_line goes to balance the rag of a ragged paragraph. 
+	Each line of one is broken at the narrowest width that keeps the rest 
+	of the paragraph to as many lines as breaking at full width, found by 
+	bisection, so the lines come out nearly even instead of full lines over
+	a short last one. A line's break depends on the text after it, so a 
+	balanced paragraph must be recomposed from its first line.
+*/
+struct balance_limits
+{
+	TextIndex	max_chars;		// Longer paragraphs are broken as usual.
+	int			max_trials;		// Widths tried per line.
+};
+
+
+/** Fill t with only as much of the paragraph from ti to end as breaking a
+	line line_width wide needs: twice that width, more than any 
+	justification settings can squeeze onto it. The window starts at an 
+	estimate of a quarter em per character and doubles until it holds that 
+	much. Each piece ends at a style_runs::segment_end, so the glyphs are 
+	those shaping the whole paragraph gives.
+	@param filled IN/OUT Where the text already in t ends, ti if t is 
+		empty. Set to where it ends after filling.
+*/
+bool		fill_window(tile & t, const style_runs & styles, gr_face_cache & faces, TextIndex ti, TextIndex & filled, 
+						TextIndex end, const PMReal & line_width, const PMReal & em);
+/** Compose the line starting at ti.
+	@param stage OUT If not nil, filled with what apply_staged_line needs to
+		reproduce the line.
+	@param shaped IN If not nil, asked for the start of the paragraph 
+		already shaped when filling the first line of one, and the window 
+		filled out from where that ends. Later lines shape their own.
+	@param balance IN If not nil, balance the rag of short paragraphs that 
+		are not justified and set in a single tile without drop caps.
+	@param hyphens IN If not nil, the line may also break where it 
+		hyphenates a word.
+	@param fp OUT If not nil, set to the fingerprint of the line as 
+		composed. A line composed again with the same one, in the same 
+		place, rebuilds the same, so the host can keep the wax line it had.
+*/
+IWaxLine *	compose_line(tiler &, gr_face_cache &, IParagraphComposer::RecomposeHelper &, const TextIndex ti, 
+						 staged_line * stage = nil, shaped_source * shaped = nil, const balance_limits * balance = nil,
+						 const hyphenator * hyphens = nil, fingerprint * fp = nil);
+/** Put a line composed elsewhere with compose_line on the host, asking the
+	tiler for tiles as compose_line would have.
+	@return nil, having applied nothing, if the tiler hands back different 
+		tiles to those the line was staged with. Compose the line with 
+		compose_line instead.
+*/
+IWaxLine *	apply_staged_line(tiler &, IParagraphComposer::RecomposeHelper &, const staged_line & stage);
+/** Build the wax runs for a composed line.
+	@param fp OUT If not nil the fingerprint of the rebuilt line is added to 
+		it, when the rebuild succeeds.
+	@param hyphens IN The hyphenator the line was composed with, to set a 
+		hyphen at the end of each tile compose_line broke at one.
+	@param batch IN A batch to assemble the runs' glyphs in, kept by the 
+		caller between lines so its arrays are allocated once. If nil the
+		line uses its own.
+*/
+bool		rebuild_line(gr_face_cache & faces, const IParagraphComposer::RebuildHelper &, fingerprint * fp = nil,
+						 const hyphenator * hyphens = nil, glyph_batch * batch = nil);
 
 
 inline
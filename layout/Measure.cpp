@@ -0,0 +1,173 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <algorithm>
+#include <iterator>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IComposeScanner.h>
+#include <ICompositionStyle.h>
+#include <IDrawingStyle.h>
+// Library headers
+// Module header
+#include "Measure.h"
+#include "Run.h"
+#include "StyleRuns.h"
+#include "Tiler.h"
+#include "Trace.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+
+namespace
+{
+	// Characters in each piece of the paragraph shaped, before rounding up 
+	// to the next segment end.
+	const TextIndex piece = 64;
+
+
+	// The width of a broken tile's text without its trailing whitespace, 
+	// with the hyphen if it was broken at one.
+	PMReal text_width(const tile & t)
+	{
+		PMReal	w = t.content_dimensions().X();
+		if (t.ends_at_hyphen())
+			return w + t.back()->hyphen_width();
+
+		for (tile::const_iterator r = t.end(); r != t.begin();)
+		{
+			--r;
+			typedef std::reverse_iterator<run::const_iterator>	rev_t;
+			for (rev_t cl = rev_t((*r)->end()), cl_e = rev_t((*r)->begin()); cl != cl_e; ++cl)
+			{
+				if (!cl->whitespace())	return w;
+				w -= cl->width();
+			}
+		}
+		return w;
+	}
+}
+
+
+measurer::measurer(IComposeScanner & scanner, gr_face_cache & faces, TextIndex start, TextIndex end, 
+				   const hyphenator * hyphens)
+: _start(start),
+  _indent_first(0),
+  _indent_left(0),
+  _indent_right(0),
+  _ok(false)
+{
+	NRSC_TRACE_SCOPE("measurer::measurer");
+	InterfacePtr<ICompositionStyle> cs(scanner.GetParagraphStyleAt(start), UseDefaultIID());
+	if (cs == nil)	return;
+
+	_indent_first = cs->IndentLeftFirst();
+	_indent_left  = cs->IndentLeftBody();
+	_indent_right = cs->IndentRightBody();
+
+	// Shape in pieces cut where compose_line's windows may be cut, so 
+	// measure can break a window of whole runs rather than the rest of the 
+	// paragraph for every line.
+	style_runs	styles;
+	_ok = styles.build(scanner, start, end);
+	for (TextIndex pos = start; _ok && pos < end;)
+	{
+		const TextIndex cut = styles.segment_end(std::min(pos + piece, end), end);
+		_ok = _shaped.fill_by_span(styles, faces, pos, cut - pos);
+		pos = cut;
+	}
+	if (_ok && hyphens)
+		_shaped.hyphenate(*hyphens, scanner.QueryDataAt(start, nil, nil));
+}
+
+
+/* Break a copy of the shaped paragraph into lines width wide, as the
+tiler would lay them out in a column that wide, after making adj to it. 
+Returns false if a line could not take even one cluster.
+*/
+bool measurer::measure(const PMReal & width, lines_t & lines, const adjustment & adj) const
+{
+	NRSC_TRACE_SCOPE("measurer::measure");
+	lines.clear();
+	if (!_ok)	return false;
+
+	// Scaling every advance by k breaks as the column scaled by 1/k does, 
+	// word space allowances and all, so that is what is measured.
+	const PMReal	k = adj.size*adj.glyph_scale,
+					tracking = adj.tracking/k;
+
+	tile pending, rest;
+	for (tile::const_iterator r = _shaped.begin(), r_e = _shaped.end(); r != r_e; ++r)
+	{
+		pending.push_back((*r)->copy());
+		if (tracking != 0)
+			pending.back()->adjust_widths(0, 0, tracking, 0);
+	}
+
+	for (TextIndex ti = _start; !rest.empty() || !pending.empty();)
+	{
+		// Break a window of twice the line's width, as compose_line does.
+		// break_into lets the last letter overhang by its letterspace, 
+		// which tracking adds to.
+		const PMReal	left = _indent_left + (ti == _start ? _indent_first : 0);
+		tile			t(PMRect(left/k, 0, (width - _indent_right)/k + tracking, 0));
+		t.take_runs(rest);
+		t.take_runs(pending, 2*t.dimensions().X());
+		t.apply_tab_widths();
+		t.break_into(rest, cluster::penalty::letter);
+		if (t.span() == 0)	return false;
+
+		line_metrics lm(t.front()->get_style());
+		for (tile::const_iterator r = t.begin(), r_e = t.end(); r != r_e; ++r)
+			lm += (*r)->get_style();
+
+		const line_measure	m = { ti, TextIndex(t.span()), k*text_width(t), adj.size*lm.leading };
+		lines.push_back(m);
+		ti += m.span;
+	}
+
+	return true;
+}
+
+
+PMReal measurer::longest(const lines_t & lines)
+{
+	PMReal w = 0;
+	for (lines_t::const_iterator l = lines.begin(), l_e = lines.end(); l != l_e; ++l)
+		w = std::max(w, l->width);
+	return w;
+}
+
+
+PMReal measurer::depth(const lines_t & lines)
+{
+	PMReal d = 0;
+	for (lines_t::const_iterator l = lines.begin(), l_e = lines.end(); l != l_e; ++l)
+		d += l->height;
+	return d;
+}
@@ -0,0 +1,115 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <vector>
+// Interface headers
+// Library headers
+#include <textiterator.h>
+// Module header
+#include "Tile.h"
+
+// Forward declarations
+// InDesign interfaces
+class IComposeScanner;
+// Graphite forward delcarations
+
+namespace nrsc 
+{
+// Project forward declarations
+class gr_face_cache;
+class hyphenator;
+
+/* measurer class
+Answers how a paragraph breaks into lines of a given width without 
+composing it. There is no tiler, wax line or wax run, only shaping and 
+tile::break_into against a rectangular column with the paragraph's 
+indents, so the lines are those compose_line makes in such a column. The 
+paragraph is shaped once when the measurer is made and each measure 
+breaks a copy of the shaped runs a window at a time, so asking at many 
+widths costs one shaping. Drop caps are not measured.
+*/
+class measurer
+{
+public:
+	struct line_measure
+	{
+		TextIndex	start,
+					span;
+		PMReal		width,		// Of the text, less any trailing whitespace.
+					height;		// The line's leading.
+	};
+	typedef std::vector<line_measure>	lines_t;
+
+	/* Changes to measure the paragraph with, made to the shaped text 
+	rather than by shaping again: the point size and glyph scale as ratios 
+	of those set, which scale every advance (and, for size, the leading), 
+	and tracking in points added to the letterspace. Scaling assumes the 
+	font's advances scale linearly, as Graphite's do, and moves tab stops 
+	with the text.
+	*/
+	struct adjustment
+	{
+		PMReal	size,
+				glyph_scale,
+				tracking;
+
+		adjustment() : size(1), glyph_scale(1), tracking(0) {}
+	};
+
+	/** @param hyphens IN If not nil, break lines where it hyphenates words 
+			too, as compose_line given it does.
+	*/
+	measurer(IComposeScanner & scanner, gr_face_cache & faces, TextIndex start, TextIndex end, 
+			 const hyphenator * hyphens = nil);
+
+	bool	shaped() const;
+	bool	measure(const PMReal & width, lines_t & lines, const adjustment & adj = adjustment()) const;
+
+	static PMReal	longest(const lines_t & lines);
+	static PMReal	depth(const lines_t & lines);
+
+private:
+	// Hide copy constructor and assignment operator.
+	measurer(const measurer &);
+	measurer & operator = (const measurer &);
+
+	tile		_shaped;
+	TextIndex	_start;
+	PMReal		_indent_first,
+				_indent_left,
+				_indent_right;
+	bool		_ok;
+};
+
+
+inline
+bool measurer::shaped() const
+{
+	return _ok;
+}
+
+} // end of namespace nrsc
\ No newline at end of file
@@ -0,0 +1,102 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+// Interface headers
+// Library headers
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+
+namespace nrsc 
+{
+// Project forward declarations
+
+/* mutex class
+A plain non-recursive lock over the platform's own, for the few places the
+engine is called from more than one thread at once. Lock it for a block 
+with a mutex::scope.
+*/
+class mutex
+{
+public:
+	mutex();
+	~mutex();
+
+	void	lock();
+	void	unlock();
+
+	class scope
+	{
+	public:
+		explicit scope(mutex & m) : _m(m)	{ _m.lock(); }
+		~scope()							{ _m.unlock(); }
+
+	private:
+		// Hide copy constructor and assignment operator.
+		scope(const scope &);
+		scope & operator = (const scope &);
+
+		mutex & _m;
+	};
+
+private:
+	// Hide copy constructor and assignment operator.
+	mutex(const mutex &);
+	mutex & operator = (const mutex &);
+
+#if defined(_WIN32)
+	CRITICAL_SECTION	_lock;
+#else
+	pthread_mutex_t		_lock;
+#endif
+};
+
+
+#if defined(_WIN32)
+
+inline mutex::mutex()		{ ::InitializeCriticalSection(&_lock); }
+inline mutex::~mutex()		{ ::DeleteCriticalSection(&_lock); }
+inline void mutex::lock()	{ ::EnterCriticalSection(&_lock); }
+inline void mutex::unlock()	{ ::LeaveCriticalSection(&_lock); }
+
+#else
+
+inline mutex::mutex()		{ ::pthread_mutex_init(&_lock, 0); }
+inline mutex::~mutex()		{ ::pthread_mutex_destroy(&_lock); }
+inline void mutex::lock()	{ ::pthread_mutex_lock(&_lock); }
+inline void mutex::unlock()	{ ::pthread_mutex_unlock(&_lock); }
+
+#endif
+
+} // end of namespace nrsc
\ No newline at end of file
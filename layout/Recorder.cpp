@@ -0,0 +1,311 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IComposeScanner.h>
+#include <ICompositionStyle.h>
+#include <IDrawingStyle.h>
+#include <IJustificationStyle.h>
+#include <IPMFont.h>
+#include <ITextParcelList.h>
+#include <IWaxLine.h>
+#include <IWaxRun.h>
+// Library headers
+#include "adobe/unicode.hpp"
+#include <TabStop.h>
+#include <textiterator.h>
+// Module header
+#include "Recorder.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+
+namespace
+{
+	/* Builds a record in memory so it can be compared with earlier ones 
+	before it is written.
+	*/
+	class record : public std::string
+	{
+	public:
+		explicit record(char tag = 0)			{ if (tag) push_back(tag); }
+
+		record & u8(unsigned char v)			{ push_back(char(v)); return *this; }
+		record & u16(unsigned short v)			{ return u8(v & 0xff).u8(v >> 8); }
+		record & u32(unsigned long v)			{ return u16(v & 0xffff).u16((v >> 16) & 0xffff); }
+		record & i32(long v)					{ return u32(static_cast<unsigned long>(v)); }
+		record & real(const PMReal & r)
+		{
+			const double d = ToDouble(r);
+			unsigned char b[sizeof d];
+			std::memcpy(b, &d, sizeof d);
+			for (size_t i = 0; i != sizeof d; ++i)	u8(b[i]);
+			return *this;
+		}
+		record & str(const std::string & s)		{ u32(s.size()); append(s); return *this; }
+	};
+
+	typedef std::map<std::string, unsigned long>	index_t;
+
+	std::FILE * file = 0;
+	index_t		fonts,
+				styles;
+	std::string	last_paragraph;
+	TextIndex	last_start = -1,
+				last_end = -1;
+
+
+	void write(const std::string & r)
+	{
+		std::fwrite(r.data(), 1, r.size(), file);
+	}
+
+
+	unsigned long font_id(const IDrawingStyle & ds)
+	{
+		InterfacePtr<IPMFont> font(ds.QueryFont());
+		const K2Vector<PMString> * const paths = font ? font->GetFullPath() : nil;
+		std::string path;
+		if (paths && !paths->empty())
+			adobe::to_utf8((*paths)[0].begin(), (*paths)[0].end(), std::back_inserter(path));
+
+		index_t::iterator f = fonts.find(path);
+		if (f == fonts.end())
+		{
+			f = fonts.insert(index_t::value_type(path, fonts.size())).first;
+			write(record('F').u32(f->second).str(path));
+		}
+		return f->second;
+	}
+
+
+	unsigned long style_id(IDrawingStyle * ds)
+	{
+		InterfacePtr<ICompositionStyle>		cs(ds, UseDefaultIID());
+		InterfacePtr<IJustificationStyle>	js(ds, UseDefaultIID());
+		int16	drop_chars = 0, 
+				drop_lines = 0;
+		PMReal	ws[3], ls[3], gs[3];
+		if (cs)	cs->GetDropCapInfo(&drop_chars, &drop_lines);
+		if (js)
+		{
+			js->GetWordspace(&ws[0], &ws[1], &ws[2]);
+			js->GetLetterspace(&ls[0], &ls[1], &ls[2]);
+			js->GetGlyphscale(&gs[0], &gs[1], &gs[2]);
+		}
+
+		record attrs;
+		attrs.u32(font_id(*ds)).real(ds->GetPointSize()).real(ds->GetLeading())
+			 .i32(cs ? cs->GetParagraphAlignment() : ICompositionStyle::kTextAlignLeft)
+			 .u8(cs && cs->GetNoBreak()).i32(drop_chars).i32(drop_lines)
+			 .real(cs ? cs->IndentLeftBody() : 0).real(cs ? cs->IndentLeftFirst() : 0).real(cs ? cs->IndentRightBody() : 0)
+			 .real(cs ? cs->GetTabStopAfter(0).GetPosition() : 0);
+		for (int i = 0; i != 3; ++i)	attrs.real(ws[i]);
+		for (int i = 0; i != 3; ++i)	attrs.real(ls[i]);
+		for (int i = 0; i != 3; ++i)	attrs.real(gs[i]);
+
+		index_t::iterator s = styles.find(attrs);
+		if (s == styles.end())
+		{
+			s = styles.insert(index_t::value_type(attrs, styles.size())).first;
+			write(record('S').u32(s->second) + attrs);
+		}
+		return s->second;
+	}
+
+
+	/* Write the text and styles of the paragraph at start unless it is the
+	one last written. With no end, the paragraph runs to the next CR.
+	*/
+	void paragraph(IComposeScanner & scanner, TextIndex start, TextIndex end = -1)
+	{
+		std::vector<UTF16TextChar>	text;
+		record						runs;
+		size_t						n_runs = 0;
+		for (TextIndex offset = start; end < 0 || offset < end; ++n_runs)
+		{
+			IDrawingStyle * ds = nil;
+			int32			span = 0;
+			TextIterator	ti = scanner.QueryDataAt(offset, &ds, &span);
+			if (ti.IsNull() || ds == nil || span <= 0)	break;
+			if (end >= 0 && span > end - offset)		span = end - offset;
+
+			WideString	run_text;
+			ti.AppendToStringAndIncrement(&run_text, span);
+			int32 len = 0;
+			const UTF16TextChar * const chars = run_text.GrabUTF16Buffer(&len);
+			if (end < 0)
+			{
+				const UTF16TextChar * const cr = std::find(chars, chars + len, UTF16TextChar(kTextChar_CR));
+				if (cr != chars + len)	end = offset + (len = int32(cr - chars) + 1);
+			}
+			text.insert(text.end(), chars, chars + len);
+			runs.u32(len).u32(style_id(ds));
+			offset += len;
+		}
+
+		record r('P');
+		r.u32(start).u32(text.size());
+		for (size_t i = 0; i != text.size(); ++i)	r.u16(text[i]);
+		r.u32(n_runs) += runs;
+
+		last_start = start;
+		last_end = start + TextIndex(text.size());
+		if (r == last_paragraph)	return;
+		write(r);
+		last_paragraph.swap(r);
+	}
+
+
+	record & line_geometry(record & r, const IWaxLine & wl)
+	{
+		r.real(wl.GetYPosition()).real(wl.GetYAdvance()).u32(wl.GetNumberOfTiles());
+		for (int32 t = 0, n = wl.GetNumberOfTiles(); t != n; ++t)
+			r.i32(wl.GetTextSpanInTile(t)).real(wl.GetXPosition(t)).real(wl.GetTargetWidth(t));
+
+		PMReal	indent = 0;
+		int32	lines = 0;
+		const int32 n = wl.GetDropCapIndents(&indent, &lines);
+		return r.i32(n).real(indent).i32(lines);
+	}
+}
+
+
+bool recorder::open(const char * path)
+{
+	close();
+	file = std::fopen(path, "wb");
+	if (file == 0)	return false;
+
+	write(record('G').u8('R').u8('R').u8('C').u32(version));
+	return true;
+}
+
+
+bool recorder::is_open()
+{
+	return file != 0;
+}
+
+
+void recorder::close()
+{
+	if (file)	std::fclose(file);
+	file = 0;
+	fonts.clear();
+	styles.clear();
+	last_paragraph.clear();
+	last_start = last_end = -1;
+}
+
+
+void recorder::recompose(IParagraphComposer::RecomposeHelper & helper)
+{
+	if (file == 0)	return;
+
+	paragraph(*helper.GetComposeScanner(), helper.GetParagraphStart(), helper.GetParagraphEnd());
+
+	const ParcelKey key = helper.GetStartingParcelKey();
+	const IWaxLine * const pwl = helper.GetPreviousWaxLine();
+	PMReal	indent = 0;
+	int32	lines = 0, 
+			n = pwl && pwl->GetNextLineAffectedByDropcap() ? pwl->GetDropCapIndents(&indent, &lines) : 0;
+	write(record('C').u32(helper.GetStartingTextIndex()).real(helper.GetStartingYPosition())
+		  .u32(key.IsValid() ? helper.GetTextParcelList()->GetFirstLineOffsetMetric(key) : Text::kFLOLeading)
+		  .i32(n).real(indent).i32(lines));
+}
+
+
+void recorder::tiles(const PMReal & min_width, const PMReal & height, const PMReal & TOF_height, 
+					 TextIndex position, const PMReal & y_in, bool16 result, const PMReal & y_out, 
+					 Text::FirstLineOffsetMetric TOF_metric, const PMRectCollection & tiles, 
+					 bool16 at_TOF, bool16 parcel_dependent, 
+					 const PMReal & left_margin, const PMReal & right_margin)
+{
+	if (file == 0)	return;
+
+	record r('T');
+	r.real(min_width).real(height).real(TOF_height).u32(position).real(y_in)
+	 .u8(result != kFalse).real(y_out).i32(TOF_metric).u8(at_TOF != kFalse).u8(parcel_dependent != kFalse)
+	 .real(left_margin).real(right_margin).u32(tiles.size());
+	for (PMRectCollection::const_iterator t = tiles.begin(), t_e = tiles.end(); t != t_e; ++t)
+		r.real(t->Left()).real(t->Top()).real(t->Right()).real(t->Bottom());
+	write(r);
+}
+
+
+void recorder::composed_line(TextIndex ti, const IWaxLine & wl)
+{
+	if (file == 0)	return;
+
+	record r('L');
+	write(line_geometry(r.u32(ti), wl));
+}
+
+
+void recorder::rebuild(const IParagraphComposer::RebuildHelper & helper)
+{
+	if (file == 0)	return;
+
+	// A paragraph's text can only change by way of a recompose, which 
+	// records it, so a line inside the last paragraph written needs no 
+	// fresh copy. Reading it again for every line rebuilt would make 
+	// recording quadratic in the paragraph's length.
+	const IWaxLine & wl = *helper.GetWaxLine();
+	TextIndex line_end = helper.GetTextIndex();
+	for (int32 t = 0, n = wl.GetNumberOfTiles(); t != n; ++t)
+		line_end += wl.GetTextSpanInTile(t);
+	if (helper.GetParagraphStart() != last_start || line_end > last_end)
+		paragraph(*helper.GetComposeScanner(), helper.GetParagraphStart());
+
+	record r('B');
+	write(line_geometry(r.u32(helper.GetTextIndex()), wl));
+}
+
+
+void recorder::wax_run(const IWaxRun & wr, const PMReal & width, TextIndex span)
+{
+	if (file == 0)	return;
+
+	write(record('W').real(wr.GetXPosition()).real(wr.GetYPosition()).real(width).i32(span));
+}
+
+
+void recorder::rebuilt()
+{
+	if (file == 0)	return;
+
+	write(record('E'));
+}
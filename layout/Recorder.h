@@ -0,0 +1,106 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+// Interface headers
+#include <IParagraphComposer.h>
+// Library headers
+#include <K2Vector.h>
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+class IWaxLine;
+class IWaxRun;
+// Graphite forward delcarations
+// Project forward declarations
+
+/* Recording of the host calls the composer makes.
+When NRSC_RECORDER is defined and a recording has been opened, compose_line 
+and rebuild_line log everything they get from and give to InDesign: the 
+paragraph text, the attributes and font paths of its drawing styles, the 
+GetTiles geometry and the wax lines and runs produced. A replay driver can 
+feed a recording back through the engine without the document it came 
+from. Without NRSC_RECORDER the NRSC_RECORD() hooks expand to nothing.
+
+The recorder is not thread safe, compose from one thread while recording.
+
+File format, little endian, reals are IEEE doubles, strings a u32 length 
+followed by that many bytes of UTF-8:
+	"GRRC" u32 version
+	'F' u32 font_id string path
+	'S' u32 style_id u32 font_id real point_size real leading i32 alignment
+		u8 no_break i32 drop_chars i32 drop_lines real indent_left 
+		real indent_first real indent_right real tab_interval 
+		real word_space[3] real letter_space[3] real glyph_scale[3]
+	'P' u32 start u32 length u16 text[length] u32 n (u32 span u32 style_id)[n]
+	'C' u32 start real y u32 first_line_offset_metric 
+		i32 drop_indents real drop_indent i32 drop_lines
+	'T' real min_width real height real TOF_height u32 position real y_in
+		u8 result real y_out i32 TOF_metric u8 at_TOF u8 parcel_dependent 
+		real left_margin real right_margin u32 n (real l real t real r real b)[n]
+	'L' u32 start real y real height u32 n (i32 span real x real width)[n]
+		i32 drop_indents real drop_indent i32 drop_lines
+	'B' u32 start, then as 'L' from y
+	'W' real x real y real width i32 span
+	'E'
+A 'C' starts a recompose call for the paragraph in the last 'P', and is 
+followed by its 'T' and 'L' records. A 'B' starts a rebuild of the line 
+it describes, followed by a 'W' for each wax run and an 'E' if it succeeded.
+*/
+#if defined(NRSC_RECORDER)
+#define NRSC_RECORD(call)	nrsc::recorder::call
+#else
+#define NRSC_RECORD(call)	((void)0)
+#endif
+
+namespace nrsc 
+{
+namespace recorder
+{
+	enum { version = 1 };
+
+	/** Start recording to a new file, ending any current recording.
+		@return false if the file cannot be created.
+	*/
+	bool	open(const char * path);
+	bool	is_open();
+	void	close();
+
+	// Hooks
+	void	recompose(IParagraphComposer::RecomposeHelper & helper);
+	void	tiles(const PMReal & min_width, const PMReal & height, const PMReal & TOF_height, 
+				  TextIndex position, const PMReal & y_in, bool16 result, const PMReal & y_out, 
+				  Text::FirstLineOffsetMetric TOF_metric, const PMRectCollection & tiles, 
+				  bool16 at_TOF, bool16 parcel_dependent, 
+				  const PMReal & left_margin, const PMReal & right_margin);
+	void	composed_line(TextIndex ti, const IWaxLine & wl);
+	void	rebuild(const IParagraphComposer::RebuildHelper & helper);
+	void	wax_run(const IWaxRun & wr, const PMReal & width, TextIndex span);
+	void	rebuilt();
+}
+
+} // end of namespace nrsc
\ No newline at end of file
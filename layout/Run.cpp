@@ -30,14 +30,19 @@ THE SOFTWARE.
 #include <IFontInstance.h>
 #include <IJustificationStyle.h>
 #include <IWaxGlyphs.h>
-#include <IWaxGlyphsME.h>
 #include <IWaxRenderData.h>
 #include <IWaxRun.h>
 // Library headers
 #include <PMRealGlyphPoint.h>
 #include <textiterator.h>
 // Module header
+#include "Allocations.h"
+#include "FallbackRun.h"
+#include "GlyphBatch.h"
+#include "GraphiteRun.h"
+#include "InlineObjectRun.h"
 #include "Run.h"
+#include "Trace.h"
 
 // Forward declarations
 // InDesign interfaces
@@ -48,20 +53,22 @@ using namespace nrsc;
 
 const textchar kTextChar_EnQuadSpace = 0x2000;
 
-run::run()
+run::run(kind_t k)
 : _trailing_ws(end()),
   _glyph_stretch(0),
   _scale(1.0),
+  _kind(k),
   _drawing_style(nil),
   _height(0),
   _span(0)
 {
 }
 
-run::run(IDrawingStyle * ds)
+run::run(kind_t k, IDrawingStyle * ds)
 : _trailing_ws(end()),
   _glyph_stretch(0),
   _scale(1.0),
+  _kind(k),
   _drawing_style(ds),
   _height(ds->GetLeading()),
   _span(0)
@@ -74,14 +81,29 @@ run::~run() throw()
 }
 
 
-inline
-size_t run::num_glyphs() const
+bool run::layout_span(TextIterator first, size_t span)
 {
-	size_t n = 0;
-	for (const_iterator cl_i = begin(); cl_i != end(); ++cl_i)
-		n += cl_i->size();
+	switch (_kind)
+	{
+	case graphite:	return static_cast<graphite_run *>(this)->layout_span(first, span);
+	case fallback:	return static_cast<fallback_run *>(this)->layout_span(first, span);
+	case object:	return static_cast<inline_object *>(this)->layout_span(first, span);
+	}
 
-	return n;
+	return false;
+}
+
+
+run * run::clone_empty() const
+{
+	switch (_kind)
+	{
+	case graphite:	return new graphite_run();
+	case fallback:	return new fallback_run();
+	case object:	return new inline_object();
+	}
+
+	return nil;
 }
 
 
@@ -234,61 +256,32 @@ run & run::join(run & rhs)
 }
 
 
-bool run::render_run(IWaxGlyphs & glyphs) const
+void run::render_run(glyph_batch & batch) const
 {
-	const size_t num = num_glyphs();
-	float * x_offs = new float[num],
-		  * y_offs = new float[num],
-		  * widths = new float[num];
-
-	//Assemble glyphs
-	float * xo = x_offs,
-		  * yo = y_offs,
-		  * w  = widths;
-	for (const_iterator cl_i = begin(); cl_i != end(); ++cl_i)
-	{
-		const cluster & cl = *cl_i;
-		for (cluster::const_iterator g = cl.begin(); g != cl.end(); ++g, ++w, ++xo, ++yo)
-		{
-			*w = 0;
-			*xo = ToFloat(_scale*g->pos().X());
-			*yo = ToFloat(_scale*g->pos().Y());
-			glyphs.AddGlyph(g->id(), ToFloat(_scale*g->advance()));
-		}
-	}
+	batch.clear();
+	batch.reserve(_span, _span);	// Most runs have a glyph per character.
 
-	// Position shifted glyphs
-	InterfacePtr<IWaxGlyphsME> glyphs_me(&glyphs, UseDefaultIID());
-	if (glyphs_me != nil)
-		glyphs_me->AddGlyphMEData(num, x_offs, y_offs, widths);
-
-	// Do the mappings
-	int	i  = 0, 
-		gi = 0;
-	for (const_iterator cl_i = begin(); cl_i != end(); ++cl_i)
+	// Assemble glyphs and the mappings of their characters.
+	int32 gi = 0;
+	for (const_iterator cl_i = begin(), cl_e = end(); cl_i != cl_e; ++cl_i)
 	{
 		const cluster & cl = *cl_i;
-		
-		glyphs.AddMappingWidth(_scale*cl.width());
-		glyphs.AddMappingRange(i++, gi, cl.size());
-		for (unsigned char n = cl.span()-1; n; --n, ++i)
-		{
-			glyphs.AddMappingWidth(0);
-			glyphs.AddMappingRange(i, gi, cl.size());
-		}
-		gi += cl.size();
+		for (cluster::const_iterator g = cl.begin(), g_e = cl.end(); g != g_e; ++g)
+			batch.add_glyph(g->id(), ToFloat(_scale*g->advance()), 
+							ToFloat(_scale*g->pos().X()), ToFloat(_scale*g->pos().Y()));
+
+		batch.add_char(_scale*cl.width(), gi, int32(cl.size()));
+		for (unsigned char n = cl.span()-1; n; --n)
+			batch.add_char(0, gi, int32(cl.size()));
+		gi += int32(cl.size());
 	}
-
-	delete [] x_offs;
-	delete [] y_offs;
-	delete [] widths;
-
-	return true;
 }
 
 
-IWaxRun * run::wax_run() const
+IWaxRun * run::wax_run(glyph_batch & batch) const
 {
+	NRSC_TRACE_SCOPE("run::wax_run");
+	NRSC_ALLOC_PHASE(wax);
 	// Check we've got composed text to put in the run and a line to put it in.
 	if (_span <= 0)	return nil;
 
@@ -315,7 +308,8 @@ IWaxRun * run::wax_run() const
 	glyphs_mat.Scale(_scale*(1+_glyph_stretch), _scale);
 	glyphs->SetAllGlyphsMatrix(glyphs_mat, pc);
 
-	render_run(*glyphs);
+	render_run(batch);
+	batch.submit(*glyphs);
 
 	return wr;
 }
@@ -353,33 +347,24 @@ void run::apply_desired_widths()
 
 void run::adjust_widths(PMReal fill_space, PMReal word_space, PMReal letter_space, PMReal glyph_scale)
 {
+	// Width adjustment for each justification level. Diacritics are shifted 
+	// back by the letterspace instead, and fixed width glyphs only take 
+	// letterspace if they have a width.
+	const PMReal	kerns[] = {fill_space, letter_space + word_space, letter_space, 0, letter_space, 0};
+
 	for (iterator cl = begin(), cl_e = _trailing_ws; cl != cl_e; ++cl)
 	{
 		for (cluster::iterator g = cl->begin(), g_e = cl->end(); g != g_e; ++g)
 		{
+			const glyf::justification_t level = g->justification();
+
 			g->kern(glyph_scale*g->width());
 			g->shift(glyph_scale*g->pos().X());
 
-			switch (g->justification())
-			{
-			case glyf::fill:
-				g->kern(fill_space);
-				break;
-			case glyf::space:
-				g->kern(letter_space + word_space);
-				break;
-			case glyf::letter:
-				g->kern(letter_space);
-				break;
-			case glyf::glyph:
+			if (level == glyf::glyph)
 				g->shift(-letter_space);
-				break;
-			case glyf::fixed:
-				if (g->width() > 0) g->kern(letter_space);
-				break;
-			default: 
-				break;
-			}
+			else if (level != glyf::tab && (level != glyf::fixed || g->width() > 0))
+				g->kern(kerns[level]);
 		}
 	}
 
@@ -427,6 +412,44 @@ run * run::split(run::const_iterator position)
 }
 
 
+/* A new run with copies of this one's clusters, to break and justify 
+without disturbing this one. Like a run split off, it cannot be laid out 
+again.
+*/
+run * run::copy() const
+{
+	run * new_run	 = clone_empty();
+	new_run->_drawing_style = _drawing_style;
+	new_run->_height        = _height;
+	new_run->_span          = _span;
+	new_run->insert(new_run->end(), begin(), end());
+
+	return new_run;
+}
+
+
+// The advance of a hyphen set after this run's last letter, with the 
+// letterspace a letter gets.
+PMReal run::hyphen_width() const
+{
+	InterfacePtr<IFontInstance>			font = _drawing_style->QueryFontInstance(kFalse);
+	InterfacePtr<IJustificationStyle>	js(_drawing_style, UseDefaultIID());
+	if (font == nil || js == nil)	return 0;
+
+	return font->GetGlyphWidth(font->GetGlyphID(kTextChar_HyphenMinus)) + js->GetAlteredLetterspace(false);
+}
+
+
+// Set a hyphen at the end of the last cluster, for a line broken there.
+void run::add_hyphen()
+{
+	InterfacePtr<IFontInstance>	font = _drawing_style->QueryFontInstance(kFalse);
+	if (empty() || font == nil)	return;
+
+	back().add_glyf(glyf(font->GetGlyphID(kTextChar_HyphenMinus), glyf::letter, hyphen_width()));
+}
+
+
 void run::trim_trailing_whitespace(const PMReal letter_space)
 {
 	if (_trailing_ws == end())
@@ -445,8 +468,9 @@ void run::trim_trailing_whitespace(const PMReal letter_space)
 	}
 
 	// Re-assign any letterspace contributed whitespace in the final
-	// glyph to the adjacent trailing whitespace.
-	if (_trailing_ws != end())
+	// glyph to the adjacent trailing whitespace, if the run is not all 
+	// whitespace.
+	if (_trailing_ws != end() && _trailing_ws != begin())
 	{
 		iterator non_ws = _trailing_ws;
 		--non_ws;
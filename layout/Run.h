@@ -31,46 +31,56 @@ THE SOFTWARE.
 // Interface headers
 // Library headers
 // Module header
+#include "Allocations.h"
 #include "Box.h"
 
 // Forward declarations
 class TextIterator;
 // InDesign interfaces
 class IDrawingStyle;
-class IWaxGlyphs;
 class IWaxRun;
 // Graphite forward delcarations
 
 namespace nrsc 
 {
+// Project forward declarations
+class glyph_batch;
 
 
-class run : protected std::list<cluster>
+class run : protected std::list<cluster, allocations::allocator<cluster, allocations::clusters>::type>
 {
-	typedef std::list<cluster>	base_t;
+public:
+	// The closed set of run kinds, used to dispatch to the concrete run
+	// class without going through a virtual call.
+	enum kind_t	{graphite, fallback, object};
+
+private:
+	typedef std::list<cluster, allocations::allocator<cluster, allocations::clusters>::type>	base_t;
 
 	// Hide copy constructor and assignment operator.
 	run(const run&);
 	run & operator = (const run &);
 
-	void run::layout_span_with_spacing(TextIterator &, const TextIterator &, PMReal, glyf::justification_t);
-	size_t num_glyphs() const;
+	void layout_span_with_spacing(TextIterator &, const TextIterator &, PMReal, glyf::justification_t);
 
 	base_t::iterator	_trailing_ws;
 	PMReal				_glyph_stretch,
 						_scale;
+	const kind_t		_kind;
+
+	friend class fingerprint;
 
 protected:
-	run();
+	run(kind_t);
 
 	void	add_glue(glyf::justification_t level, PMReal width, cluster::penalty::type bw=cluster::penalty::whitespace);
 	void	add_letter(int glyph_id, PMReal width, cluster::penalty::type bw=cluster::penalty::letter, bool to_cluster=false);
 
-	run(IDrawingStyle *);
+	run(kind_t, IDrawingStyle *);
 
-	virtual bool	layout_span(TextIterator first, size_t span) = 0;
-	virtual bool	render_run(IWaxGlyphs & run) const;
-	virtual run	  * clone_empty() const = 0;
+	bool	layout_span(TextIterator first, size_t span);
+	void	render_run(glyph_batch & batch) const;
+	run	  * clone_empty() const;
 
 
 	InterfacePtr<IDrawingStyle>	_drawing_style;
@@ -80,6 +90,11 @@ protected:
 public:
 	virtual ~run() throw();
 
+#if defined(NRSC_ALLOCATIONS)
+	static void * operator new(size_t n)	{ allocations::note(allocations::runs, n); return ::operator new(n); }
+	static void   operator delete(void * p)	{ ::operator delete(p); }
+#endif
+
 	// Member types
 	using base_t::const_iterator;
 	using base_t::iterator;
@@ -98,6 +113,7 @@ public:
 	using base_t::empty;
 	using base_t::size;
 	size_t span() const;
+	kind_t kind() const;
 
 	// Element access
 	using base_t::front;
@@ -107,6 +123,8 @@ public:
 	using base_t::clear;
 	pointer	open_cluster();
 	run * split(const_iterator position);
+	run * copy() const;
+	void	add_hyphen();
 
 	// Operations
 	bool			fill(TextIterator & ti, TextIndex span);
@@ -115,8 +133,9 @@ public:
 	
 	PMReal			width() const;
 	PMReal			height() const;
+	PMReal			hyphen_width() const;
 
-	IWaxRun		  * wax_run() const;
+	IWaxRun		  * wax_run(glyph_batch & batch) const;
 	IDrawingStyle * get_style() const;
 
 	void calculate_stretch(const glyf::stretch & js, glyf::stretch & s) const;
@@ -135,6 +154,12 @@ size_t run::span() const
 
 }
 
+inline
+run::kind_t run::kind() const
+{
+	return _kind;
+}
+
 inline
 PMReal run::height() const
 {
@@ -0,0 +1,115 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <algorithm>
+// Interface headers
+#include "VCPlugInHeaders.h"
+#include <IComposeScanner.h>
+// Library headers
+// Module header
+#include "StyleRuns.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+
+namespace
+{
+	inline
+	bool ends_before(const TextIndex offset, const style_run & sr)
+	{
+		return offset < sr.end();
+	}
+
+
+	/* Whether shaping can stop after c without changing the glyphs before 
+	it. Tabs and the fixed width spaces already end a segment in run::fill,
+	so cutting there changes nothing. A word space is an assumption: the 
+	fonts tested have no rules that reach across one, but a Graphite font 
+	may, with a kern between a word and the space after it or contextual 
+	forms that look past the space, as Arabic fonts sometimes do. Such a 
+	font can shape a word at the end of a window differently from how the 
+	whole paragraph would shape it, and the headless build cannot check 
+	this as its Graphite stub has no faces. Windowed shaping is only exact 
+	for fonts whose rules stop at word spaces.
+	*/
+	bool ends_segment(UTF32TextChar c)
+	{
+		const uint32 v = c.GetValue();
+		return v == ' ' || v == kTextChar_Tab || (0x2000 <= v && v <= kTextChar_HairSpace);
+	}
+}
+
+
+bool style_runs::build(IComposeScanner & scanner, TextIndex start, TextIndex end)
+{
+	clear();
+
+	TextIndex offset = start;
+	while (offset < end)
+	{
+		style_run	sr;
+		sr.start = offset;
+		sr.span  = 0;
+		sr.style = nil;
+		sr.text  = scanner.QueryDataAt(offset, &sr.style, &sr.span);
+		if (sr.text.IsNull())				break;			// End of story
+		if (sr.style == nil || sr.span <= 0)	return false;	// Problem
+		if (sr.span > end - offset)			sr.span = end - offset;
+
+		push_back(sr);
+		offset += sr.span;
+	}
+
+	_start = start;
+	_end   = offset;
+	return true;
+}
+
+
+style_runs::const_iterator style_runs::find(TextIndex offset) const
+{
+	if (offset < _start)	return end();
+
+	// Find the first run that ends after offset.
+	return std::upper_bound(begin(), end(), offset, ends_before);
+}
+
+
+// The first place at or after pos the paragraph can be cut for shaping,
+// else the end of pos's style run where shaping breaks anyway.
+TextIndex style_runs::segment_end(TextIndex pos, TextIndex end) const
+{
+	const_iterator const sr = find(pos);
+	if (pos >= end || sr == this->end())	return end;
+
+	TextIterator c = sr->text;
+	c += pos - sr->start;
+	for (TextIndex const run_end = std::min(sr->end(), end); pos != run_end; ++pos, ++c)
+		if (ends_segment(*c))	return pos + 1;
+	return std::min(sr->end(), end);
+}
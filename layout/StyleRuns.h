@@ -0,0 +1,124 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <vector>
+// Interface headers
+// Library headers
+#include <textiterator.h>
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+class IComposeScanner;
+class IDrawingStyle;
+// Graphite forward delcarations
+
+namespace nrsc 
+{
+// Project forward declarations
+
+// A single drawing style run and an iterator to its first character.
+struct style_run
+{
+	TextIndex		start;
+	TextIndex		span;
+	IDrawingStyle * style;
+	TextIterator	text;
+
+	TextIndex	end() const;
+};
+
+
+/* style_runs class
+A run length encoded index of the drawing styles covering a range of text, 
+built with one pass over IComposeScanner::QueryDataAt. It stays valid until 
+the text it covers changes, so fill and metric passes can look styles up 
+here rather than going back to the scanner for every style run on every line.
+*/
+class style_runs : private std::vector<style_run>
+{
+	typedef std::vector<style_run>	base_t;
+
+	TextIndex	_start,
+				_end;
+
+public:
+	style_runs();
+
+	// Member types
+	using base_t::const_iterator;
+	using base_t::value_type;
+
+	//Iterators
+	using base_t::begin;
+	using base_t::end;
+
+	// Capacity
+	using base_t::empty;
+	using base_t::size;
+	bool	covers(TextIndex start, TextIndex end) const;
+
+	// Element access
+	const_iterator	find(TextIndex offset) const;
+	TextIndex		segment_end(TextIndex pos, TextIndex end) const;
+
+	// Modifiers
+	bool	build(IComposeScanner & scanner, TextIndex start, TextIndex end);
+	void	clear();
+};
+
+
+inline
+TextIndex style_run::end() const
+{
+	return start + span;
+}
+
+
+inline
+style_runs::style_runs()
+: _start(0),
+  _end(0)
+{
+}
+
+
+inline
+bool style_runs::covers(TextIndex start, TextIndex end) const
+{
+	return !empty() && _start <= start && end <= _end;
+}
+
+
+inline
+void style_runs::clear()
+{
+	base_t::clear();
+	_start = _end = 0;
+}
+
+} // end of namespace nrsc
\ No newline at end of file
@@ -23,11 +23,11 @@ THE SOFTWARE.
 */
 
 // Language headers
+#include <algorithm>
 // Interface headers
 #include "VCPlugInHeaders.h"
-#include <IComposeScanner.h>
 #include <ICompositionStyle.h>
-//#include <IDrawingStyle.h>
+#include <IDrawingStyle.h>
 #include <IFontInstance.h>
 #include <IHierarchy.h>
 #include <IJustificationStyle.h>
@@ -36,13 +36,18 @@ THE SOFTWARE.
 // Library headers
 #include <TabStop.h>
 // Module header
+#include "Allocations.h"
 #include "Box.h"
+#include "Counters.h"
 #include "FallbackRun.h"
 #include "GraphiteRun.h"
 #include "GrFaceCache.h"
+#include "Hyphenator.h"
 #include "InlineObjectRun.h"
 #include "Run.h"
+#include "StyleRuns.h"
 #include "Tile.h"
+#include "Trace.h"
 
 // Forward declarations
 // InDesign interfaces
@@ -122,6 +127,43 @@ namespace
 	}
 
 
+	// How many characters before text continue the word it is in.
+	TextIndex word_lead(TextIterator text)
+	{
+		TextIndex n = 0;
+		for (text += -1; !text.IsNull() && hyphenator::word_char(*text); text += -1)
+			++n;
+		return n;
+	}
+
+
+	// Append the word characters from text on to word.
+	void append_word(TextIterator text, hyphenator::word_t & word)
+	{
+		for (; !text.IsNull() && hyphenator::word_char(*text); ++text)
+			word.push_back(UTF16TextChar((*text).GetValue()));
+	}
+
+
+	// The clusters of a word, by the offset into it of each one's last 
+	// character.
+	typedef std::vector<std::pair<size_t, cluster *> >	word_ends;
+
+	void mark_hyphens(const hyphenator & h, const hyphenator::word_t & word, const word_ends & ends)
+	{
+		hyphenator::points_t points;
+		h.hyphenate(&word[0], word.size(), points);
+
+		word_ends::const_iterator e = ends.begin(), e_e = ends.end();
+		for (hyphenator::points_t::const_iterator p = points.begin(), p_e = points.end(); p != p_e; ++p)
+		{
+			for (; e != e_e && e->first < *p; ++e);
+			if (e != e_e && e->first == *p && e->second->break_penalty() > cluster::penalty::hyphen)
+				e->second->break_penalty() = cluster::penalty::hyphen;
+		}
+	}
+
+
 	PageType get_page_type(const IParagraphComposer::RebuildHelper & helper)
 	{
 		InterfacePtr<IHierarchy> hierarchy(helper.GetDataBase(), helper.GetParcelFrameUID(), UseDefaultIID());
@@ -140,23 +182,36 @@ void tile::clear()
 }
 
 
-tile::~tile()
+tile::~tile() throw()
 {
 	clear();
 }
 
 
-bool tile::fill_by_span(IComposeScanner & scanner, gr_face_cache & faces, TextIndex offset, TextIndex span)
+void tile::move_runs(const_iterator first, tile & rest)
 {
-	TextIndex	total_span = 0;
+	iterator const i = begin() + (first - begin());
+
+	rest.insert(rest.end(), i, end());
+	erase(i, end());
+}
+
+
+bool tile::fill_by_span(const style_runs & styles, gr_face_cache & faces, TextIndex offset, TextIndex span)
+{
+	NRSC_TRACE_SCOPE("tile::fill_by_span");
+	NRSC_ALLOC_PHASE(fill);
+	style_runs::const_iterator	sr = styles.find(offset);
 
 	do
 	{
-		IDrawingStyle * ds = nil;
-		TextIndex		run_span = 0;
-		TextIterator	ti = scanner.QueryDataAt(offset, &ds, &run_span);
-		if (ti.IsNull())		return true;	// End of line
-		if (ds == nil)			return false;	// Problem
+		for (; sr != styles.end() && sr->end() <= offset; ++sr);
+		if (sr == styles.end())	return true;	// End of line
+
+		IDrawingStyle * ds = sr->style;
+		TextIndex		run_span = sr->end() - offset;
+		TextIterator	ti = sr->text;
+		ti += offset - sr->start;
 		if (run_span > span)	run_span = span;
 
 		do
@@ -167,6 +222,7 @@ bool tile::fill_by_span(IComposeScanner & scanner, gr_face_cache & faces, TextIn
 			r->apply_desired_widths();
 
 			const size_t consumed = r->span();
+			NRSC_COUNT_N(fill_chars, consumed);
 			run_span -= consumed;
 			span	 -= consumed;
 			offset	 += consumed;
@@ -177,6 +233,26 @@ bool tile::fill_by_span(IComposeScanner & scanner, gr_face_cache & faces, TextIn
 }
 
 
+// Append all of another tile's runs, as if this tile had filled them.
+void tile::take_runs(tile & from)
+{
+	from.move_runs(from.begin(), *this);
+}
+
+
+// Take whole runs from the front of from until this is at least width wide.
+void tile::take_runs(tile & from, const PMReal & width)
+{
+	PMReal		w = content_dimensions().X();
+	iterator	r = from.begin();
+	for (iterator const r_e = from.end(); r != r_e && w < width; ++r)
+		w += (*r)->width();
+
+	insert(end(), from.begin(), r);
+	from.erase(from.begin(), r);
+}
+
+
 size_t tile::span() const 
 {
 	size_t s = 0;
@@ -267,8 +343,11 @@ void tile::get_stretch_ratios(glyf::stretch & s) const
 }
 
 
-void tile::break_into(tile & rest, cluster::penalty::type const max_penalty)
+// Break as though the tile were only width wide, keeping its region.
+void tile::break_into(tile & rest, cluster::penalty::type const max_penalty, const PMReal & width)
 {
+	NRSC_TRACE_SCOPE("tile::break_into");
+	NRSC_ALLOC_PHASE(line_break);
 	if (empty()) return;
 
 	glyf::stretch js, s = {{0,0},{0,0},{0,0},{0,0},{0,0}};
@@ -276,7 +355,11 @@ void tile::break_into(tile & rest, cluster::penalty::type const max_penalty)
 
 	PMReal			advance = 0,
 					whitespace_advance = 0;
-	PMReal const	desired = _region.Width();
+	PMReal const	desired = width;
+
+	// Clusters that can never be broken after only need checking for 
+	// overflow while a break no worse than one of them has been found.
+	float const		never_demerits = demerits(0, cluster::penalty::never);
 
 	break_point	best = *this;
 	for (iterator r = begin(), r_e = end(); r != r_e; ++r)
@@ -292,6 +375,7 @@ void tile::break_into(tile & rest, cluster::penalty::type const max_penalty)
 		}
 		
 		PMReal const	space_width = (*r)->get_style()->GetSpaceWidth();
+		PMReal			hyphen_width = -1;
 		for (run::iterator cl = (*r)->begin(), cl_e = (*r)->end(); cl != cl_e; ++cl)
 		{
 			bool const is_whitespace = cl->whitespace();
@@ -306,14 +390,32 @@ void tile::break_into(tile & rest, cluster::penalty::type const max_penalty)
 
 			const PMReal stretch = desired_adj - advance;
 			const float ts = total_stretch(stretch > 0, s),
-						b = std::min(badness(stretch/ts), 1.0f),
-						d = demerits(b, cl->break_penalty());
+						b = std::min(badness(stretch/ts), 1.0f);
 			if (b < -1)
 			{
 				r = r_e; --r;
 				break;
 			}
-			best.improve(r,cl,d);
+
+			// A cluster that is not a break opportunity can only improve on 
+			// the best break while that is no better than a never break, or 
+			// if its badness is undefined.
+			if (cl->break_penalty() == cluster::penalty::never && best.demerits < never_demerits && b == b)
+				continue;
+
+			// Breaking at a hyphen sets one, so rate it with that much less 
+			// stretch and pass it over if the hyphen would overflow.
+			float b_break = b;
+			if (cl->break_penalty() == cluster::penalty::hyphen)
+			{
+				if (hyphen_width < 0)	hyphen_width = (*r)->hyphen_width();
+				const PMReal hyphen_stretch = stretch - hyphen_width;
+				b_break = std::min(badness(hyphen_stretch/total_stretch(hyphen_stretch > 0, s)), 1.0f);
+				if (b_break < -1)	continue;
+			}
+
+			NRSC_COUNT(break_candidates);
+			best.improve(r, cl, demerits(b_break, cl->break_penalty()));
 		}
 	}
 	
@@ -321,7 +423,7 @@ void tile::break_into(tile & rest, cluster::penalty::type const max_penalty)
 	// exceeded we can't break here.
 	if (best.cluster->break_penalty() > max_penalty)
 	{
-		rest.splice(rest.end(), *this, begin(), end());
+		move_runs(begin(), rest);
 		return;
 	}
 
@@ -338,7 +440,7 @@ void tile::break_into(tile & rest, cluster::penalty::type const max_penalty)
 
 	if (best.cluster != (*best.run)->end())
 		rest.push_back((*best.run)->split(best.cluster));
-	rest.splice(rest.end(), *this, ++best.run, end());
+	move_runs(++best.run, rest);
 }
 
 
@@ -361,7 +463,7 @@ void tile::break_drop_caps(PMReal scale, int elems, tile & rest)
 
 		if (elems == 0)
 		{
-			rest.splice(rest.end(), *this, ++r, end());
+			move_runs(++r, rest);
 			rest._region.Left() = _region.Right() = _region.Left() + content_dimensions().X()*scale;
 			break;
 		}
@@ -369,6 +471,63 @@ void tile::break_drop_caps(PMReal scale, int elems, tile & rest)
 }
 
 
+/* Make each cluster that ends where h would hyphenate a word, and is all 
+word characters, a hyphen break opportunity. text is at the tile's first 
+character, words the tile starts or ends inside are read whole from it, so
+hyphenating any tile of a paragraph marks the same points.
+*/
+void tile::hyphenate(const hyphenator & h, TextIterator text)
+{
+	NRSC_TRACE_SCOPE("tile::hyphenate");
+	hyphenator::word_t	word;
+	word_ends			ends;
+
+	TextIterator lead = text;
+	lead += -word_lead(text);
+	for (; lead != text; ++lead)
+		word.push_back(UTF16TextChar((*lead).GetValue()));
+
+	for (iterator r = begin(), r_e = end(); r != r_e; ++r)
+	{
+		for (run::iterator cl = (*r)->begin(), cl_e = (*r)->end(); cl != cl_e; ++cl)
+		{
+			size_t const	n = word.size();
+			bool			letters = true;
+			for (size_t c = cl->span(); c; --c, ++text)
+			{
+				letters = letters && hyphenator::word_char(*text);
+				word.push_back(UTF16TextChar((*text).GetValue()));
+			}
+			if (letters)
+			{
+				ends.push_back(std::make_pair(word.size() - 1, &*cl));
+				continue;
+			}
+
+			word.resize(n);
+			if (!ends.empty())
+				mark_hyphens(h, word, ends);
+			word.clear();
+			ends.clear();
+		}
+	}
+	if (ends.empty())	return;
+
+	// Finish the word the tile ends inside.
+	append_word(text, word);
+	mark_hyphens(h, word, ends);
+}
+
+
+/* Whether the tile's last cluster is a hyphen break, as hyphenate marks 
+them, so breaking after it sets a hyphen.
+*/
+bool tile::ends_at_hyphen() const
+{
+	return !empty() && !back()->empty() && back()->back().break_penalty() == cluster::penalty::hyphen;
+}
+
+
 void tile::justify(bool ragged)
 {
 	glyf::stretch js, s = {{0,0},{0,0},{0,0},{0,0},{0,0}};
@@ -473,6 +632,8 @@ void tile::apply_tab_widths()
 
 PMReal tile::align_text(const IParagraphComposer::RebuildHelper & helper, IJustificationStyle * js, ICompositionStyle * cs)
 {
+	NRSC_TRACE_SCOPE("tile::align_text");
+	NRSC_ALLOC_PHASE(justify);
 	if (empty()) return 0;
 
 	run & last_run = *back();
@@ -25,16 +25,17 @@ THE SOFTWARE.
 #pragma once
 
 // Language headers
-#include <list>
+#include <vector>
 // Interface headers
 #include <IParagraphComposer.h>
 // Library headers
+#include <textiterator.h>
 // Module header
+#include "Allocations.h"
 #include "Box.h"
 
 // Forward declarations
 // InDesign interfaces
-class IComposeScanner;
 class ICompositionStyle;
 class IDrawingStyle;
 class IJustificationStyle;
@@ -44,19 +45,22 @@ namespace nrsc
 {
 // Project forward declarations
 class	gr_face_cache;
+class	hyphenator;
 struct	line_metrics;
 class	run;
+class	style_runs;
 
-class tile : private std::list<run*>
+class tile : private std::vector<run*, allocations::allocator<run*, allocations::tiles>::type>
 {
-	typedef std::list<run*>	base_t;
+	typedef std::vector<run*, allocations::allocator<run*, allocations::tiles>::type>	base_t;
 
-	PMRect	_region;
+	PMRect		_region;
 
 	// disable the assignment operator.
 	tile &	operator = (const tile &);
 
 	static run    * create_run(gr_face_cache & faces, IDrawingStyle * ds, TextIterator & ti, TextIndex span);
+	void			move_runs(const_iterator first, tile & rest);
 
 public:
 	tile();
@@ -88,16 +92,20 @@ public:
 	using base_t::back;
 
 	// Modifiers
-	using base_t::push_front;
 	using base_t::push_back;
 	void	clear();
-	bool	fill_by_span(IComposeScanner & scanner, gr_face_cache & faces, TextIndex offset, TextIndex span);
+	bool	fill_by_span(const style_runs & styles, gr_face_cache & faces, TextIndex offset, TextIndex span);
+	void	take_runs(tile & from);
+	void	take_runs(tile & from, const PMReal & width);
 
 	// Operations
 	void	justify(bool ragged);
 	void	apply_tab_widths();
+	void	hyphenate(const hyphenator & h, TextIterator text);
+	bool	ends_at_hyphen() const;
 	PMReal	align_text(const IParagraphComposer::RebuildHelper & helper, IJustificationStyle * js, ICompositionStyle *);
 	void	break_into(tile & rest, cluster::penalty::type const max_penalty = cluster::penalty::clip);
+	void	break_into(tile & rest, cluster::penalty::type const max_penalty, const PMReal & width);
 	void	break_drop_caps(PMReal scale, int elems, tile &);
 	void	get_stretch_ratios(glyf::stretch & js) const;
 };
@@ -130,4 +138,12 @@ PMPoint	tile::dimensions() const
 	return _region.Dimensions();
 }
 
+
+inline
+void tile::break_into(tile & rest, cluster::penalty::type const max_penalty)
+{
+	break_into(rest, max_penalty, _region.Width());
+}
+
+
 } // end of namespace nrsc
\ No newline at end of file
@@ -26,6 +26,7 @@ THE SOFTWARE.
 // Interface headers
 #include "VCPlugInHeaders.h"
 #include <IComposeScanner.h>
+#include <ICompositionStyle.h>
 #include <IDrawingStyle.h>
 #include <IParcel.h>
 #include <IPMFont.h>
@@ -34,8 +35,11 @@ THE SOFTWARE.
 #include <IWaxLine.h>
 // Library headers
 // Module header
+#include "Counters.h"
 #include "Line.h"
+#include "Recorder.h"
 #include "Tiler.h"
+#include "Trace.h"
 
 // Forward declarations
 // InDesign interfaces
@@ -94,8 +98,11 @@ const PMReal tiler::GRID_ALIGNMENT_OFFSET = 0;
 
 tiler::tiler(IParagraphComposer::RecomposeHelper & helper)
 : _helper(helper),
-  _height(0.0),
+  _para_style(nil),
+  _para_start(helper.GetParagraphStart()),
+  _para_end(helper.GetParagraphEnd()),
   _parcel_key(helper.GetStartingParcelKey()),
+  _height(0.0),
   _TOP_height(0.0),
   _TOP_height_metric(_parcel_key.IsValid() 
 						? helper.GetTextParcelList()->GetFirstLineOffsetMetric(_parcel_key) 
@@ -110,12 +117,13 @@ tiler::tiler(IParagraphComposer::RecomposeHelper & helper)
   _left_margin(0.0),
   _right_margin(0.0)
 {
-	IComposeScanner	* const scanner = _helper.GetComposeScanner();
-	InterfacePtr<ICompositionStyle> cs(scanner->GetParagraphStyleAt(_helper.GetStartingTextIndex()), UseDefaultIID());
+	InterfacePtr<ICompositionStyle> cs(paragraph_style(_helper.GetStartingTextIndex()), UseDefaultIID());
 	
 	int16 drop_lines = 0;
 	cs->GetDropCapInfo(&_drop_elems, &drop_lines);
 	_drop_lines = drop_lines;
+
+	NRSC_RECORD(recompose(helper));
 }
 
 
@@ -124,24 +132,79 @@ tiler::~tiler(void)
 }
 
 
+tiler::checkpoint tiler::save() const
+{
+	checkpoint cp;
+	cp.parcel_key = _parcel_key;
+	cp.height = _height;
+	cp.TOP_height = _TOP_height;
+	cp.y_offset = _y_offset;
+	cp.drop_indent = _drop_indent;
+	cp.left_margin = _left_margin;
+	cp.right_margin = _right_margin;
+	cp.TOP_height_metric = _TOP_height_metric;
+	cp.grid_alignment_metric = _grid_alignment_metric;
+	cp.at_TOP = _at_TOP;
+	cp.parcel_pos_dependent = _parcel_pos_dependent;
+	cp.drop_lines = _drop_lines;
+	cp.drop_elems = _drop_elems;
+	return cp;
+}
+
+
+void tiler::restore(const checkpoint & cp)
+{
+	_parcel_key = cp.parcel_key;
+	_height = cp.height;
+	_TOP_height = cp.TOP_height;
+	_y_offset = _y_offset_original = cp.y_offset;
+	_drop_indent = cp.drop_indent;
+	_left_margin = cp.left_margin;
+	_right_margin = cp.right_margin;
+	_TOP_height_metric = cp.TOP_height_metric;
+	_grid_alignment_metric = cp.grid_alignment_metric;
+	_at_TOP = cp.at_TOP;
+	_parcel_pos_dependent = cp.parcel_pos_dependent;
+	_drop_lines = cp.drop_lines;
+	_drop_elems = cp.drop_elems;
+}
+
+
+IDrawingStyle * tiler::paragraph_style(TextIndex curr_pos)
+{
+	// The paragraph style only changes at paragraph boundaries so only go 
+	// back to the scanner for positions outside the current paragraph.
+	const bool in_paragraph = _para_start <= curr_pos && curr_pos < _para_end;
+	if (in_paragraph && _para_style != nil)
+		return _para_style;
+
+	IDrawingStyle * const ds = _helper.GetComposeScanner()->GetParagraphStyleAt(curr_pos);
+	if (in_paragraph)
+		_para_style = ds;
+
+	return ds;
+}
+
+
 bool tiler::next_line(TextIndex curr_pos, line_metrics const & lm, line & ln)
 {
-	IComposeScanner	* const scanner = _helper.GetComposeScanner();
+	NRSC_TRACE_SCOPE("tiler::next_line");
 	IWaxLine const * 		pwl = _helper.GetPreviousWaxLine();
-	InterfacePtr<ICompositionStyle> cs(scanner->GetParagraphStyleAt(curr_pos), UseDefaultIID());
+	InterfacePtr<ICompositionStyle> cs(paragraph_style(curr_pos), UseDefaultIID());
 	InterfacePtr<IGridRelatedStyle> grs(cs, UseDefaultIID());
 
 	ln.clear();
 
 	if (cs == nil || grs == nil)	return false;
 
-	if (pwl && pwl->GetNextLineAffectedByDropcap())
+	// A drop cap only hangs over lines of its own paragraph.
+	const bool first_line = curr_pos == _helper.GetParagraphStart();
+	if (pwl && pwl->GetNextLineAffectedByDropcap() && !first_line)
 	{
 		pwl->GetDropCapIndents(&_drop_indent, &_drop_lines);
 		--_drop_lines;
 	}
 
-	const bool first_line = curr_pos == _helper.GetParagraphStart();
 	_height = lm.leading;
 	_y_offset_original = _y_offset;
 	_grid_alignment_metric = (grs->GetAlignOnlyFirstLine() == kFalse || first_line) 
@@ -201,25 +264,32 @@ bool tiler::get_line_tiles(PMReal min_width, PMReal indent_left, PMReal indent_r
 
 bool tiler::try_get_tiles(PMReal min_width, line_metrics const & line, TextIndex curr_pos, PMRectCollection & tiles)
 {
-	return _helper.GetTiles(min_width,
-						   line.leading,
-						   line[_TOP_height_metric],
-						   _grid_alignment_metric,	// Grid alignment metric
-						   GRID_ALIGNMENT_OFFSET,	// No offset adjustment 
-						   Text::kRomanLeadingModel,// Leading model
-						   line.leading,
-						   0.0,						// Leading model offset
-						   line.leading - line.cap_height,
-						   curr_pos,
-						   _drop_lines <= 1,		//affectedByVerticalJust.
-						   &_parcel_key,
-						   &_y_offset, 
-						   &_TOP_height_metric,
-						   tiles,
-						   &_at_TOP,
-						   &_parcel_pos_dependent,
-						   &_left_margin,
-						   &_right_margin);	
+#if defined(NRSC_RECORDER)
+	const PMReal y_in = _y_offset, 
+				 TOF_height = line[_TOP_height_metric];
+#endif
+	const bool16 found = _helper.GetTiles(min_width,
+										  line.leading,
+										  line[_TOP_height_metric],
+										  _grid_alignment_metric,	// Grid alignment metric
+										  GRID_ALIGNMENT_OFFSET,	// No offset adjustment 
+										  Text::kRomanLeadingModel,// Leading model
+										  line.leading,
+										  0.0,						// Leading model offset
+										  line.leading - line.cap_height,
+										  curr_pos,
+										  _drop_lines <= 1,		//affectedByVerticalJust.
+										  &_parcel_key,
+										  &_y_offset, 
+										  &_TOP_height_metric,
+										  tiles,
+										  &_at_TOP,
+										  &_parcel_pos_dependent,
+										  &_left_margin,
+										  &_right_margin);	
+	NRSC_RECORD(tiles(min_width, line.leading, TOF_height, curr_pos, y_in, found, _y_offset, 
+					  _TOP_height_metric, tiles, _at_TOP, _parcel_pos_dependent, _left_margin, _right_margin));
+	return found;
 }
 
 
@@ -239,11 +309,20 @@ void tiler::setup_wax_line(IWaxLine * wl, line_metrics & metrics) const
 }
 
 
+void tiler::restart_line()
+{
+	_y_offset = _y_offset_original;
+}
+
+
 bool  tiler::need_retry_line(const line_metrics &lm)
 {
 	const bool retry = lm.leading > _height || (_at_TOP && lm[_TOP_height_metric] > _TOP_height);
 	if (retry)
+	{
+		NRSC_COUNT(line_retries);
 		_y_offset = _y_offset_original;
+	}
 
 	return retry;
 }
@@ -44,6 +44,8 @@ class line;
 struct line_metrics
 {
 	line_metrics(const IDrawingStyle * ds = nil);
+	line_metrics(const line_metrics & rhs);
+	line_metrics & operator = (const line_metrics & rhs);
 
 	PMReal	leading,
 			ascent,
@@ -69,15 +71,44 @@ line_metrics::line_metrics(const IDrawingStyle * ds)
   cap_height(0.0),
   em_box_height(0.0),
   x_height(0.0),
-  fixed_height(ascent),		// Fixed height and ascent are the same since ID takes care of this
   em_box_depth(0.0),
   icf_bottom_inset(0.0),
-  icf_top_inset(0.0)
+  icf_top_inset(0.0),
+  fixed_height(ascent)		// Fixed height and ascent are the same since ID takes care of this
 {
 	if (ds != nil)
 		this->operator += (ds);
 }
 
+// fixed_height must refer to this object's ascent, not the copied one's.
+inline
+line_metrics::line_metrics(const line_metrics & rhs)
+: leading(rhs.leading),
+  ascent(rhs.ascent),
+  cap_height(rhs.cap_height),
+  em_box_height(rhs.em_box_height),
+  x_height(rhs.x_height),
+  em_box_depth(rhs.em_box_depth),
+  icf_bottom_inset(rhs.icf_bottom_inset),
+  icf_top_inset(rhs.icf_top_inset),
+  fixed_height(ascent)
+{
+}
+
+inline
+line_metrics & line_metrics::operator = (const line_metrics & rhs)
+{
+	leading			 = rhs.leading;
+	ascent			 = rhs.ascent;
+	cap_height		 = rhs.cap_height;
+	em_box_height	 = rhs.em_box_height;
+	x_height		 = rhs.x_height;
+	em_box_depth	 = rhs.em_box_depth;
+	icf_bottom_inset = rhs.icf_bottom_inset;
+	icf_top_inset	 = rhs.icf_top_inset;
+	return *this;
+}
+
 inline
 PMReal & line_metrics::operator [](int k)
 {
@@ -113,14 +144,42 @@ class tiler
 {
 	static const PMReal GRID_ALIGNMENT_OFFSET;
 public:
+	/** The state a tiler carries from one line of a paragraph to the next, 
+		saved at a line start so a new tiler can resume composing there 
+		instead of walking down from the paragraph's first line. Plain data, 
+		so it can be copied or written out as it is.
+	*/
+	struct checkpoint
+	{
+		ParcelKey					parcel_key;
+		PMReal						height,
+									TOP_height,
+									y_offset,
+									drop_indent,
+									left_margin,
+									right_margin;
+		Text::FirstLineOffsetMetric TOP_height_metric;
+		Text::GridAlignmentMetric	grid_alignment_metric;
+		bool16						at_TOP,
+									parcel_pos_dependent;
+		int32						drop_lines;
+		int16						drop_elems;
+	};
+
 	tiler(IParagraphComposer::RecomposeHelper & helper);
 	~tiler(void);
 
+	checkpoint	save() const;
+	// Resume from a checkpoint saved at the helper's starting text index.
+	void		restore(const checkpoint & cp);
+
 	bool	next_line(TextIndex curr_pos, line_metrics const & lm, line & ln);
 
 	const ParcelKey			& parcel() const;
 
 	bool	need_retry_line(const line_metrics &);
+	// Undo the last next_line's move down the parcel.
+	void	restart_line();
 	void	setup_wax_line(IWaxLine * wl, line_metrics & metrics) const;
 
 	int		drop_lines() const;
@@ -131,8 +190,13 @@ private:
 	bool try_get_tiles(PMReal min_width, line_metrics const & lm, TextIndex curr_pos, PMRectCollection &);
 	bool get_line_tiles(PMReal min_width, PMReal indent_left, PMReal indent_right, line_metrics const & lm, TextIndex curr_pos, line & ln);
 	bool get_grid_alignment_metric();
+	IDrawingStyle * paragraph_style(TextIndex curr_pos);
 
 	IParagraphComposer::RecomposeHelper & _helper;
+	// Paragraph style for the paragraph being composed.
+	IDrawingStyle			  * _para_style;
+	TextIndex					_para_start,
+								_para_end;
 	// Updateable state from IParagraphComposer::Tiler::GetTiles
 	ParcelKey					_parcel_key;
 	PMReal						_height;
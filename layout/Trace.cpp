@@ -0,0 +1,186 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+// Language headers
+#include <atomic>
+#include <ostream>
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+// Interface headers
+// Library headers
+// Module header
+#include "Trace.h"
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+using namespace nrsc;
+
+namespace
+{
+	struct span
+	{
+		const char *	name;
+		trace::ticks_t	begin,
+						end;
+	};
+
+	/* A single writer ring of spans. Only the thread leasing it writes, 
+	publishing each span with a release store of the count, and exporting 
+	reads the spans an acquire load of the count covers. A thread hands 
+	its buffer back when it exits and the next new thread takes it over, 
+	carrying on its tid, so threads that come and go with each compose 
+	reuse the buffers of those gone before.
+	*/
+	struct buffer
+	{
+		static const size_t	capacity = 1 << 16;
+
+		span				spans[capacity];
+		std::atomic<size_t>	count;
+		std::atomic<bool>	leased;
+		unsigned int		tid;
+		buffer			  *	next;
+	};
+
+	std::atomic<buffer *>		buffers(0);
+	std::atomic<unsigned int>	last_tid(0);
+
+
+	// Hands the thread's buffer back when the thread exits.
+	struct lease
+	{
+		buffer * b;
+
+		lease() : b(0) {}
+		~lease()	{ if (b) b->leased.store(false, std::memory_order_release); }
+	};
+
+	thread_local lease	this_thread;
+
+
+	buffer * thread_buffer()
+	{
+		if (this_thread.b)	return this_thread.b;
+
+		// Take over a buffer an exited thread handed back, else add one.
+		for (buffer * b = buffers.load(std::memory_order_acquire); b; b = b->next)
+		{
+			bool idle = false;
+			if (b->leased.compare_exchange_strong(idle, true, std::memory_order_acquire))
+				return this_thread.b = b;
+		}
+
+		buffer * const b = new buffer();
+		b->count.store(0, std::memory_order_relaxed);
+		b->leased.store(true, std::memory_order_relaxed);
+		b->tid  = ++last_tid;
+		b->next = buffers.load(std::memory_order_relaxed);
+		while (!buffers.compare_exchange_weak(b->next, b, std::memory_order_release, std::memory_order_relaxed))
+			;
+
+		return this_thread.b = b;
+	}
+}
+
+
+trace::ticks_t trace::now()
+{
+#if defined(_WIN32)
+	static LARGE_INTEGER frequency = {0};
+	if (frequency.QuadPart == 0)	QueryPerformanceFrequency(&frequency);
+	LARGE_INTEGER t;
+	QueryPerformanceCounter(&t);
+	return ticks_t(t.QuadPart/double(frequency.QuadPart)*1e9);
+#elif defined(__APPLE__)
+	static mach_timebase_info_data_t timebase = {0, 0};
+	if (timebase.denom == 0)	mach_timebase_info(&timebase);
+	return mach_absolute_time()*timebase.numer/timebase.denom;
+#else
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return ticks_t(t.tv_sec)*1000000000u + t.tv_nsec;
+#endif
+}
+
+
+void trace::record(const char * name, ticks_t begin, ticks_t end)
+{
+	buffer * const b = thread_buffer();
+	const size_t n = b->count.load(std::memory_order_relaxed);
+	span & s = b->spans[n % buffer::capacity];
+	s.name  = name;
+	s.begin = begin;
+	s.end   = end;
+	b->count.store(n + 1, std::memory_order_release);
+}
+
+
+void trace::export_chrome_json(std::ostream & out)
+{
+	const std::streamsize precision = out.precision(3);
+	const std::ios::fmtflags flags = out.setf(std::ios::fixed, std::ios::floatfield);
+
+	buffer * const head = buffers.load(std::memory_order_acquire);
+	ticks_t origin = ~ticks_t(0);
+	for (buffer * b = head; b; b = b->next)
+	{
+		const size_t n = b->count.load(std::memory_order_acquire), first = n > buffer::capacity ? n - buffer::capacity : 0;
+		for (size_t i = first; i != n; ++i)
+			if (b->spans[i % buffer::capacity].begin < origin)
+				origin = b->spans[i % buffer::capacity].begin;
+	}
+
+	// Timestamps and durations are in microseconds.
+	bool first_event = true;
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	for (buffer * b = head; b; b = b->next)
+	{
+		const size_t n = b->count.load(std::memory_order_acquire), first = n > buffer::capacity ? n - buffer::capacity : 0;
+		for (size_t i = first; i != n; ++i, first_event = false)
+		{
+			const span & s = b->spans[i % buffer::capacity];
+			out << (first_event ? "\n" : ",\n")
+				<< "{\"name\":\"" << s.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+				<< ",\"ts\":" << (s.begin - origin)/1000.0 << ",\"dur\":" << (s.end - s.begin)/1000.0 << '}';
+		}
+	}
+	out << "\n]}\n";
+
+	out.precision(precision);
+	out.flags(flags);
+}
+
+
+void trace::clear()
+{
+	for (buffer * b = buffers.load(std::memory_order_acquire); b; b = b->next)
+		b->count.store(0, std::memory_order_release);
+}
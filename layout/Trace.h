@@ -0,0 +1,105 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2013 SIL International
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+// Language headers
+#include <cstddef>
+#include <iosfwd>
+// Interface headers
+// Library headers
+// Module header
+
+// Forward declarations
+// InDesign interfaces
+// Graphite forward delcarations
+// Project forward declarations
+
+/* Scoped timing spans for the composer.
+When NRSC_TRACE is defined NRSC_TRACE_SCOPE records the time spent in the 
+enclosing scope into a ring buffer owned by the calling thread, otherwise 
+it expands to nothing. Recording takes no locks; a thread takes a buffer 
+on first use, one handed back by a thread that has exited or else a new 
+one registered with a compare and swap, so there are only ever as many 
+buffers as threads tracing at once. The spans can be 
+exported as Chrome trace event JSON, which chrome://tracing and Perfetto 
+load, once the composing threads are idle.
+*/
+#if defined(NRSC_TRACE)
+#define NRSC_TRACE_SCOPE(name)	nrsc::trace::scope const nrsc_trace_scope_(name)
+#else
+#define NRSC_TRACE_SCOPE(name)	((void)0)
+#endif
+
+namespace nrsc 
+{
+namespace trace
+{
+	typedef unsigned long long	ticks_t;
+
+	// Nanoseconds from an arbitrary fixed point.
+	ticks_t	now();
+
+	void	record(const char * name, ticks_t begin, ticks_t end);
+
+	/** Write every recorded span as Chrome trace event JSON. Each thread's 
+		buffer keeps its most recent spans once it wraps.
+	*/
+	void	export_chrome_json(std::ostream & out);
+
+	/** Discard all recorded spans.
+	*/
+	void	clear();
+
+
+	class scope
+	{
+		const char * const	_name;
+		ticks_t const		_begin;
+
+		// Hide copy constructor and assignment operator.
+		scope(const scope &);
+		scope & operator = (const scope &);
+
+	public:
+		explicit scope(const char * name);
+		~scope();
+	};
+
+
+	inline
+	scope::scope(const char * name)
+	: _name(name), 
+	  _begin(now())
+	{
+	}
+
+	inline
+	scope::~scope()
+	{
+		record(_name, _begin, now());
+	}
+}
+
+} // end of namespace nrsc
\ No newline at end of file